@@ -143,6 +143,14 @@ int main(int argc, char *argv[]) {
 		::scheme::search::HackPackOpts packopts;
 		packopts.pack_n_iters         = opt.pack_n_iters;
 		packopts.pack_iter_mult       = opt.pack_iter_mult;
+		packopts.dee_prune            = opt.pack_dee_prune;
+		packopts.exact_max_treewidth  = opt.pack_exact_max_treewidth;
+		packopts.exact_max_work       = opt.pack_exact_max_work;
+		packopts.pt_nreplicas         = opt.pack_pt_nreplicas;
+		packopts.pt_rounds            = opt.pack_pt_rounds;
+		packopts.pt_swap_interval     = opt.pack_pt_swap_interval;
+		packopts.pt_temp_max          = opt.pack_pt_temp_max;
+		packopts.pt_temp_min          = opt.pack_pt_temp_min;
 		packopts.hbond_weight         = opt.hbond_weight;
 		packopts.upweight_iface       = opt.upweight_iface;
 		packopts.upweight_multi_hbond = opt.upweight_multi_hbond;
@@ -262,6 +270,11 @@ int main(int argc, char *argv[]) {
 		make2bopts.distance_cut = 15.0;
 		make2bopts.hbond_weight = packopts.hbond_weight;
 		make2bopts.favorable_2body_multiplier = opt.favorable_2body_multiplier;
+		make2bopts.compact_int16 = opt.twobody_int16;
+		make2bopts.lazy = opt.twobody_lazy;
+		if( make2bopts.lazy && make2bopts.compact_int16 ){
+			utility_exit_with_message( "-rif_dock:twobody_int16 needs compact two-body tables, which -rif_dock:twobody_lazy never builds. Use one or the other" );
+		}
 
 
 
@@ -1108,22 +1121,31 @@ int main(int argc, char *argv[]) {
 					task_list.push_back(make_shared<DiversifyByNestTask>( 0 ));
 
 					task_list.push_back(make_shared<HSearchInit>( ));
+					// the last stage keeps every scored point, so it is never fused
+					bool const fused = opt.hsearch_fused_stages && ! opt.hack_pack_during_hsearch;
 					for ( int i = 0; i <= final_resl; i++ ) {
-						task_list.push_back(make_shared<HSearchScoreAtReslTask>( i, i, opt.tether_to_input_position_cut ));
+						if ( ! fused || i == 0 || i == final_resl ) {
+							uint64_t num_to_select = 0;
+							if ( opt.hsearch_select_while_scoring && ! opt.hack_pack_during_hsearch ) num_to_select = opt.beam_size / opt.DIMPOW2;
+							task_list.push_back(make_shared<HSearchScoreAtReslTask>( i, i, opt.tether_to_input_position_cut, num_to_select ));
+
+							if (opt.hack_pack_during_hsearch) {
+								task_list.push_back(make_shared<SortByScoreTask>( ));
+								task_list.push_back(make_shared<FilterForHackPackTask>( 1, rdd.packopts.pack_n_iters, rdd.packopts.pack_iter_mult ));
+								task_list.push_back(make_shared<HackPackTask>( i, i, opt.global_score_cut )); 
+							}
 
-						if (opt.hack_pack_during_hsearch) {
-							task_list.push_back(make_shared<SortByScoreTask>( ));
-							task_list.push_back(make_shared<FilterForHackPackTask>( 1, rdd.packopts.pack_n_iters, rdd.packopts.pack_iter_mult ));
-							task_list.push_back(make_shared<HackPackTask>( i, i, opt.global_score_cut )); 
+							task_list.push_back(make_shared<HSearchFilterSortTask>( i, opt.beam_size / opt.DIMPOW2, opt.global_score_cut, i < final_resl ));
 						}
 
-						task_list.push_back(make_shared<HSearchFilterSortTask>( i, opt.beam_size / opt.DIMPOW2, opt.global_score_cut, i < final_resl ));
-
 						if (opt.dump_x_frames_per_resl > 0) {
 							task_list.push_back(make_shared<DumpHSearchFramesTask>( i, i, opt.dump_x_frames_per_resl, opt.dump_only_best_frames, opt.dump_only_best_stride, 
 								                                                    opt.dump_prefix + "_" + test_data_cache->scafftag + boost::str(boost::format("_resl%i")%i) ));
 						}
-						if ( i < final_resl ) {
+						if ( fused && i+1 < final_resl ) {
+							task_list.push_back(make_shared<HSearchFusedStageTask>( i, i+1, opt.DIMPOW2, opt.beam_size / opt.DIMPOW2,
+								                                                    opt.global_score_cut, opt.tether_to_input_position_cut ));
+						} else if ( i < final_resl ) {
 							task_list.push_back(make_shared<HSearchScaleToReslTask>( i, i+1, opt.DIMPOW2, opt.global_score_cut )); 
 						} 
 					}
@@ -1175,6 +1197,10 @@ int main(int argc, char *argv[]) {
 
 
 			TaskProtocol protocol( task_list );
+			if ( opt.checkpoint_prefix.size() ) {
+				protocol.set_checkpointing( opt.checkpoint_prefix + "_" + test_data_cache->scafftag + ".ckpt",
+				                            opt.checkpoint_after_tasks, opt.resume_from_checkpoint, opt.checkpoint_key() );
+			}
 
 
 			shared_ptr<std::vector<SearchPoint>> starting_point = make_shared<std::vector<SearchPoint>>( );
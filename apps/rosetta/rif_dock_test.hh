@@ -5,6 +5,8 @@
 #include <riflib/scaffold/nineA_util.hh>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
+
 #ifdef GLOBAL_VARIABLES_ARE_BAD
 	#ifndef INCLUDED_rif_dock_test_hh_1
 	#define INCLUDED_rif_dock_test_hh_1   
@@ -38,6 +40,17 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 
 	OPT_1GRP_KEY(  Real        , rif_dock, beam_size_M )
     OPT_1GRP_KEY(  Real        , rif_dock, max_beam_multiplier )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, hsearch_fused_stages )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, hsearch_select_while_scoring )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, hsearch_compact_points )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, hsearch_adaptive_beam )
+    OPT_1GRP_KEY(  Real        , rif_dock, hsearch_adaptive_beam_slack )
+    OPT_1GRP_KEY(  Real        , rif_dock, hsearch_adaptive_beam_min_frac )
+    OPT_1GRP_KEY(  Real        , rif_dock, hsearch_adaptive_beam_max_frac )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, hsearch_locality_order )
+    OPT_1GRP_KEY(  String      , rif_dock, checkpoint_prefix )
+    OPT_1GRP_KEY(  IntegerVector, rif_dock, checkpoint_after_tasks )
+    OPT_1GRP_KEY(  Boolean     , rif_dock, resume_from_checkpoint )
     OPT_1GRP_KEY(  Boolean     , rif_dock, multiply_beam_by_seeding_positions )
     OPT_1GRP_KEY(  Boolean     , rif_dock, multiply_beam_by_scaffolds )
 	OPT_1GRP_KEY(  Real        , rif_dock, search_diameter )
@@ -57,6 +70,8 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 	OPT_1GRP_KEY(  Real        , rif_dock, favorable_1body_multiplier )
 	OPT_1GRP_KEY(  Real        , rif_dock, favorable_1body_multiplier_cutoff )
 	OPT_1GRP_KEY(  Real        , rif_dock, favorable_2body_multiplier )
+	OPT_1GRP_KEY(  Boolean     , rif_dock, twobody_int16 )
+	OPT_1GRP_KEY(  Boolean     , rif_dock, twobody_lazy )
 
 	OPT_1GRP_KEY(  Integer     , rif_dock, rotrf_oversample )
 	OPT_1GRP_KEY(  Real        , rif_dock, rotrf_resl )
@@ -69,6 +84,14 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 	OPT_1GRP_KEY(  Real        , rif_dock, hack_pack_frac )
 	OPT_1GRP_KEY(  Real        , rif_dock, pack_iter_mult )
 	OPT_1GRP_KEY(  Integer     , rif_dock, pack_n_iters )
+	OPT_1GRP_KEY(  Boolean     , rif_dock, pack_dee_prune )
+	OPT_1GRP_KEY(  Integer     , rif_dock, pack_exact_max_treewidth )
+	OPT_1GRP_KEY(  Real        , rif_dock, pack_exact_max_work )
+	OPT_1GRP_KEY(  Integer     , rif_dock, pack_pt_nreplicas )
+	OPT_1GRP_KEY(  Integer     , rif_dock, pack_pt_rounds )
+	OPT_1GRP_KEY(  Integer     , rif_dock, pack_pt_swap_interval )
+	OPT_1GRP_KEY(  Real        , rif_dock, pack_pt_temp_max )
+	OPT_1GRP_KEY(  Real        , rif_dock, pack_pt_temp_min )
 	OPT_1GRP_KEY(  Real        , rif_dock, hbond_weight )
 	OPT_1GRP_KEY(  Real        , rif_dock, upweight_multi_hbond )
 	OPT_1GRP_KEY(  Real        , rif_dock, min_hb_quality_for_satisfaction )
@@ -111,6 +134,7 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 	OPT_1GRP_KEY(  Boolean    , rif_dock, pdb_info_pikaa )
 
 	OPT_1GRP_KEY(  Boolean    , rif_dock, cache_scaffold_data )
+	OPT_1GRP_KEY(  String     , rif_dock, scaffold_table_cache_dir )
 
 	OPT_1GRP_KEY(  Real        , rif_dock, tether_to_input_position )
 
@@ -246,6 +270,8 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 			NEW_OPT(  rif_dock::favorable_1body_multiplier, "Anything with a one-body energy less than favorable_1body_cutoff gets multiplied by this", 1 );
 			NEW_OPT(  rif_dock::favorable_1body_multiplier_cutoff, "Anything with a one-body energy less than this gets multiplied by favorable_1body_multiplier", 0 );
 			NEW_OPT(  rif_dock::favorable_2body_multiplier, "Anything with a two-body energy less than 0 gets multiplied by this", 1 );
+			NEW_OPT(  rif_dock::twobody_int16, "Store packing two-body energies as 16 bit fixed point (1/64 resolution, saturates at +-512)", false );
+			NEW_OPT(  rif_dock::twobody_lazy, "Compute packing two-body energies for a residue pair only when packing first needs it. Not saved to the scaffold data cache", false );
 
 			NEW_OPT(  rif_dock::target_rf_cache, "" , "NO_CACHE_SPECIFIED_ON_COMMAND_LINE" );
 			NEW_OPT(  rif_dock::target_donors, "", "" );
@@ -258,6 +284,17 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 			NEW_OPT(  rif_dock::beam_size_M, "" , 10.000000 );
 
 			NEW_OPT(  rif_dock::max_beam_multiplier, "Maximum beam multiplier", 1 );
+			NEW_OPT(  rif_dock::hsearch_fused_stages, "Expand, score and select intermediate hsearch stages in one pass without storing all children. Ignored with hack_pack_during_hsearch", false );
+			NEW_OPT(  rif_dock::hsearch_select_while_scoring, "Pick each hsearch beam in the scoring threads instead of a separate pass. Ignored with hack_pack_during_hsearch", false );
+			NEW_OPT(  rif_dock::hsearch_compact_points, "Select intermediate hsearch beams over 64 bit packed points with rounded scores", false );
+			NEW_OPT(  rif_dock::hsearch_adaptive_beam, "Size each intermediate hsearch beam from its score distribution, within min_frac and max_frac of the normal beam", false );
+			NEW_OPT(  rif_dock::hsearch_adaptive_beam_slack, "Score a sample may still gain per angstrom of resolution when refined, for hsearch_adaptive_beam", 1.0 );
+			NEW_OPT(  rif_dock::hsearch_adaptive_beam_min_frac, "Smallest hsearch_adaptive_beam as a fraction of the normal beam", 0.1 );
+			NEW_OPT(  rif_dock::hsearch_adaptive_beam_max_frac, "Largest hsearch_adaptive_beam as a fraction of the normal beam", 4.0 );
+			NEW_OPT(  rif_dock::hsearch_locality_order, "Sort hsearch samples by scaffold and position before scoring and give each thread a contiguous run of them", false );
+			NEW_OPT(  rif_dock::checkpoint_prefix, "Write per-scaffold checkpoints to <prefix>_<scafftag>.ckpt. Empty to disable", "" );
+			NEW_OPT(  rif_dock::checkpoint_after_tasks, "Task numbers (0 based, -1 for the last) after which to write a checkpoint", utility::vector1< int >() );
+			NEW_OPT(  rif_dock::resume_from_checkpoint, "Skip the tasks already done in an existing checkpoint", false );
 			NEW_OPT(  rif_dock::multiply_beam_by_seeding_positions, "Multiply beam size by number of seeding positions", false);
 			NEW_OPT(  rif_dock::multiply_beam_by_scaffolds, "Multiply beam size by number of scaffolds", true);
 			NEW_OPT(  rif_dock::max_rf_bounding_ratio, "" , 4 );
@@ -282,6 +319,14 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 			NEW_OPT(  rif_dock::hack_pack_frac, "" , 0.2 );
 			NEW_OPT(  rif_dock::pack_iter_mult, "" , 2.0 );
 			NEW_OPT(  rif_dock::pack_n_iters, "" , 1 );
+			NEW_OPT(  rif_dock::pack_dee_prune, "Remove dead-end rotamers (Goldstein DEE) before each hackpack", false );
+			NEW_OPT(  rif_dock::pack_exact_max_treewidth, "Pack exactly (tree decomposition DP) instead of annealing if the residue graph has at most this treewidth", 3 );
+			NEW_OPT(  rif_dock::pack_exact_max_work, "...and the DP tables have at most this many entries in total. 0 (default) to always anneal, ~1e5 is cheap", 0 );
+			NEW_OPT(  rif_dock::pack_pt_nreplicas, "If > 1, hackpack by replica exchange with this many temperatures instead of annealing", 0 );
+			NEW_OPT(  rif_dock::pack_pt_rounds, "Replica exchange steps per replica, in units of pack_iter_mult*nrots", 2 );
+			NEW_OPT(  rif_dock::pack_pt_swap_interval, "Replica exchange steps between temperature swap attempts", 10 );
+			NEW_OPT(  rif_dock::pack_pt_temp_max, "Hottest replica exchange temperature", 10.0 );
+			NEW_OPT(  rif_dock::pack_pt_temp_min, "Coldest replica exchange temperature, temperatures are geometrically spaced", 0.1 );
 			NEW_OPT(  rif_dock::hbond_weight, "" , 2.0 );
 			NEW_OPT(  rif_dock::upweight_multi_hbond, "" , 0.0 );
 			NEW_OPT(  rif_dock::min_hb_quality_for_satisfaction, "Minimum fraction of total hbond energy required for satisfaction. Scale -1 to 0", -0.6 );
@@ -327,6 +372,7 @@ OPT_1GRP_KEY(     StringVector , rif_dock, scaffolds )
 			NEW_OPT(  rif_dock::pdb_info_pikaa, "", false );
 
 			NEW_OPT(  rif_dock::cache_scaffold_data, "", false );
+			NEW_OPT(  rif_dock::scaffold_table_cache_dir, "Directory for one and two-body energy tables keyed by scaffold coordinates, rotamers and energy options. Empty to disable", "" );
 
 			NEW_OPT(  rif_dock::tether_to_input_position, "", -1.0 );
 
@@ -456,6 +502,17 @@ struct RifDockOpt
 	int64_t     DIMPOW2                              ;
 	int64_t     beam_size                            ;
     float       max_beam_multiplier                  ;
+	bool        hsearch_fused_stages                 ;
+	bool        hsearch_select_while_scoring         ;
+	bool        hsearch_compact_points               ;
+	bool        hsearch_adaptive_beam                ;
+	float       hsearch_adaptive_beam_slack          ;
+	float       hsearch_adaptive_beam_min_frac       ;
+	float       hsearch_adaptive_beam_max_frac       ;
+	bool        hsearch_locality_order               ;
+	std::string checkpoint_prefix                    ;
+	std::vector<int> checkpoint_after_tasks          ;
+	bool        resume_from_checkpoint               ;
     bool        multiply_beam_by_seeding_positions   ;
     bool        multiply_beam_by_scaffolds           ;
 	bool        replace_all_with_ala_1bre            ;
@@ -511,9 +568,12 @@ struct RifDockOpt
 	float       favorable_1body_multiplier           ;
 	float       favorable_1body_multiplier_cutoff    ;
 	float       favorable_2body_multiplier           ;
+	bool        twobody_int16                        ;
+	bool        twobody_lazy                         ;
 	bool        random_perturb_scaffold              ;
 	bool        dont_use_scaffold_loops              ;
 	bool        cache_scaffold_data                  ;
+	std::string scaffold_table_cache_dir             ;
 	float       rf_resl                              ;
 	bool        hack_pack                            ;
 	bool        hack_pack_during_hsearch             ;
@@ -527,6 +587,14 @@ struct RifDockOpt
 
 	float       pack_iter_mult                       ;
 	int         pack_n_iters                         ;
+	bool        pack_dee_prune                       ;
+	int         pack_exact_max_treewidth             ;
+	float       pack_exact_max_work                  ;
+	int         pack_pt_nreplicas                    ;
+	int         pack_pt_rounds                       ;
+	int         pack_pt_swap_interval                ;
+	float       pack_pt_temp_max                     ;
+	float       pack_pt_temp_min                     ;
 	float       hbond_weight                         ;
 	float       upweight_iface                       ;
 	float       upweight_multi_hbond                 ;
@@ -638,6 +706,11 @@ struct RifDockOpt
 
     void init_from_cli();
 
+    // hash of everything that changes the points a protocol produces, so a checkpoint
+    // written under different options isn't resumed. the checkpoint options themselves
+    // and output-only options are left out
+    uint64_t checkpoint_key() const;
+
 
 };
 
@@ -661,6 +734,17 @@ struct RifDockOpt
 		DIMPOW2                                = 1<<DIM;
 		beam_size                              = int64_t( option[rif_dock::beam_size_M]() * 1000000.0 / DIMPOW2 ) * DIMPOW2;
         max_beam_multiplier                    = option[rif_dock::max_beam_multiplier                ]();
+		hsearch_fused_stages                   = option[rif_dock::hsearch_fused_stages                  ]();
+		hsearch_select_while_scoring           = option[rif_dock::hsearch_select_while_scoring          ]();
+		hsearch_compact_points                 = option[rif_dock::hsearch_compact_points                ]();
+		hsearch_adaptive_beam                  = option[rif_dock::hsearch_adaptive_beam                 ]();
+		hsearch_adaptive_beam_slack            = option[rif_dock::hsearch_adaptive_beam_slack           ]();
+		hsearch_adaptive_beam_min_frac         = option[rif_dock::hsearch_adaptive_beam_min_frac        ]();
+		hsearch_adaptive_beam_max_frac         = option[rif_dock::hsearch_adaptive_beam_max_frac        ]();
+		hsearch_locality_order                 = option[rif_dock::hsearch_locality_order                ]();
+		checkpoint_prefix                      = option[rif_dock::checkpoint_prefix                     ]();
+		resume_from_checkpoint                 = option[rif_dock::resume_from_checkpoint                ]();
+		for( int itask : option[rif_dock::checkpoint_after_tasks]() ) checkpoint_after_tasks.push_back(itask);
 		multiply_beam_by_seeding_positions     = option[rif_dock::multiply_beam_by_seeding_positions ]();
 		multiply_beam_by_scaffolds             = option[rif_dock::multiply_beam_by_scaffolds         ]();        
 		replace_all_with_ala_1bre              = option[rif_dock::replace_all_with_ala_1bre          ]();
@@ -717,9 +801,12 @@ struct RifDockOpt
 		favorable_1body_multiplier             = option[rif_dock::favorable_1body_multiplier            ]();
 		favorable_1body_multiplier_cutoff      = option[rif_dock::favorable_1body_multiplier_cutoff     ]();
 		favorable_2body_multiplier             = option[rif_dock::favorable_2body_multiplier            ]();
+		twobody_int16                          = option[rif_dock::twobody_int16                         ]();
+		twobody_lazy                           = option[rif_dock::twobody_lazy                          ]();
 		random_perturb_scaffold                = option[rif_dock::random_perturb_scaffold               ]();
 		dont_use_scaffold_loops                = option[rif_dock::dont_use_scaffold_loops               ]();
 		cache_scaffold_data                    = option[rif_dock::cache_scaffold_data                   ]();
+		scaffold_table_cache_dir               = option[rif_dock::scaffold_table_cache_dir              ]();
 		rf_resl                                = option[rif_dock::rf_resl                               ]();
 		hack_pack                              = option[rif_dock::hack_pack                             ]();
 		hack_pack_during_hsearch               = option[rif_dock::hack_pack_during_hsearch              ]();
@@ -735,6 +822,14 @@ struct RifDockOpt
 		rotrf_scale_atr                        = option[rif_dock::rotrf_scale_atr                       ]();
 		pack_iter_mult                         = option[rif_dock::pack_iter_mult                        ]();
 		pack_n_iters                           = option[rif_dock::pack_n_iters                          ]();
+		pack_dee_prune                         = option[rif_dock::pack_dee_prune                        ]();
+		pack_exact_max_treewidth               = option[rif_dock::pack_exact_max_treewidth              ]();
+		pack_exact_max_work                    = option[rif_dock::pack_exact_max_work                   ]();
+		pack_pt_nreplicas                      = option[rif_dock::pack_pt_nreplicas                     ]();
+		pack_pt_rounds                         = option[rif_dock::pack_pt_rounds                        ]();
+		pack_pt_swap_interval                  = option[rif_dock::pack_pt_swap_interval                 ]();
+		pack_pt_temp_max                       = option[rif_dock::pack_pt_temp_max                      ]();
+		pack_pt_temp_min                       = option[rif_dock::pack_pt_temp_min                      ]();
 		hbond_weight                           = option[rif_dock::hbond_weight                          ]();
 		upweight_iface                         = option[rif_dock::upweight_iface                        ]();
 		upweight_multi_hbond                   = option[rif_dock::upweight_multi_hbond                  ]();
@@ -906,6 +1001,165 @@ struct RifDockOpt
 
 	}
 
+	uint64_t RifDockOpt::checkpoint_key() const
+	{
+		size_t h = 0;
+		boost::hash_combine( h, rif_files );
+		boost::hash_combine( h, target_pdb );
+		boost::hash_combine( h, target_res_fname );
+		boost::hash_combine( h, target_donors );
+		boost::hash_combine( h, target_acceptors );
+		boost::hash_combine( h, scaffold_res_fnames );
+		boost::hash_combine( h, scaff_search_mode );
+		boost::hash_combine( h, seeding_fnames );
+		boost::hash_combine( h, xform_fname );
+		boost::hash_combine( h, seed_with_these_pdbs );
+		boost::hash_combine( h, seed_include_input );
+		boost::hash_combine( h, cst_fnames );
+		boost::hash_combine( h, morph_rules_fnames );
+		boost::hash_combine( h, morph_silent_file );
+		boost::hash_combine( h, requirements );
+		boost::hash_combine( h, scaffold_fnames );
+		boost::hash_combine( h, rot_spec_fname );
+		boost::hash_combine( h, seeding_by_patchdock );
+		boost::hash_combine( h, random_perturb_scaffold );
+		boost::hash_combine( h, dont_use_scaffold_loops );
+		boost::hash_combine( h, use_dl_mix_bb );
+		boost::hash_combine( h, nineA_cluster_path );
+		boost::hash_combine( h, nineA_baseline_range );
+		boost::hash_combine( h, low_cut_site );
+		boost::hash_combine( h, high_cut_site );
+		boost::hash_combine( h, max_insertion );
+		boost::hash_combine( h, max_deletion );
+		boost::hash_combine( h, fragment_cluster_tolerance );
+		boost::hash_combine( h, fragment_max_rmsd );
+		boost::hash_combine( h, max_fragments );
+		boost::hash_combine( h, morph_silent_archetype );
+		boost::hash_combine( h, morph_silent_max_structures );
+		boost::hash_combine( h, morph_silent_random_selection );
+		boost::hash_combine( h, morph_silent_cluster_use_frac );
+		boost::hash_combine( h, include_parent );
+		boost::hash_combine( h, use_parent_body_energies );
+		boost::hash_combine( h, match_this_pdb );
+		boost::hash_combine( h, match_this_rmsd );
+
+		boost::hash_combine( h, resl0 );
+		boost::hash_combine( h, beam_size );
+		boost::hash_combine( h, max_beam_multiplier );
+		boost::hash_combine( h, multiply_beam_by_seeding_positions );
+		boost::hash_combine( h, multiply_beam_by_scaffolds );
+		boost::hash_combine( h, hsearch_fused_stages );
+		boost::hash_combine( h, hsearch_select_while_scoring );
+		boost::hash_combine( h, hsearch_compact_points );
+		boost::hash_combine( h, hsearch_adaptive_beam );
+		boost::hash_combine( h, hsearch_adaptive_beam_slack );
+		boost::hash_combine( h, hsearch_adaptive_beam_min_frac );
+		boost::hash_combine( h, hsearch_adaptive_beam_max_frac );
+		boost::hash_combine( h, hsearch_scale_factor );
+		boost::hash_combine( h, search_diameter );
+		boost::hash_combine( h, tether_to_input_position );
+		boost::hash_combine( h, tether_to_input_position_cut );
+		boost::hash_combine( h, global_score_cut );
+		boost::hash_combine( h, dive_resl );
+		boost::hash_combine( h, pop_resl );
+
+		boost::hash_combine( h, replace_all_with_ala_1bre );
+		boost::hash_combine( h, lowres_sterics_cbonly );
+		boost::hash_combine( h, scaffold_res_use_best_guess );
+		boost::hash_combine( h, scaff2ala );
+		boost::hash_combine( h, scaff2alaselonly );
+		boost::hash_combine( h, replace_orig_scaffold_res );
+		boost::hash_combine( h, favorable_1body_multiplier );
+		boost::hash_combine( h, favorable_1body_multiplier_cutoff );
+		boost::hash_combine( h, favorable_2body_multiplier );
+		boost::hash_combine( h, user_rotamer_bonus_constant );
+		boost::hash_combine( h, user_rotamer_bonus_per_chi );
+		boost::hash_combine( h, require_satisfaction );
+		boost::hash_combine( h, num_hotspots );
+		boost::hash_combine( h, require_n_rifres );
+		boost::hash_combine( h, twobody_int16 );
+		boost::hash_combine( h, use_rosetta_grid_energies );
+		boost::hash_combine( h, soft_rosetta_grid_energies );
+		boost::hash_combine( h, downscale_atr_by_hierarchy );
+		boost::hash_combine( h, only_load_highest_resl );
+		boost::hash_combine( h, target_rf_resl );
+		boost::hash_combine( h, target_rf_oversample );
+		boost::hash_combine( h, max_rf_bounding_ratio );
+		boost::hash_combine( h, rf_resl );
+		boost::hash_combine( h, rf_oversample );
+		boost::hash_combine( h, rotrf_resl );
+		boost::hash_combine( h, rotrf_oversample );
+		boost::hash_combine( h, rotrf_spread );
+		boost::hash_combine( h, rotrf_scale_atr );
+		boost::hash_combine( h, restrict_to_native_scaffold_res );
+		boost::hash_combine( h, bonus_to_native_scaffold_res );
+		boost::hash_combine( h, add_native_scaffold_rots_when_packing );
+
+		boost::hash_combine( h, hack_pack );
+		boost::hash_combine( h, hack_pack_frac );
+		boost::hash_combine( h, hack_pack_during_hsearch );
+		boost::hash_combine( h, pack_iter_mult );
+		boost::hash_combine( h, pack_n_iters );
+		boost::hash_combine( h, pack_dee_prune );
+		boost::hash_combine( h, pack_exact_max_treewidth );
+		boost::hash_combine( h, pack_exact_max_work );
+		boost::hash_combine( h, pack_pt_nreplicas );
+		boost::hash_combine( h, pack_pt_rounds );
+		boost::hash_combine( h, pack_pt_swap_interval );
+		boost::hash_combine( h, pack_pt_temp_max );
+		boost::hash_combine( h, pack_pt_temp_min );
+		boost::hash_combine( h, hbond_weight );
+		boost::hash_combine( h, upweight_iface );
+		boost::hash_combine( h, upweight_multi_hbond );
+		boost::hash_combine( h, min_hb_quality_for_satisfaction );
+		boost::hash_combine( h, extra_rotamers );
+		boost::hash_combine( h, extra_rif_rotamers );
+		boost::hash_combine( h, always_available_rotamers_level );
+		boost::hash_combine( h, packing_use_rif_rotamers );
+		boost::hash_combine( h, unsat_orbital_penalty );
+		boost::hash_combine( h, unsat_score_offset );
+		boost::hash_combine( h, unsat_require_burial );
+		boost::hash_combine( h, long_hbond_fudge_distance );
+		boost::hash_combine( h, neighbor_distance_cutoff );
+		boost::hash_combine( h, unsat_neighbor_cutoff );
+		boost::hash_combine( h, unsat_helper );
+
+		boost::hash_combine( h, rosetta_score_fraction );
+		boost::hash_combine( h, rosetta_score_then_min_below_thresh );
+		boost::hash_combine( h, rosetta_score_at_least );
+		boost::hash_combine( h, rosetta_score_at_most );
+		boost::hash_combine( h, rosetta_score_each_seeding_at_least );
+		boost::hash_combine( h, rosetta_score_select_random );
+		boost::hash_combine( h, rosetta_score_cut );
+		boost::hash_combine( h, rosetta_min_fraction );
+		boost::hash_combine( h, rosetta_min_at_least );
+		boost::hash_combine( h, rosetta_min_fix_target );
+		boost::hash_combine( h, rosetta_min_targetbb );
+		boost::hash_combine( h, rosetta_min_scaffoldbb );
+		boost::hash_combine( h, rosetta_min_allbb );
+		boost::hash_combine( h, rosetta_hard_min );
+		boost::hash_combine( h, rosetta_score_total );
+		boost::hash_combine( h, rosetta_score_ddg_only );
+		boost::hash_combine( h, rosetta_score_rifres_rifres_weight );
+		boost::hash_combine( h, rosetta_score_rifres_scaffold_weight );
+		boost::hash_combine( h, rosetta_filter_before );
+		boost::hash_combine( h, rosetta_filter_n_per_scaffold );
+		boost::hash_combine( h, rosetta_filter_redundancy_mag );
+		boost::hash_combine( h, rosetta_filter_even_if_no_score );
+		boost::hash_combine( h, rosetta_soft_score );
+		boost::hash_combine( h, rosetta_hard_score );
+		boost::hash_combine( h, rosetta_beta );
+		boost::hash_combine( h, redundancy_filter_mag );
+		boost::hash_combine( h, cluster_score_cut );
+		boost::hash_combine( h, keep_top_clusters_frac );
+		boost::hash_combine( h, filter_seeding_positions_separately );
+		boost::hash_combine( h, filter_scaffolds_separately );
+		boost::hash_combine( h, n_pdb_out );
+		boost::hash_combine( h, force_output_if_close_to_input );
+		boost::hash_combine( h, force_output_if_close_to_input_num );
+		return h;
+	}
+
 
 #endif
 #endif
@@ -22,7 +22,7 @@
 
 
 
-namespace scheme { namespace search { struct HackPackOpts; }}
+namespace scheme { namespace search { struct HackPackOpts; struct HackPack; }}
 
 namespace devel {
 namespace scheme {
@@ -1153,7 +1153,8 @@ struct RifFactoryImpl :
 				MyScoreBBActorRIF,
 				MyClashScore
 			>,
-			int // Config type, just resl
+			int, // Config type, just resl
+			true // one pass over the scene for rif and clash
 		> MyRIFObjective;
 
 	typedef ::scheme::objective::integration::SceneObjectiveParametric<
@@ -1362,6 +1363,11 @@ struct RifFactoryImpl :
         return dynamic_cast<MySceneObjectiveRIF&>(*objective).objective.template get_objective<MyScoreBBActorRIF>().unsatperthread_;
     }
 
+    std::vector<shared_ptr< ::scheme::search::HackPack>> &
+    get_packperthread( ObjectivePtr & objective ) const override {
+        return dynamic_cast<MySceneObjectiveRIF&>(*objective).objective.template get_objective<MyScoreBBActorRIF>().packperthread_;
+    }
+
 
 };
 
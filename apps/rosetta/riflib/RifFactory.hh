@@ -91,6 +91,9 @@ struct RifFactory
 	// This should not be in here. Only here because of the typedefs
 	virtual std::vector<shared_ptr<UnsatManager>> &
 	get_unsatperthread( ObjectivePtr & objective ) const = 0;
+
+	virtual std::vector<shared_ptr< ::scheme::search::HackPack>> &
+	get_packperthread( ObjectivePtr & objective ) const = 0;
 };
 
 
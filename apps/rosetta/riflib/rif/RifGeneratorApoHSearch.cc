@@ -504,10 +504,16 @@ namespace rif {
 							}
 							if( samples[r-1][i].score > final_score_cut ) continue;
 							uint64_t isamp0 = samples[r-1][i].index;
+							// the children of one sample are contiguous, decode them together
+							uint64_t child_index[DIMPOW2];
+							EigenXform child_pos[DIMPOW2];
+							bool child_ok[DIMPOW2];
+							for( uint64_t j = 0; j < DIMPOW2; ++j ) child_index[j] = isamp0 * DIMPOW2 + j;
+							d.nest().get_states( child_index, DIMPOW2, r, child_pos, child_ok );
 							for( uint64_t j = 0; j < DIMPOW2; ++j ){
-								uint64_t isamp = isamp0 * DIMPOW2 + j;
+								if( !child_ok[j] ) continue;
 								Scene & tscene( scene_per_thread[omp_get_thread_num()] );
-								d.set_scene( isamp, r, tscene );
+								tscene.set_position( d.ibody_, child_pos[j] );
 								float score0 = objective( tscene, r ).template get<VoxelScore>();// - numeric::random::uniform()/1000.0;
 								if(score0 < 0){
 									avg_scores[ omp_get_thread_num() ] += score0;
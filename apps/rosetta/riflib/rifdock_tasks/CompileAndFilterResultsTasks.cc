@@ -14,7 +14,11 @@
 #include <riflib/task/util.hh>
 #include <riflib/scaffold/ScaffoldDataCache.hh>
 
+#include <scheme/search/SelectedXformGrid.hh>
+
+#include <algorithm>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <unordered_map>
 
@@ -52,9 +56,15 @@ struct tmplXRtriple {
     EigenXform xform;
     ScaffoldIndex scaffold_index;
     uint64_t result_num;
+    float cluster_score; // redundant results counted against this one
 };
 
 
+// selected xforms within redundancy_filter_mag of a result, binned so threads only contend nearby
+template<class EigenXform, class ScaffoldIndex>
+using tmplSelectedXformGrid = ::scheme::search::SelectedXformGrid< tmplXRtriple<EigenXform, ScaffoldIndex> >;
+
+
 // how can I fix this??? make the whole prototype into a class maybe???
 // what does it do?
 //  set and rescore scene with nopackscore, record more score detail
@@ -79,7 +89,7 @@ awful_compile_output_helper_(
     Eigen::Vector3f scaffold_center,
     std::vector< std::vector< RifDockResult > > & allresults_pt,
                  std::vector< RifDockResult >   & selected_results,
-    std::vector< tmplXRtriple<EigenXform, ScaffoldIndex> > & selected_xforms,
+    tmplSelectedXformGrid<EigenXform, ScaffoldIndex> & selected_xforms,
     int n_pdb_out,
     #ifdef USE_OPENMP
         omp_lock_t & dump_lock,
@@ -130,56 +140,52 @@ awful_compile_output_helper_(
         EigenXform xposition1 = scene_minimal->position(1);
         EigenXform xposition1inv = xposition1.inverse();
 
+        // search and insert under the same locks, so two near copies can't both be selected
+        std::vector<int> stripes;
+        selected_xforms.lock_near( xposition1.translation(), stripes );
+
         float mindiff_candidate = 9e9;
-        int64_t i_closest_result;
-        BOOST_FOREACH( XRtriple const & xrp, selected_xforms ){
+        XRtriple * closest = nullptr;
+        selected_xforms.for_each_near( xposition1.translation(), [&]( XRtriple & xrp ){
             EigenXform const & xsel = xrp.xform;
             EigenXform const xdiff = xposition1inv * xsel;
             float diff = devel::scheme::xform_magnitude( xdiff, redundancy_filter_rg );
             if( diff < mindiff_candidate ){
                 mindiff_candidate = diff;
-                i_closest_result = xrp.result_num;
+                closest = &xrp;
             }
             // todo: also compare AA composition of rotamers
-        }
+        });
 
         if( mindiff_candidate < redundancy_filter_mag ){ // redundant result
-            selected_results[i_closest_result].cluster_score += 1.0; //sp.score==0.0 ? nopackscore : sp.score;
+            closest->cluster_score += 1.0; //sp.score==0.0 ? nopackscore : sp.score;
         }
 
         if( mindiff_candidate > redundancy_filter_mag || force_selected ){
-
+            r.rotamers_ = sp.rotamers_;
+            int64_t result_num;
             #ifdef USE_OPENMP
             omp_set_lock( &dump_lock );
             #endif
             {
-                // std::cout << "checking again to add selected " << selected_xforms.size() << " " << omp_get_thread_num() << std::endl;
-                float mindiff_actual = 9e9;
-                BOOST_FOREACH( XRtriple const & xrp, selected_xforms ){
-                    EigenXform const & xsel = xrp.xform;
-                    EigenXform const xdiff = xposition1inv * xsel;
-                    mindiff_actual = std::min( mindiff_actual, devel::scheme::xform_magnitude( xdiff, redundancy_filter_rg ) );
-                }
-                if( mindiff_actual > redundancy_filter_mag || force_selected ){
-                    if( redundancy_filter_mag > 0.0001 ) {
-                        selected_xforms.push_back( XRtriple {
-                            xposition1, 
-                            sp.index,
-                            (int64_t)selected_results.size()
-                        } );
-                    }
-                    r.rotamers_ = sp.rotamers_;
-                    selected_results.push_back( r ); // recorded with rotamers here
-                } else {
-                    // std::cout << " second check failed" << std::endl;
-                }
+                result_num = selected_results.size();
+                selected_results.push_back( r ); // recorded with rotamers here
             }
             #ifdef USE_OPENMP
             omp_unset_lock( &dump_lock );
             #endif
-
+            if( redundancy_filter_mag > 0.0001 ) {
+                selected_xforms.insert( XRtriple {
+                    xposition1,
+                    sp.index,
+                    (uint64_t)result_num,
+                    0.0f
+                } );
+            }
         } // end if( mindiff > redundancy_filter_mag ){
 
+        selected_xforms.unlock( stripes );
+
     } // end    if( selected_xforms.size() < n_pdb_out || force_selected )
 
 }
@@ -206,6 +212,7 @@ CompileAndFilterResultsTask::return_rif_dock_results(
 
 
     typedef tmplXRtriple<EigenXform, RifDockIndex> XRtriple;
+    typedef tmplSelectedXformGrid<EigenXform, RifDockIndex> SelectedXformGrid;
 
     int64_t Nout = packed_results.size(); 
 
@@ -214,15 +221,15 @@ CompileAndFilterResultsTask::return_rif_dock_results(
     SelectiveRifDockIndexHasher   hasher( false, filter_seeding_positions_separately_, filter_scaffolds_separately_ );
     SelectiveRifDockIndexEquater equater( false, filter_seeding_positions_separately_, filter_scaffolds_separately_ );
 
-    std::unordered_map< RifDockIndex, std::vector< XRtriple >, SelectiveRifDockIndexHasher, SelectiveRifDockIndexEquater > 
-        selected_xforms_map(1000, hasher, equater);  // default value here needs to be .reserve(65536)
+    std::unordered_map< RifDockIndex, SelectedXformGrid, SelectiveRifDockIndexHasher, SelectiveRifDockIndexEquater > 
+        selected_xforms_map(1000, hasher, equater);
     std::unordered_map< RifDockIndex, int, SelectiveRifDockIndexHasher, SelectiveRifDockIndexEquater > 
         nclose_map(1000, hasher, equater); // default value here needs to be 0
 
     for ( uint64_t isamp = 0; isamp < Nout; isamp++ ) {
         RifDockIndex rdi = packed_results[isamp].index;
         if ( selected_xforms_map.count(rdi) == 0 ) {
-            selected_xforms_map[ rdi ].reserve(65536); // init big to reduce liklihood of resizes
+            selected_xforms_map.emplace( std::piecewise_construct, std::forward_as_tuple( rdi ), std::forward_as_tuple( redundancy_mag_ ) );
             nclose_map[ rdi ] = 0;
         }
     }
@@ -244,7 +251,7 @@ CompileAndFilterResultsTask::return_rif_dock_results(
 
         RifDockIndex rdi = packed_results[isamp].index;
         ScaffoldIndex si = packed_results[isamp].index.scaffold_index;
-        std::vector< XRtriple > & selected_xforms = selected_xforms_map.at( rdi );
+        SelectedXformGrid & selected_xforms = selected_xforms_map.at( rdi );
         int & nclose = nclose_map.at( rdi );
         ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
         float redundancy_filter_rg = sdc->get_redundancy_filter_rg( rdd.target_redundancy_filter_rg );
@@ -278,7 +285,7 @@ CompileAndFilterResultsTask::return_rif_dock_results(
 
             RifDockIndex rdi = packed_results[isamp].index;
             ScaffoldIndex si = packed_results[isamp].index.scaffold_index;
-            std::vector< XRtriple > & selected_xforms = selected_xforms_map.at( rdi );
+            SelectedXformGrid & selected_xforms = selected_xforms_map.at( rdi );
             int & nclose = nclose_map.at( rdi );
             ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
             float redundancy_filter_rg = sdc->get_redundancy_filter_rg( rdd.target_redundancy_filter_rg );
@@ -304,6 +311,12 @@ CompileAndFilterResultsTask::return_rif_dock_results(
     if( exception ) std::rethrow_exception(exception);
     std::cout << std::endl;
 
+    for( auto const & kv : selected_xforms_map ){
+        kv.second.for_each( [&]( XRtriple const & xrp ){
+            selected_results[ xrp.result_num ].cluster_score += xrp.cluster_score;
+        });
+    }
+
     std::cout << "sort compiled results" << std::endl;
     BOOST_FOREACH( std::vector<RifDockResult> const & rs, allresults_pt ){
         BOOST_FOREACH( RifDockResult const & r, rs ){
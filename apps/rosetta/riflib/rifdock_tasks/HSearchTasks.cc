@@ -13,6 +13,11 @@
 #include <riflib/types.hh>
 #include <riflib/scaffold/ScaffoldDataCache.hh>
 #include <riflib/rifdock_tasks/OutputResultsTasks.hh>
+#include <riflib/task/util.hh>
+#include <scheme/search/AdaptiveBeam.hh>
+#include <scheme/util/TopK.hh>
+#include <scheme/util/radix_sort.hh>
+#include <scheme/util/StealingChunks.hh>
 
 
 #include <string>
@@ -78,6 +83,24 @@ DiversifyByNestTask::return_any_points(
 
 
 
+void
+HSearchInit::setup_scaffolds( RifDockData & rdd, ProtocolData & pd ) {
+    for ( ScaffoldIndex si : pd.unique_scaffolds ) {
+        ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
+        sdc->setup_onebody_tables( rdd.rot_index_p, rdd.opt);
+
+        if ( rdd.burial_manager ) {
+            sdc->setup_burial_grids( rdd.burial_manager );
+        }
+    }
+}
+
+// unique_scaffolds and beam_multiplier come back with the checkpoint
+void
+HSearchInit::restore_state( RifDockData & rdd, ProtocolData & pd ) {
+    setup_scaffolds( rdd, pd );
+}
+
 shared_ptr<std::vector<SearchPoint>> 
 HSearchInit::return_search_points( 
     shared_ptr<std::vector<SearchPoint>> search_points, 
@@ -98,15 +121,9 @@ HSearchInit::return_search_points(
 
     pd.unique_scaffolds.clear();
     for ( std::pair<RifDockIndex, bool> pair : uniq_scaffolds ) {
-        ScaffoldIndex si = pair.first.scaffold_index;
-        ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
-        sdc->setup_onebody_tables( rdd.rot_index_p, rdd.opt);
-        pd.unique_scaffolds.push_back(si);
-
-        if ( rdd.burial_manager ) {
-            sdc->setup_burial_grids( rdd.burial_manager );
-        }
+        pd.unique_scaffolds.push_back(pair.first.scaffold_index);
     }
+    setup_scaffolds( rdd, pd );
 
 
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -128,6 +145,117 @@ HSearchInit::return_search_points(
 }
 
 
+// true if any scaffold has constraints to apply during hsearch at this resolution
+static bool
+prepare_hsearch_constraints( RifDockData & rdd, ProtocolData & pd, int rif_resl ) {
+    bool using_csts = false;
+    for ( ScaffoldIndex si : pd.unique_scaffolds ) {
+        ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
+        using_csts |= sdc->prepare_contraints( rdd.target, rdd.RESLS[rif_resl] );
+    }
+    return using_csts;
+}
+
+// stable sort by (scaffold, seeding position, high bits of the nest index) so consecutive
+// samples share scaffold data and land near each other in the rif. the key is cut to 32
+// bits, 4 radix passes. false if the points don't fit the director's index ranges
+static bool
+sort_hsearch_points_by_locality( std::vector<SearchPoint> & search_points, int director_resl, RifDockData & rdd ) {
+    CompactSearchPointCodec codec = compact_search_point_codec( rdd, director_resl );
+    if ( ! codec.representable() ) return false;
+    bool fits = true;
+    #ifdef USE_OPENMP
+    #pragma omp parallel for reduction(&&:fits)
+    #endif
+    for ( size_t i = 0; i < search_points.size(); i++ ) {
+        fits = fits && codec.fits( search_points[i] );
+    }
+    if ( ! fits ) return false;
+
+    int const index_bits = codec.index_bits();
+    int const drop = std::max( 0, index_bits - 32 );
+    uint64_t const index_mask = ( uint64_t(1) << index_bits ) - 1;
+    ::scheme::util::radix_sort_by_key( search_points,
+        [&codec,index_mask,drop]( SearchPoint const & sp ){ return ( codec.encode( sp ) & index_mask ) >> drop; },
+        index_bits - drop );
+    return true;
+}
+
+// what the director last set on a thread's scene, so the next sample only redoes what changed
+struct DirectorState {
+    RifDockIndex index;
+    int resl = -1; // scene state unknown
+};
+
+// score of one hsearch sample, 9e9 if it can't be placed or fails the tether or constraints
+static float
+score_hsearch_point(
+    RifDockIndex const & isamp,
+    int director_resl,
+    int rif_resl,
+    float tether_to_input_position_cut,
+    bool using_csts,
+    RifDockData & rdd,
+    ScenePtr & tscene,
+    DirectorState & last ) {
+
+    bool director_success = last.resl < 0
+        ? rdd.director->set_scene( isamp, director_resl, *tscene )
+        : rdd.director->set_scene_incremental( last.index, last.resl, isamp, director_resl, *tscene );
+    if ( ! director_success ) {
+        last.resl = -1;
+        return 9e9;
+    }
+    last.index = isamp;
+    last.resl = director_resl;
+
+    if ( using_csts || tether_to_input_position_cut != 0 ) {
+        ScaffoldIndex si = isamp.scaffold_index;
+        ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
+
+        if( tether_to_input_position_cut > 0 ){
+            float redundancy_filter_rg = sdc->get_redundancy_filter_rg( rdd.target_redundancy_filter_rg );
+
+            EigenXform x;// = tscene->position(1);
+            rdd.nest.get_state( isamp.nest_index, director_resl, x );
+            x.translation() -= sdc->scaffold_center;
+            float xmag =  xform_magnitude( x, redundancy_filter_rg );
+            if( xmag > tether_to_input_position_cut + rdd.RESLS[rif_resl] ){
+                return 9e9;
+            } 
+        }
+
+        /////////////////////////////////////////////////////
+        /////// Longxing' code  ////////////////////////////
+        ////////////////////////////////////////////////////
+        if (using_csts) {
+            EigenXform x = tscene->position(1);
+            for(CstBaseOP p : sdc->csts) {
+                if (!p->apply( x )) return 9e9;
+            }
+        }
+    }
+
+    // the real rif score!!!!!!
+    return rdd.objectives[rif_resl]->score( *tscene );// + tot_sym_score;
+}
+
+
+// -rif_dock:hsearch_adaptive_beam for the stage at resl, a point may improve by slack per
+// angstrom of resolution when refined
+static ::scheme::search::AdaptiveBeam
+hsearch_adaptive_beam( RifDockData & rdd, int resl, float global_score_cut ) {
+    return ::scheme::search::AdaptiveBeam( rdd.opt.hsearch_adaptive_beam_min_frac, rdd.opt.hsearch_adaptive_beam_max_frac,
+                                           rdd.opt.hsearch_adaptive_beam_slack * rdd.RESLS[resl], global_score_cut );
+}
+
+static void
+report_adaptive_beam( int resl, ::scheme::search::AdaptiveBeam const & beam, ::scheme::search::AdaptiveBeam::Stats const & stats, uint64_t base_keep ) {
+    using ObjexxFCL::format::F;
+    std::cout << "HSearsh stage " << resl+1 << " adaptive beam: " << KMGT(stats.can_beat) << " within " << F(7,3,beam.slack)
+              << " of " << F(9,6,stats.ref_score) << ", keeping " << KMGT(stats.keep) << " (base " << KMGT(base_keep) << ")" << std::endl;
+}
+
 shared_ptr<std::vector<SearchPoint>> 
 HSearchScoreAtReslTask::return_search_points( 
     shared_ptr<std::vector<SearchPoint>> search_points_p, 
@@ -142,13 +270,10 @@ HSearchScoreAtReslTask::return_search_points(
 
     std::vector<SearchPoint> & search_points = *search_points_p;
 
-    bool using_csts = false;
-    for ( ScaffoldIndex si : pd.unique_scaffolds ) {
-        ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
-        using_csts |= sdc->prepare_contraints( rdd.target, rdd.RESLS[rif_resl_] );
-    }
+    bool using_csts = prepare_hsearch_constraints( rdd, pd, rif_resl_ );
 
-    bool need_sdc = using_csts || tether_to_input_position_cut_ != 0;
+    bool const locality = rdd.opt.hsearch_locality_order
+                      && sort_hsearch_points_by_locality( search_points, director_resl_, rdd );
 
 
     cout << "HSearsh stage " << rif_resl_+1 << " resl " << F(5,2,rdd.RESLS[rif_resl_]) << " begin threaded sampling, " << KMGT(search_points.size()) << " samples: ";
@@ -158,68 +283,52 @@ HSearchScoreAtReslTask::return_search_points(
     start = std::chrono::high_resolution_clock::now();
     pd.total_search_effort += search_points.size();
 
-    #ifdef USE_OPENMP
-    #pragma omp parallel for schedule(dynamic,64)
-    #endif
-    for( int64_t i = 0; i < search_points.size(); ++i ){
-        if( exception ) continue;
+    // (score, position) so ties are broken the same way for any thread count
+    typedef ::scheme::util::BoundedTopK< std::pair<float,int64_t> > Selection;
+    // with an adaptive beam, select enough that HSearchFilterSortTask can size it from these
+    uint64_t keeping = num_to_select_ * pd.beam_multiplier;
+    if ( rdd.opt.hsearch_adaptive_beam ) keeping = hsearch_adaptive_beam( rdd, rif_resl_, 0 ).max_keep( keeping );
+    std::vector< Selection > selected( num_to_select_ ? omp_max_threads() : 0, Selection( keeping ) );
+    pd.hsearch_sorted_points = nullptr;
+    pd.hsearch_nsorted = 0;
+    std::vector<DirectorState> director_states( omp_max_threads() );
+
+    auto score_one = [&]( int64_t i, int ithread ) {
+        if( exception ) return;
         try {
             if( i%out_interval==0 ){ cout << '*'; cout.flush(); }
-            RifDockIndex const isamp = search_points[i].index;
-
-            ScenePtr tscene( rdd.scene_pt[omp_get_thread_num()] );
-            bool director_success = rdd.director->set_scene( isamp, director_resl_, *tscene );
-            if ( ! director_success ) {
-                search_points[i].score = 9e9;
-                continue;
-            }
-
-            if ( need_sdc ) {
-                ScaffoldIndex si = isamp.scaffold_index;
-                ScaffoldDataCacheOP sdc = rdd.scaffold_provider->get_data_cache_slow(si);
-
-                if( tether_to_input_position_cut_ > 0 ){
-                    float redundancy_filter_rg = sdc->get_redundancy_filter_rg( rdd.target_redundancy_filter_rg );
-
-                    EigenXform x;// = tscene->position(1);
-                    rdd.nest.get_state( isamp.nest_index, director_resl_, x );
-                    x.translation() -= sdc->scaffold_center;
-                    float xmag =  xform_magnitude( x, redundancy_filter_rg );
-                    if( xmag > tether_to_input_position_cut_ + rdd.RESLS[rif_resl_] ){
-                        search_points[i].score = 9e9;
-                        continue;
-                    } 
-                }
-
-                /////////////////////////////////////////////////////
-                /////// Longxing' code  ////////////////////////////
-                ////////////////////////////////////////////////////
-                if (using_csts) {
-                    EigenXform x = tscene->position(1);
-                    bool pass_all = true;
-                    for(CstBaseOP p : sdc->csts) {
-                        if (!p->apply( x )) {
-                            pass_all = false;
-                            break;
-                        }
-                    }
-                    if (!pass_all) {
-                        search_points[i].score = 9e9;
-                        continue;
-                    }
-                }
-            }
-
-            // the real rif score!!!!!!
-            search_points[i].score = rdd.objectives[rif_resl_]->score( *tscene );// + tot_sym_score;
-
-
+            ScenePtr tscene( rdd.scene_pt[ithread] );
+            search_points[i].score = score_hsearch_point( search_points[i].index, director_resl_, rif_resl_,
+                                            tether_to_input_position_cut_, using_csts, rdd, tscene, director_states[ithread] );
+            if ( num_to_select_ ) selected[ithread].push( std::make_pair( search_points[i].score, i ) );
         } catch( std::exception const & ex ) {
             #ifdef USE_OPENMP
             #pragma omp critical
             #endif
             exception = std::current_exception();
         }
+    };
+
+    if ( locality ) {
+        // each thread walks its own run of the sorted points, stealing from the others at the end
+        ::scheme::util::StealingChunks chunks( search_points.size(), 64, omp_max_threads() );
+        #ifdef USE_OPENMP
+        #pragma omp parallel
+        #endif
+        {
+            int const ithread = omp_get_thread_num();
+            uint64_t lb, ub;
+            while ( chunks.next( ithread, lb, ub ) ) {
+                for ( uint64_t i = lb; i < ub; ++i ) score_one( i, ithread );
+            }
+        }
+    } else {
+        #ifdef USE_OPENMP
+        #pragma omp parallel for schedule(dynamic,64)
+        #endif
+        for( int64_t i = 0; i < search_points.size(); ++i ){
+            score_one( i, omp_get_thread_num() );
+        }
     }
     if( exception ) std::rethrow_exception(exception);
     end = std::chrono::high_resolution_clock::now();
@@ -227,6 +336,18 @@ HSearchScoreAtReslTask::return_search_points(
     pd.hsearch_rate = (double)search_points.size()/ elapsed_seconds_rif.count()/omp_max_threads();
     cout << endl;// << "done threaded sampling, partitioning data..." << endl;
 
+    if ( num_to_select_ ) {
+        std::vector< std::pair<float,int64_t> > best = ::scheme::util::merge_top_k( selected ).take_sorted();
+        std::vector< int64_t > positions( best.size() );
+        for ( size_t k = 0; k < best.size(); k++ ) positions[k] = best[k].second;
+        // swapping the k-th lowest position into slot k never displaces a selected point
+        // that hasn't been moved yet
+        std::sort( positions.begin(), positions.end() );
+        for ( size_t k = 0; k < positions.size(); k++ ) std::swap( search_points[k], search_points[positions[k]] );
+        __gnu_parallel::sort( search_points.begin(), search_points.begin() + positions.size() );
+        pd.hsearch_sorted_points = &search_points;
+        pd.hsearch_nsorted = positions.size();
+    }
 
     return search_points_p;
 }
@@ -245,8 +366,44 @@ HSearchFilterSortTask::return_search_points(
 
     SearchPoint max_pt, min_pt;
     int64_t len = search_points.size();
+    size_t const nscored = search_points.size();
     uint64_t keeping = num_to_keep_ * pd.beam_multiplier;
-    if( search_points.size() > keeping ){
+    uint64_t const nsorted = pd.hsearch_sorted_points == &search_points ? pd.hsearch_nsorted : 0;
+    if ( rdd.opt.hsearch_adaptive_beam && prune_extra_ && len > 0 ) {
+        ::scheme::search::AdaptiveBeam const beam = hsearch_adaptive_beam( rdd, resl_, global_score_cut_ );
+        ::scheme::search::AdaptiveBeam::Stats stats;
+        uint64_t const base_keep = keeping;
+        keeping = beam.size( search_points, nsorted, base_keep, &stats );
+        report_adaptive_beam( resl_, beam, stats, base_keep );
+    }
+    bool const preselected = nsorted > 0 && nsorted >= std::min<uint64_t>( keeping, len );
+
+    // the points dropped here are gone and the kept ones are rescored after expansion, so
+    // selecting on rounded scores over 8 byte words is fine. the last stage keeps exact scores.
+    // the score cut is applied before rounding, so the same points pass it as on the exact path
+    CompactSearchPointCodec codec;
+    if ( ! preselected && prune_extra_ && search_points.size() > keeping && rdd.opt.hsearch_compact_points ) {
+        codec = compact_search_point_codec( rdd, resl_ );
+        codec.score_cut = global_score_cut_;
+    }
+    std::vector<uint64_t> compact;
+    bool const use_compact = codec.ok() && encode_search_points( codec, search_points, compact );
+    if ( preselected ) {
+        // already selected while scoring, report the worst kept rather than the best dropped
+        len = std::min<uint64_t>( keeping, len );
+        pd.hsearch_nsorted = std::min<uint64_t>( pd.hsearch_nsorted, len );
+        min_pt = search_points.front();
+        max_pt = search_points[len-1];
+    } else if ( use_compact ) {
+        std::vector<SearchPoint>().swap( search_points );
+        __gnu_parallel::nth_element( compact.begin(), compact.begin()+ keeping, compact.end() );
+        len = keeping;
+        min_pt = codec.decode( *__gnu_parallel::min_element( compact.begin(), compact.begin()+len ) );
+        max_pt = codec.decode( compact[keeping] );
+        compact.resize( keeping );
+        decode_search_points( codec, compact, search_points );
+        std::vector<uint64_t>().swap( compact );
+    } else if( search_points.size() > keeping ){
         __gnu_parallel::nth_element( search_points.begin(), search_points.begin()+ keeping, search_points.end() );
         len = keeping;
         min_pt = *__gnu_parallel::min_element( search_points.begin(), search_points.begin()+len );
@@ -257,12 +414,16 @@ HSearchFilterSortTask::return_search_points(
     }
 
     std::cout << "HSearsh stage " << resl_+1 << " complete, resl. " << F(7,3,rdd.RESLS[resl_]) << ", "
-          << " " << KMGT(search_points.size()) << ", promote: " << F(9,6,min_pt.score) << " to "
+          << " " << KMGT(nscored) << ", promote: " << F(9,6,min_pt.score) << " to "
           << F(9,6, std::min(global_score_cut_,max_pt.score)) << " rate " << KMGT(pd.hsearch_rate) << "/s/t " << std::endl;
 
     if ( prune_extra_ ) {
         search_points.resize(len);
     }
+    if ( ! preselected ) {
+        pd.hsearch_sorted_points = nullptr;
+        pd.hsearch_nsorted = 0;
+    }
 
     return search_points_p;
 }
@@ -287,7 +448,12 @@ HSearchScaleToReslTask::return_search_points(
             use_pow2 *= DIMPOW2_;
         }
 
-        __gnu_parallel::sort( search_points.begin(), search_points.end() );
+        // sort unless the scoring stage already left everything in order
+        if ( pd.hsearch_sorted_points != &search_points || pd.hsearch_nsorted < search_points.size() ) {
+            __gnu_parallel::sort( search_points.begin(), search_points.end() );
+        }
+        pd.hsearch_sorted_points = nullptr;
+        pd.hsearch_nsorted = 0;
         size_t good_points = 0;
         for ( good_points = 0; good_points < search_points.size(); good_points++ ) {
             if ( search_points[good_points].score >= global_score_cut_ ) break;
@@ -346,6 +512,100 @@ HSearchScaleToReslTask::return_search_points(
 
 }
 
+shared_ptr<std::vector<SearchPoint>> 
+HSearchFusedStageTask::return_search_points( 
+    shared_ptr<std::vector<SearchPoint>> search_points_p, 
+    RifDockData & rdd, 
+    ProtocolData & pd ) {
+
+    using ObjexxFCL::format::F;
+    using std::cout;
+    using std::endl;
+
+    runtime_assert( target_resl_ > current_resl_ );
+
+    std::vector<SearchPoint> & parents = *search_points_p;
+
+    uint64_t use_pow2 = 1;
+    for ( int i = current_resl_; i < target_resl_; i++ ) use_pow2 *= DIMPOW2_;
+
+    // same parents HSearchScaleToReslTask would expand
+    size_t good_points = 0;
+    for ( SearchPoint const & sp : parents ) good_points += sp.score < global_score_cut_;
+    if( current_resl_ == 0 ) pd.non0_space_size += good_points;
+
+    bool using_csts = prepare_hsearch_constraints( rdd, pd, target_resl_ );
+
+    // with an adaptive beam the best max_keep are held, enough to size the beam from
+    uint64_t const base_keep = num_to_keep_ * pd.beam_multiplier;
+    ::scheme::search::AdaptiveBeam const beam = hsearch_adaptive_beam( rdd, target_resl_, global_score_cut_ );
+    uint64_t const keeping = rdd.opt.hsearch_adaptive_beam ? beam.max_keep( base_keep ) : base_keep;
+    uint64_t const nchildren = good_points * use_pow2;
+
+    cout << "HSearsh stage " << target_resl_+1 << " resl " << F(5,2,rdd.RESLS[target_resl_]) << " begin fused sampling, "
+         << KMGT(nchildren) << " samples: ";
+    int64_t const out_interval = std::max<int64_t>( 1, parents.size()/50 );
+    std::exception_ptr exception = nullptr;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    pd.total_search_effort += nchildren;
+
+    // children are generated, scored and offered to this thread's selection one at a time,
+    // so at most num_threads * keeping points are held instead of all use_pow2 * good_points
+    std::vector< ::scheme::util::BoundedTopK<SearchPoint> > selected( omp_max_threads(), ::scheme::util::BoundedTopK<SearchPoint>( keeping ) );
+    std::vector<DirectorState> director_states( omp_max_threads() );
+
+    #ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic,1)
+    #endif
+    for( int64_t i = 0; i < parents.size(); ++i ){
+        if( exception ) continue;
+        if( parents[i].score >= global_score_cut_ ) continue;
+        try {
+            if( i%out_interval==0 ){ cout << '*'; cout.flush(); }
+            int const ithread = omp_get_thread_num();
+            ScenePtr tscene( rdd.scene_pt[ithread] );
+            ::scheme::util::BoundedTopK<SearchPoint> & top = selected[ithread];
+
+            SearchPoint child( parents[i].index );
+            uint64_t const isamp0 = use_pow2 * parents[i].index.nest_index;
+            for( uint64_t j = 0; j < use_pow2; ++j ){
+                child.index.nest_index = isamp0 + j;
+                child.score = score_hsearch_point( child.index, target_resl_, target_resl_,
+                                            tether_to_input_position_cut_, using_csts, rdd, tscene, director_states[ithread] );
+                top.push( child );
+            }
+        } catch( std::exception const & ex ) {
+            #ifdef USE_OPENMP
+            #pragma omp critical
+            #endif
+            exception = std::current_exception();
+        }
+    }
+    if( exception ) std::rethrow_exception(exception);
+    std::chrono::duration<double> elapsed_seconds_rif = std::chrono::high_resolution_clock::now()-start;
+    pd.hsearch_rate = (double)nchildren / elapsed_seconds_rif.count()/omp_max_threads();
+    cout << endl;
+
+    shared_ptr<std::vector<SearchPoint>> out_points_p = make_shared<std::vector<SearchPoint>>(
+        ::scheme::util::merge_top_k( selected ).take_sorted() );
+    parents.clear();
+
+    if ( rdd.opt.hsearch_adaptive_beam && out_points_p->size() > 0 ) {
+        ::scheme::search::AdaptiveBeam::Stats stats;
+        uint64_t const keep = beam.size( *out_points_p, out_points_p->size(), base_keep, &stats );
+        report_adaptive_beam( target_resl_, beam, stats, base_keep );
+        if ( keep < out_points_p->size() ) out_points_p->resize( keep );
+    }
+
+    if ( out_points_p->size() > 0 ) {
+        std::cout << "HSearsh stage " << target_resl_+1 << " complete, resl. " << F(7,3,rdd.RESLS[target_resl_]) << ", "
+              << " " << KMGT(nchildren) << ", promote: " << F(9,6,out_points_p->front().score) << " to "
+              << F(9,6, std::min(global_score_cut_,out_points_p->back().score)) << " rate " << KMGT(pd.hsearch_rate) << "/s/t " << std::endl;
+    }
+
+    return out_points_p;
+}
+
 shared_ptr<std::vector<SearchPoint>> 
 HSearchFinishTask::return_search_points( 
     shared_ptr<std::vector<SearchPoint>> search_points_p, 
@@ -365,6 +625,8 @@ HSearchFinishTask::return_search_points(
     search_points.resize(good_points);
 
     pd.beam_multiplier = 1;
+    pd.hsearch_sorted_points = nullptr;
+    pd.hsearch_nsorted = 0;
 
     std::cout << "total non-0 space size was approx " << float(pd.non0_space_size)*1024.0*1024.0*1024.0 << " grid points" << std::endl;
     std::cout << "total search effort " << KMGT(pd.total_search_effort) << std::endl;
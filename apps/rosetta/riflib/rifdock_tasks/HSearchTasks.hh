@@ -71,17 +71,29 @@ struct HSearchInit : public SearchPointTask {
         RifDockData & rdd, 
         ProtocolData & pd ) override;
 
+    void
+    restore_state( RifDockData & rdd, ProtocolData & pd ) override;
+
+private:
+    void
+    setup_scaffolds( RifDockData & rdd, ProtocolData & pd );
+
 };
 
 struct HSearchScoreAtReslTask : public SearchPointTask {
 
+    // with num_to_select > 0, the best num_to_select * beam_multiplier points are picked by
+    // the scoring threads and moved to the front, sorted, so HSearchFilterSortTask and
+    // HSearchScaleToReslTask don't need their own passes
     HSearchScoreAtReslTask(
         int director_resl,
         int rif_resl,
-        float tether_to_input_position_cut ) :
+        float tether_to_input_position_cut,
+        uint64_t num_to_select = 0 ) :
         director_resl_( director_resl ),
         rif_resl_( rif_resl ),
-        tether_to_input_position_cut_( tether_to_input_position_cut )
+        tether_to_input_position_cut_( tether_to_input_position_cut ),
+        num_to_select_( num_to_select )
         {}
 
     shared_ptr<std::vector<SearchPoint>> 
@@ -94,6 +106,7 @@ private:
     int director_resl_;
     int rif_resl_;
     float tether_to_input_position_cut_;
+    uint64_t num_to_select_;
 
 };
 
@@ -152,6 +165,43 @@ private:
 
 };
 
+// HSearchScaleToReslTask, HSearchScoreAtReslTask and HSearchFilterSortTask (with prune_extra)
+// in one pass: children of the input points are scored as they are generated and only the
+// best num_to_keep * beam_multiplier are ever stored, or the adaptive beam's largest size
+struct HSearchFusedStageTask : public SearchPointTask {
+
+    HSearchFusedStageTask(
+        int current_resl,
+        int target_resl,
+        int DIMPOW2,
+        uint64_t num_to_keep,
+        float global_score_cut,
+        float tether_to_input_position_cut
+         ) :
+        current_resl_( current_resl ),
+        target_resl_( target_resl ),
+        DIMPOW2_( DIMPOW2 ),
+        num_to_keep_( num_to_keep ),
+        global_score_cut_( global_score_cut ),
+        tether_to_input_position_cut_( tether_to_input_position_cut )
+        {}
+
+    shared_ptr<std::vector<SearchPoint>> 
+    return_search_points( 
+        shared_ptr<std::vector<SearchPoint>> search_points, 
+        RifDockData & rdd, 
+        ProtocolData & pd ) override;
+
+private:
+    int current_resl_;
+    int target_resl_;
+    int DIMPOW2_;
+    uint64_t num_to_keep_;
+    float global_score_cut_;
+    float tether_to_input_position_cut_;
+
+};
+
 struct HSearchFinishTask : public SearchPointTask {
 
     HSearchFinishTask(
@@ -103,6 +103,11 @@ HackPackTask::return_search_point_with_rotss(
     std::cout << "packing w/rif rofts ";
 
 
+    // the packers live across tasks, only count this task's packs
+    for ( shared_ptr< ::scheme::search::HackPack> const & packer : rdd.rif_factory->get_packperthread( rdd.packing_objectives[rif_resl_] ) ) {
+        packer->reset_stats();
+    }
+
     std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
     start = std::chrono::high_resolution_clock::now();
 
@@ -152,6 +157,20 @@ HackPackTask::return_search_point_with_rotss(
     std::cout << "packing rate: " << (double)pd.npack/elapsed_seconds_pack.count()                   << " iface packs per second" << std::endl;
     std::cout << "packing rate: " << (double)pd.npack/elapsed_seconds_pack.count()/omp_max_threads() << " iface packs per second per thread" << std::endl;
 
+    {
+        uint64_t dee_total = 0, dee_pruned = 0, npacks = 0, npacks_exact = 0;
+        for ( shared_ptr< ::scheme::search::HackPack> const & packer : rdd.rif_factory->get_packperthread( rdd.packing_objectives[rif_resl_] ) ) {
+            dee_total    += packer->dee_nrots_total_;
+            dee_pruned   += packer->dee_nrots_pruned_;
+            npacks       += packer->npacks_;
+            npacks_exact += packer->npacks_exact_;
+        }
+        if ( rdd.packopts.dee_prune ) {
+            std::cout << "dead end elimination pruned " << KMGT(dee_pruned) << " of " << KMGT(dee_total) << " rotamers" << std::endl;
+        }
+        std::cout << "packed exactly (tree decomposition): " << KMGT(npacks_exact) << " of " << KMGT(npacks) << " packs" << std::endl;
+    }
+
 
 
     std::cout << "full sort of packed samples" << std::endl;
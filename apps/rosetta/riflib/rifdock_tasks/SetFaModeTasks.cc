@@ -55,6 +55,11 @@ SetFaModeTask::return_any_points(
 
     return any_points;
 }
+
+void
+SetFaModeTask::restore_state( RifDockData & rdd, ProtocolData & pd ) {
+    global_set_fa_mode( fa_mode_, rdd );
+}
     
 
 // don't call this. Only to be used in the rif_dock_test test
@@ -117,7 +117,7 @@ struct RifDockIndex {
         seeding_index( seeding_index_in ),
         scaffold_index( scaffold_index_in ) {}
 
-    bool operator==(RifDockIndex const & o) {
+    bool operator==(RifDockIndex const & o) const {
       return (
         nest_index == o.nest_index &&
         seeding_index == o.seeding_index &&
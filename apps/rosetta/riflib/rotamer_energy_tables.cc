@@ -23,6 +23,7 @@
 #include <core/conformation/ResidueFactory.hh>
 #include <core/scoring/ScoreFunction.hh>
 
+#include <utility/file/FileName.hh>
 #include <utility/file/file_sys_util.hh>
 #include <utility/io/izstream.hh>
 #include <utility/io/ozstream.hh>
@@ -40,16 +41,148 @@
 #include <riflib/util.hh>
 #include <riflib/rosetta_field.hh>
 
+#include <boost/functional/hash/hash.hpp>
 #include <boost/multi_array.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <exception>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 
+#include <unistd.h>
+
 namespace devel {
 namespace scheme {
 
 using ObjexxFCL::format::I;
 
+// the score function one-body rotamer energies are computed with
+static
+core::scoring::ScoreFunctionOP
+make_onebody_score_function(){
+	// core::scoring::ScoreFunctionOP score_func = core::scoring::ScoreFunctionFactory::create_score_function( "talaris2014" );
+	// score_func->set_etable( "FA_STANDARD_SOFT" );
+	// // score_func->set_weight( core::scoring::fa_rep, score_func->get_weight(core::scoring::fa_rep)*0.67 );
+	core::scoring::ScoreFunctionOP score_func = core::scoring::get_score_function();
+	score_func->set_weight( core::scoring::fa_dun, score_func->get_weight(core::scoring::fa_dun)*0.67 );
+
+	core::scoring::methods::EnergyMethodOptions opts = score_func->energy_method_options();
+	core::scoring::hbonds::HBondOptions hopts = opts.hbond_options();
+	hopts.use_hb_env_dep( false );
+	opts.hbond_options( hopts );
+	score_func->set_energy_method_options( opts );
+	return score_func;
+}
+
+uint64_t
+onebody_score_function_key(){
+	static uint64_t const key = [](){
+		core::scoring::ScoreFunctionOP score_func = make_onebody_score_function();
+		std::size_t h = 0;
+		for( int i = 1; i <= core::scoring::n_score_types; ++i ){
+			boost::hash_combine( h, (double)score_func->get_weight( core::scoring::ScoreType(i) ) );
+		}
+		core::scoring::methods::EnergyMethodOptions const & opts = score_func->energy_method_options();
+		boost::hash_combine( h, opts.hbond_options().use_hb_env_dep() );
+		std::ostringstream optstr; // everything else, etable, hbond and elec options etc.
+		opts.show( optstr );
+		boost::hash_combine( h, optstr.str() );
+		return (uint64_t)h;
+	}();
+	return key;
+}
+
+uint64_t
+scaffold_tables_content_key(
+	core::pose::Pose const & scaffold,
+	utility::vector1<core::Size> const & scaffold_res,
+	devel::scheme::RotamerIndex const & rot_index
+){
+	std::size_t h = 0;
+	boost::hash_combine( h, scaffold.size() );
+	for( int ir = 1; ir <= scaffold.size(); ++ir ){
+		core::conformation::Residue const & res( scaffold.residue(ir) );
+		boost::hash_combine( h, res.name() );
+		for( int ia = 1; ia <= res.natoms(); ++ia ){
+			boost::hash_combine( h, (float)res.xyz(ia).x() );
+			boost::hash_combine( h, (float)res.xyz(ia).y() );
+			boost::hash_combine( h, (float)res.xyz(ia).z() );
+		}
+	}
+	boost::hash_range( h, scaffold_res.begin(), scaffold_res.end() );
+	boost::hash_combine( h, rot_index.size() );
+	boost::hash_combine( h, rot_index.validation_hash() );
+	boost::hash_combine( h, onebody_score_function_key() );
+	return h;
+}
+
+std::string
+flat_table_cache_file( std::string const & dir, std::string const & prefix, uint64_t key ){
+	if( dir.empty() ) return "";
+	char hex[17];
+	std::snprintf( hex, sizeof(hex), "%016llx", (unsigned long long)key );
+	return dir + "/" + prefix + "_" + hex + ".bin";
+}
+
+// write to a temp file and rename, so concurrent runs sharing a cache dir never see partial files
+template< class Writer >
+void
+write_flat_table_cache_file( std::string const & fname, Writer const & writer ){
+	utility::file::create_directory_recursive( utility::file::FileName(fname).path() );
+	std::string const tmpfname = fname + ".tmp" + boost::lexical_cast<std::string>( ::getpid() );
+	{
+		std::ofstream out( tmpfname.c_str(), std::ios::binary );
+		writer( out );
+		if( !out.good() ){
+			std::cout << "WARNING: failed to write table cache file " << fname << std::endl;
+			std::remove( tmpfname.c_str() );
+			return;
+		}
+	}
+	std::rename( tmpfname.c_str(), fname.c_str() );
+}
+
+static char const * flat_onebody_magic = "1BFLAT01";
+
+bool
+load_flat_onebody(
+	std::string const & fname,
+	uint64_t key,
+	std::vector<std::vector<float> > & onebody
+){
+	MappedFile mapped( fname );
+	uint64_t header[3];
+	if( mapped.size() < 8+sizeof(header) || std::memcmp( mapped.data(), flat_onebody_magic, 8 ) ) return false;
+	std::memcpy( header, mapped.data()+8, sizeof(header) );
+	size_t const nres = header[1], nrot = header[2];
+	if( header[0] != key || mapped.size() != 8+sizeof(header)+nres*nrot*sizeof(float) ) return false;
+	float const * data = (float const *)( mapped.data()+8+sizeof(header) );
+	onebody.resize( nres );
+	for( size_t i = 0; i < nres; ++i ) onebody[i].assign( data + i*nrot, data + (i+1)*nrot );
+	return true;
+}
+
+void
+save_flat_onebody(
+	std::string const & fname,
+	uint64_t key,
+	std::vector<std::vector<float> > const & onebody
+){
+	write_flat_table_cache_file( fname, [&]( std::ostream & out ){
+		uint64_t const header[3] = { key, onebody.size(), onebody.front().size() };
+		out.write( flat_onebody_magic, 8 );
+		out.write( (char const*)header, sizeof(header) );
+		for( auto const & row : onebody ){
+			runtime_assert( row.size() == header[2] );
+			out.write( (char const*)row.data(), row.size()*sizeof(float) );
+		}
+	});
+}
+
 void get_onebody_rotamer_energies(
 	core::pose::Pose const & scaffold,
 	utility::vector1<core::Size> const & scaffold_res,
@@ -59,11 +192,15 @@ void get_onebody_rotamer_energies(
 	std::string const & cachefile,
 	bool replace_with_ala,
 	float favorable_1be_multiplier,
-	float favorable_1be_cutoff
+	float favorable_1be_cutoff,
+	std::string const & flatcachefile,
+	uint64_t flatkey
 ){
 	utility::io::izstream in;
 	std::string cachefile_found = devel::scheme::open_for_read_on_path( cachepath, cachefile, in );
-	if( cachefile.size() && cachefile_found.size() ){
+	if( flatcachefile.size() && load_flat_onebody( flatcachefile, flatkey, scaffold_onebody_rotamer_energies ) ){
+		std::cout << "reading onebody energies from: " << flatcachefile << std::endl;
+	} else if( cachefile.size() && cachefile_found.size() ){
 		std::cout << "reading onebody energies from: " << cachefile << std::endl;
 		// utility::io::izstream in( cachefile );
 		size_t s1,s2;
@@ -82,6 +219,10 @@ void get_onebody_rotamer_energies(
 		std::string test;
 		runtime_assert_msg( !(in >> test), "something left in buffer from: "+cachefile_found ); // nothing left
 		in.close();
+		if( flatcachefile.size() ){
+			std::cout << "saving onebody energies to: " << flatcachefile << std::endl;
+			save_flat_onebody( flatcachefile, flatkey, scaffold_onebody_rotamer_energies );
+		}
 	} else {
 		devel::scheme::compute_onebody_rotamer_energies(
 			scaffold,
@@ -108,6 +249,10 @@ void get_onebody_rotamer_energies(
 			}
 			out.close();
 		}
+		if( flatcachefile.size() ){
+			std::cout << "saving onebody energies to: " << flatcachefile << std::endl;
+			save_flat_onebody( flatcachefile, flatkey, scaffold_onebody_rotamer_energies );
+		}
 	}
 
 	for( int ir = 1; ir <= scaffold_onebody_rotamer_energies.size(); ++ir ){
@@ -137,19 +282,7 @@ compute_onebody_rotamer_energies(
 
 	std::vector<core::scoring::ScoreFunctionOP> score_func_per_thread(omp_max_threads_1());
 	for( auto & score_func : score_func_per_thread ){
-		// score_func = core::scoring::ScoreFunctionFactory::create_score_function( "talaris2014" );
-		// score_func->set_etable( "FA_STANDARD_SOFT" );
-		// // score_func->set_weight( core::scoring::fa_rep, score_func->get_weight(core::scoring::fa_rep)*0.67 );
-
-		
-		score_func = core::scoring::get_score_function();
-		score_func->set_weight( core::scoring::fa_dun, score_func->get_weight(core::scoring::fa_dun)*0.67 );
-
-		core::scoring::methods::EnergyMethodOptions opts = score_func->energy_method_options();
-		core::scoring::hbonds::HBondOptions hopts = opts.hbond_options();
-		hopts.use_hb_env_dep( false );
-		opts.hbond_options( hopts );
-		score_func->set_energy_method_options( opts );
+		score_func = make_onebody_score_function();
 	}
 
 	// make all ala or gly
@@ -161,6 +294,17 @@ compute_onebody_rotamer_energies(
 
 	onebody_rotamer_energies.resize( bbone.size() );
 	std::vector<core::pose::Pose> pose_per_thread( omp_max_threads_1(), bbone );
+
+	// rotamers that differ only in proton chis are scored by resetting those chis on their
+	// protonchi_parent's residue rather than building and placing a new residue each time.
+	// the full score still has to be recomputed, rosetta's terms all see the hydrogens
+	std::vector< std::vector<int> > protonchi_group( rot_index.size() );
+	for( int jr = 0; jr < rot_index.size(); ++jr ){
+		int parent = rot_index.protonchi_parent(jr);
+		if( rot_index.resname(parent) != rot_index.resname(jr) ) parent = jr;
+		protonchi_group[parent].push_back( jr ); // parent is first, parent <= jr
+	}
+
 	std::cout << "compute_onebody_rotamer_energies " << bbone.size() << "/" << rot_index.size();
 	std::exception_ptr exception = nullptr;
 	#ifdef USE_OPENMP
@@ -184,6 +328,7 @@ compute_onebody_rotamer_energies(
 			#endif
 			std::cout << (100.0*ir)/work_pose.size() << "% "; std::cout.flush();
 			for( int jr = 0; jr < rot_index.size(); ++jr ){
+				if( protonchi_group[jr].empty() ) continue; // scored with its protonchi_parent
 				std::string rot_name;
 				core::conformation::ResidueOP rot;
 				auto dl_map_it = rot_index.d_l_map_.find(rot_index.resname(jr));
@@ -209,10 +354,15 @@ compute_onebody_rotamer_energies(
 				// 	core::conformation::ResidueOP rot = core::conformation::ResidueFactory::create_residue( rts.lock()->name_map( rot_index.resname(jr) ) );
 				// }
 				work_pose.replace_residue( ir, *rot, true );
-				for( int k = 0; k < rot_index.nchi(jr); ++k ){
+				for( int k = 0; k < rot_index.nchi_noproton(jr); ++k ){
 					work_pose.set_chi( k+1, ir, rot_index.chi( jr, k ) );
 				}
-				onebody_rotamer_energies[ir-1][jr] = score_func->score( work_pose ) - base_score;
+				for( int jchild : protonchi_group[jr] ){
+					for( int k = rot_index.nchi_noproton(jchild); k < rot_index.nchi(jchild); ++k ){
+						work_pose.set_chi( k+1, ir, rot_index.chi( jchild, k ) );
+					}
+					onebody_rotamer_energies[ir-1][jchild] = score_func->score( work_pose ) - base_score;
+				}
 				// std::cout << "fa_dun " << ir << " " << jr << " "<< work_pose.energies().residue_total_energies(ir)[core::scoring::fa_dun] << std::endl;
 				work_pose.replace_residue( ir, *ala, true );
 				// if( jr > 2	 ) break;
@@ -433,6 +583,244 @@ void get_per_rotamer_rf_tables(
 
 
 
+// rep[rotsel] is the first selected rotamer with the same protonchi_parent, i.e. the same heavy atoms
+template< class Sel2All >
+std::vector<int>
+protonchi_representatives(
+	devel::scheme::RotamerIndex const & rot_index,
+	Sel2All const & sel2all,
+	int nsel
+){
+	std::vector<int> rep( nsel );
+	std::unordered_map<int,int> first_with_parent;
+	for( int rotsel = 0; rotsel < nsel; ++rotsel ){
+		int const parent = rot_index.protonchi_parent( sel2all[rotsel] );
+		rep[rotsel] = first_with_parent.insert( std::make_pair( parent, rotsel ) ).first->second;
+	}
+	return rep;
+}
+
+// heavy atoms beyond the CB (which is #3 here) of a set of selected rotamers, placed in
+// another residue's frame, grouped by atom type, and sorted by nheavyatoms within each group
+// only rotamers that are their own protonchi representative are included
+struct TwobodyAtomsByType {
+	std::vector< std::vector< Eigen::Vector3f > > pos;
+	std::vector< std::vector< int > > sel, nheavy;
+	int min_nheavy;
+
+	template< class Sel2All >
+	void init(
+		devel::scheme::RotamerIndex const & rot_index,
+		Sel2All const & sel2all,
+		int nsel,
+		std::vector<int> const & rep,
+		EigenXform const & xform
+	){
+		pos.assign( 22, std::vector< Eigen::Vector3f >() );
+		sel.assign( 22, std::vector< int >() );
+		nheavy.assign( 22, std::vector< int >() );
+		min_nheavy = 9999;
+		std::vector< std::vector< std::pair< int, int > > > order( 22 ); // (nheavy, index into allpos)
+		std::vector< Eigen::Vector3f > allpos;
+		for( int rotsel = 0; rotsel < nsel; ++rotsel ){
+			if( rep[rotsel] != rotsel ) continue;
+			int const irot = sel2all[rotsel];
+			runtime_assert( irot >= 0 );
+			int const nh = rot_index.nheavyatoms(irot);
+			min_nheavy = std::min( min_nheavy, nh );
+			for( int ia = 4; ia < nh; ++ia ){
+				int const atype = rot_index.rotamers_[ irot ].atoms_[ia].type();
+				if( atype > 21 ){
+					std::cout << atype << " " << irot << " " << ia << " " << rot_index.rotamers_[irot].atoms_[ia].data().atomname << " "
+					          << rot_index.rotamers_[irot].resname_ << " " << nh << std::endl;
+				}
+				runtime_assert( atype > 0 && atype < 22 );
+				order[atype].push_back( std::make_pair( nh, allpos.size() ) );
+				allpos.push_back( xform * rot_index.rotamers_[ irot ].atoms_[ia].position() );
+				sel[atype].push_back( rotsel );
+			}
+		}
+		for( int atype = 1; atype < 22; ++atype ){
+			std::vector< std::pair<int,int> > & o = order[atype];
+			std::vector< int > rotsel( sel[atype] );
+			std::vector< int > idx( o.size() );
+			for( int k = 0; k < o.size(); ++k ) idx[k] = k;
+			std::stable_sort( idx.begin(), idx.end(), [&o]( int a, int b ){ return o[a].first < o[b].first; } );
+			for( int k = 0; k < o.size(); ++k ){
+				pos   [atype].push_back( allpos[ o[idx[k]].second ] );
+				nheavy[atype].push_back( o[idx[k]].first );
+				sel   [atype][k] = rotsel[ idx[k] ];
+			}
+		}
+	}
+	// number of atoms of atype from rotamers with fewer than nh heavy atoms
+	int count_smaller( int atype, int nh ) const {
+		return std::lower_bound( nheavy[atype].begin(), nheavy[atype].end(), nh ) - nheavy[atype].begin();
+	}
+	// scores of the first n atoms of atype, moved by xform, in field
+	template< class Field >
+	void score(
+		int atype,
+		int n,
+		EigenXform const & xform,
+		Field const & field,
+		std::vector< Eigen::Vector3f > & posbuf,
+		std::vector< float > & scorebuf
+	) const {
+		posbuf.resize( n );
+		scorebuf.resize( n );
+		for( int k = 0; k < n; ++k ) posbuf[k] = xform * pos[atype][k];
+		field.at_batch( n, &posbuf[0], &scorebuf[0] );
+	}
+};
+
+// fill in (or clear) twob block ir,jr, ir > jr, given the backbone frames of ir and jr
+// requires the onebody filter already set up
+void
+make_twobody_block(
+	int ir,
+	int jr,
+	EigenXform const & bbi,
+	EigenXform const & bbj,
+	devel::scheme::RotamerIndex const & rot_index,
+	RotamerRFTablesManager & rotrfmanager,
+	MakeTwobodyOpts const & opts,
+	::scheme::objective::storage::TwoBodyTable<float> & twob
+){
+	int const nseli = twob.nsel_[ir];
+	int const nselj = twob.nsel_[jr];
+	EigenXform X2i = bbi.inverse() * bbj;
+	EigenXform X2j = bbj.inverse() * bbi;
+	auto const & to_sp( rot_index.to_structural_parent_frame_ );
+
+	// lj/sol only sees heavy atoms, so it is computed for one rotamer per protonchi_parent
+	// and copied to the rest below. it is looked up in the rf table of the rotamer with more
+	// heavy atoms, scoring the atoms beyond the CB of the other. place those atoms of all
+	// selected rotamers in the other residue's frame once, grouped by atom type and sorted by
+	// nheavyatoms so the atoms scored against a given rotamer's tables are a prefix of each group
+	std::vector<int> const irep = protonchi_representatives( rot_index, twob.sel2all_[ir], nseli );
+	std::vector<int> const jrep = protonchi_representatives( rot_index, twob.sel2all_[jr], nselj );
+	TwobodyAtomsByType jatoms, iatoms;
+	jatoms.init( rot_index, twob.sel2all_[jr], nselj, jrep, X2i );
+	iatoms.init( rot_index, twob.sel2all_[ir], nseli, irep, X2j );
+
+	twob.init_twobody(ir,jr);
+	float * block = &twob.twobody_[ir][jr][0][0];
+	std::fill( block, block + nseli*nselj, 0.0f );
+
+	std::vector< Eigen::Vector3f > posbuf;
+	std::vector< float > scorebuf;
+	float maxatomscore = -9e9;
+
+	// j atoms vs. irot tables, irot strictly bigger
+	for( int irotsel = 0; irotsel < nseli; ++irotsel ){
+		if( irep[irotsel] != irotsel ) continue;
+		int const irot = twob.sel2all_[ir][irotsel];
+		runtime_assert( irot >= 0 );
+		int const nheavy = rot_index.nheavyatoms(irot);
+		if( nheavy <= jatoms.min_nheavy ) continue;
+		auto const & tables = rotrfmanager.get_rotamer_rf_tables(irot);
+		if( !tables[1] ){
+			if( rot_index.resname(irot)!="ALA"&&rot_index.resname(irot)!="GLY" && rot_index.resname(irot)!="DAL"){
+				utility_exit_with_message( "no rotrf table for "+str(irot)+" / "+ str(ir)+rot_index.resname(irot)
+				    + " other is" + str(jr) );
+			}
+			continue;
+		}
+		float * row = block + irotsel*nselj;
+		for( int atype = 1; atype < 22; ++atype ){
+			int const n = jatoms.count_smaller( atype, nheavy );
+			if( n == 0 ) continue;
+			jatoms.score( atype, n, to_sp.at(irot), *tables.at(atype), posbuf, scorebuf );
+			std::vector<int> const & sel = jatoms.sel[atype];
+			for( int k = 0; k < n; ++k ){
+				row[ sel[k] ] += scorebuf[k];
+				maxatomscore = std::max( maxatomscore, scorebuf[k] );
+			}
+		}
+	}
+	// i atoms vs. jrot tables, jrot at least as big
+	for( int jrotsel = 0; jrotsel < nselj; ++jrotsel ){
+		if( jrep[jrotsel] != jrotsel ) continue;
+		int const jrot = twob.sel2all_[jr][jrotsel];
+		runtime_assert( jrot >= 0 );
+		int const nheavy = rot_index.nheavyatoms(jrot);
+		if( nheavy < iatoms.min_nheavy ) continue;
+		auto const & tables = rotrfmanager.get_rotamer_rf_tables(jrot);
+		if( !tables[1] ){
+			if( rot_index.resname(jrot)!="ALA"&&rot_index.resname(jrot)!="GLY" && rot_index.resname(jrot)!="DAL"){
+				utility_exit_with_message( "no rotrf table for "+str(jrot)+" / "+str(jr)+rot_index.resname(jrot)
+				    + " other is" + str(ir) );
+			}
+			continue;
+		}
+		for( int atype = 1; atype < 22; ++atype ){
+			int const n = iatoms.count_smaller( atype, nheavy+1 );
+			if( n == 0 ) continue;
+			iatoms.score( atype, n, to_sp.at(jrot), *tables.at(atype), posbuf, scorebuf );
+			std::vector<int> const & sel = iatoms.sel[atype];
+			for( int k = 0; k < n; ++k ){
+				block[ sel[k]*nselj + jrotsel ] += scorebuf[k];
+				maxatomscore = std::max( maxatomscore, scorebuf[k] );
+			}
+		}
+	}
+	runtime_assert_msg( maxatomscore < 9999.0, "very high atomscore" );
+	for( int irotsel = 0; irotsel < nseli; ++irotsel ){
+		float const * reprow = block + irep[irotsel]*nselj;
+		float * row = block + irotsel*nselj;
+		for( int jrotsel = 0; jrotsel < nselj; ++jrotsel ){
+			row[jrotsel] = reprow[ jrep[jrotsel] ];
+		}
+	}
+
+	// this is basically a copy of what's in ScoreRotamerVsTarget, without the multidentate stuff
+	std::vector< HBondRay > iacc, idon;
+	for( int irotsel = 0; irotsel < nseli; ++irotsel ){
+		int const irot = twob.sel2all_[ir][irotsel];
+		if( rot_index.rotamer(irot).acceptors_.size() == 0 &&
+			rot_index.rotamer(irot).donors_   .size() == 0 ) continue;
+		iacc = rot_index.rotamer(irot).acceptors_;
+		idon = rot_index.rotamer(irot).donors_;
+		for( HBondRay & hr : iacc ){
+			Eigen::Vector3f dirpos = hr.horb_cen + hr.direction;
+			hr.horb_cen  = X2j * hr.horb_cen;
+			hr.direction = X2j * dirpos - hr.horb_cen;
+		}
+		for( HBondRay & hr : idon ){
+			Eigen::Vector3f dirpos = hr.horb_cen + hr.direction;
+			hr.horb_cen  = X2j * hr.horb_cen;
+			hr.direction = X2j * dirpos - hr.horb_cen;
+		}
+		float * row = block + irotsel*nselj;
+		for( int jrotsel = 0; jrotsel < nselj; ++jrotsel ){
+			int const jrot = twob.sel2all_[jr][jrotsel];
+			float hbscore = 0.0;
+			for( HBondRay const & hr_rot_acc : iacc ){
+				for( HBondRay const & hr_tgt_don : rot_index.rotamer(jrot).donors_ ){
+					hbscore += score_hbond_rays( hr_tgt_don, hr_rot_acc ) * opts.hbond_weight;
+				}
+			}
+			for( HBondRay const & hr_rot_don : idon ){
+				for( HBondRay const & hr_tgt_acc : rot_index.rotamer(jrot).acceptors_ ){
+					hbscore += score_hbond_rays( hr_rot_don, hr_tgt_acc ) * opts.hbond_weight;
+				}
+			}
+			row[jrotsel] += hbscore;
+		}
+	}
+
+	float minscore=9e9, maxscore=-9e9;
+	for( int k = 0; k < nseli*nselj; ++k ){
+		block[k] = std::min( block[k], 12345.0f );
+		minscore = std::min( minscore, block[k] );
+		maxscore = std::max( maxscore, block[k] );
+	}
+	if( minscore > -0.01 && maxscore < 0.01 ){
+		twob.clear_twobody( ir, jr );
+	}
+}
+
 void
 make_twobody_tables(
 	core::pose::Pose const & scaffold,
@@ -475,150 +863,62 @@ make_twobody_tables(
 
 	double const dthresh2 = opts.distance_cut * opts.distance_cut;
 
+	// (ir,jr) pair tasks, biggest first so dynamic scheduling balances well
+	std::vector< std::pair<int,int> > pairs;
+	for( int ir = 0; ir < scaffold.size(); ++ir ){
+		if( !scaffold.residue(ir+1).is_protein() ) continue;
+		for( int jr = 0; jr < ir; ++jr ){
+			if( !scaffold.residue(jr+1).is_protein() ) continue;
+			double dis2 = scaffold.residue(ir+1).xyz("CA").distance_squared( scaffold.residue(jr+1).xyz("CA") );
+			if( dis2 > dthresh2 ) continue;
+			if( twob.nsel_[ir] == 0 || twob.nsel_[jr] == 0 ) continue;
+			pairs.push_back( std::make_pair( ir, jr ) );
+		}
+	}
+
+	if( opts.lazy ){
+		// blocks are made on first access, so rot_index and rotrfmanager must outlive twob
+		int const nres = scaffold.size();
+		std::vector< EigenXform, Eigen::aligned_allocator<EigenXform> > bb( nres, EigenXform::Identity() );
+		std::vector< bool > near( nres*nres, false );
+		for( auto const & p : pairs ){
+			for( int r : { p.first, p.second } ){
+				bb[r] = BackboneActor( scaffold.residue(r+1).xyz("N"), scaffold.residue(r+1).xyz("CA"), scaffold.residue(r+1).xyz("C") ).position();
+			}
+			near[ p.first*nres + p.second ] = true;
+		}
+		devel::scheme::RotamerIndex const * rot_index_p = &rot_index;
+		RotamerRFTablesManager * rotrfmanager_p = &rotrfmanager;
+		twob.make_lazy( [=]( ::scheme::objective::storage::TwoBodyTable<float> & t, int ir, int jr ){
+			if( !near[ ir*nres + jr ] ) return;
+			make_twobody_block( ir, jr, bb[ir], bb[jr], *rot_index_p, *rotrfmanager_p, opts, t );
+			if( opts.favorable_2body_multiplier != 1 ){
+				float * block = t.twobody_[ir][jr].data();
+				for( size_t k = 0; k < t.twobody_[ir][jr].num_elements(); ++k ){
+					if( block[k] < 0 ) block[k] *= opts.favorable_2body_multiplier;
+				}
+			}
+		});
+		return;
+	}
+
+	std::stable_sort( pairs.begin(), pairs.end(),
+		[&twob]( std::pair<int,int> const & a, std::pair<int,int> const & b ){
+			return twob.nsel_[a.first]*twob.nsel_[a.second] > twob.nsel_[b.first]*twob.nsel_[b.second]; } );
+
 	std::exception_ptr exception = nullptr;
 	#ifdef USE_OPENMP
 	#pragma omp parallel for schedule(dynamic,1)
 	#endif
-	for( int ir = 0; ir < scaffold.size(); ++ir ){
+	for( int ipair = 0; ipair < pairs.size(); ++ipair ){
 		if( exception ) continue;
 		try {
-			if( !scaffold.residue(ir+1).is_protein() ) continue;
+			int const ir = pairs[ipair].first;
+			int const jr = pairs[ipair].second;
 			BackboneActor bbi( scaffold.residue(ir+1).xyz("N"), scaffold.residue(ir+1).xyz("CA"), scaffold.residue(ir+1).xyz("C") );
+			BackboneActor bbj( scaffold.residue(jr+1).xyz("N"), scaffold.residue(jr+1).xyz("CA"), scaffold.residue(jr+1).xyz("C") );
+			make_twobody_block( ir, jr, bbi.position(), bbj.position(), rot_index, rotrfmanager, opts, twob );
 
-			// #ifdef USE_OPENMP
-			// #pragma omp critical
-			// #endif
-			// std::cout << "compute twobody for ir-* " << ir << std::endl;
-
-			for( int jr = 0; jr < ir; ++jr ){
-				if( !scaffold.residue(jr+1).is_protein() ) continue;
-
-				double dis2 = scaffold.residue(ir+1).xyz("CA").distance_squared( scaffold.residue(jr+1).xyz("CA") );
-				// double dthr = scaffold.residue(ir).nbr_radius() +                   scaffold.residue(jr+1).nbr_radius();
-
-				if( dis2 > dthresh2 ){
-					// twob.clear_twobody(ir,jr); // no need
-					continue;
-				}
-
-				BackboneActor bbj( scaffold.residue(jr+1).xyz("N"), scaffold.residue(jr+1).xyz("CA"), scaffold.residue(jr+1).xyz("C") );
-
-				twob.init_twobody(ir,jr);
-
-				EigenXform X2i = bbi.position().inverse() * bbj.position();
-				EigenXform X2j = bbj.position().inverse() * bbi.position();
-				auto const & to_sp( rot_index.to_structural_parent_frame_ );
-
-				float minscore=9e9, maxscore=-9e9;
-				std::vector<int> randirotsel( twob.nsel_[ir] );
-				for( int q=0; q<randirotsel.size(); ++q ) randirotsel[q] = randirotsel.size()-1-q;
-				// this is fucked somehow... random would be better, reversed helps some
-				// random_permutation( randirotsel, numeric::random::rg() );
-				for( int irotsel_irand = 0; irotsel_irand < twob.nsel_[ir]; ++irotsel_irand ){
-					int irotsel = randirotsel[ irotsel_irand ];
-					int irot = twob.sel2all_[ir][irotsel];
-					runtime_assert( irot >= 0 );
-					for( int jrotsel = 0; jrotsel < twob.nsel_[jr]; ++jrotsel ){
-						int jrot = twob.sel2all_[jr][jrotsel];
-						runtime_assert( jrot >= 0 );
-
-						twob.twobody_[ir][jr][irotsel][jrotsel] = 0.0; // set to 0
-
-						// get lj, sol
-						if( rot_index.nheavyatoms(irot) > rot_index.nheavyatoms(jrot) ){ // irot is bigger
-							if( rotrfmanager.get_rotamer_rf_tables(irot)[ 1 ] ){
-								for( int ja = 4; ja < rot_index.nheavyatoms(jrot); ++ja ){ // use only heavy atoms beyond the CB (which is #3 here)
-									int jatype = rot_index.rotamers_[ jrot ].atoms_[ja].type();
-									runtime_assert( jatype > 0 && jatype < 22 );
-									Eigen::Vector3f pos_ja = to_sp.at(irot) * X2i * rot_index.rotamers_[ jrot ].atoms_[ja].position();
-									// runtime_assert( rotrfmanager.get_rotamer_rf_tables(irot).size() );
-									float const atomscore = rotrfmanager.get_rotamer_rf_tables(irot).at( jatype )->at( pos_ja );
-									runtime_assert_msg( atomscore < 9999.0, "very high atomscore" );
-									twob.twobody_[ir][jr][irotsel][jrotsel] += atomscore;
-								}
-							} else {
-								if( rot_index.resname(irot)!="ALA"&&rot_index.resname(irot)!="GLY" && rot_index.resname(irot)!="DAL"){
-									utility_exit_with_message( "no rotrf table for "+str(irot)+" / "+ str(ir)+rot_index.resname(irot)
-									    + " other is" + str(jr)+rot_index.resname(jrot) );
-								}
-							}
-						} else {
-							if( rotrfmanager.get_rotamer_rf_tables(jrot)[ 1 ] ){
-								for( int ia = 4; ia < rot_index.nheavyatoms(irot); ++ia ){ // use only heavy atoms beyond the CB (which is #3 here)
-									int iatype = rot_index.rotamers_[ irot ].atoms_[ia].type();
-									if( iatype > 21 ){
-										std::cout << iatype << " " << irot << " " << ia << " " << rot_index.rotamers_[irot].atoms_[ia].data().atomname << " "
-										          << rot_index.rotamers_[irot].resname_ << " " << rot_index.nheavyatoms(irot) << std::endl;
-									}
-									runtime_assert( iatype > 0 && iatype < 22 );
-									Eigen::Vector3f pos_ia = to_sp.at(jrot) * X2j * rot_index.rotamers_[ irot ].atoms_[ia].position();
-									// runtime_assert( rotrfmanager.get_rotamer_rf_tables(jrot).size() );
-									float const atomscore = rotrfmanager.get_rotamer_rf_tables(jrot).at( iatype )->at( pos_ia );
-									runtime_assert_msg( atomscore < 9999.0, "very high atomscore" );
-									twob.twobody_[ir][jr][irotsel][jrotsel] += atomscore;
-								}
-							} else {
-								if( rot_index.resname(jrot)!="ALA"&&rot_index.resname(jrot)!="GLY" && rot_index.resname(jrot)!="DAL"){
-									utility_exit_with_message( "no rotrf table for "+str(jrot)+" / "+str(jr)+rot_index.resname(jrot)
-									    + " other is" + str(ir)+rot_index.resname(irot) );
-								}
-							}
-						}
-
-						// this is basically a copy of what's in ScoreRotamerVsTarget, without the multidentate stuff
-						if( rot_index.rotamer(irot).acceptors_.size() > 0 ||
-							rot_index.rotamer(irot).donors_   .size() > 0 )
-						{
-							float hbscore = 0.0;
-							for( int i_hr_rot_acc = 0; i_hr_rot_acc < rot_index.rotamer(irot).acceptors_.size(); ++i_hr_rot_acc )
-							{
-								HBondRay hr_rot_acc = rot_index.rotamer(irot).acceptors_[i_hr_rot_acc];
-								Eigen::Vector3f dirpos = hr_rot_acc.horb_cen + hr_rot_acc.direction;
-								hr_rot_acc.horb_cen  = X2j * hr_rot_acc.horb_cen;
-								hr_rot_acc.direction = X2j * dirpos - hr_rot_acc.horb_cen;
-								for( int i_hr_tgt_don = 0; i_hr_tgt_don < rot_index.rotamer(jrot).donors_.size(); ++i_hr_tgt_don )
-								{
-									HBondRay const & hr_tgt_don = rot_index.rotamer(jrot).donors_[i_hr_tgt_don];
-									float const thishb = score_hbond_rays( hr_tgt_don, hr_rot_acc );
-									hbscore += thishb * opts.hbond_weight;
-								}
-							}
-							for( int i_hr_rot_don = 0; i_hr_rot_don < rot_index.rotamer(irot).donors_.size(); ++i_hr_rot_don )
-							{
-								HBondRay hr_rot_don = rot_index.rotamer(irot).donors_[i_hr_rot_don];
-								Eigen::Vector3f dirpos = hr_rot_don.horb_cen + hr_rot_don.direction;
-								hr_rot_don.horb_cen  = X2j * hr_rot_don.horb_cen;
-								hr_rot_don.direction = X2j * dirpos - hr_rot_don.horb_cen;
-								for( int i_hr_tgt_acc = 0; i_hr_tgt_acc < rot_index.rotamer(jrot).acceptors_.size(); ++i_hr_tgt_acc )
-								{
-									HBondRay const & hr_tgt_acc = rot_index.rotamer(jrot).acceptors_[i_hr_tgt_acc];
-									float const thishb = score_hbond_rays( hr_rot_don, hr_tgt_acc );
-									hbscore += thishb * opts.hbond_weight;
-								}
-							}
-							twob.twobody_[ir][jr][irotsel][jrotsel] += hbscore;
-						}
-
-
-
-						if( twob.twobody_[ir][jr][irotsel][jrotsel] > 12345.0 ){
-							twob.twobody_[ir][jr][irotsel][jrotsel] = 12345.0;
-						}
-
-						minscore = std::min( minscore, twob.twobody_[ir][jr][irotsel][jrotsel] );
-						maxscore = std::max( maxscore, twob.twobody_[ir][jr][irotsel][jrotsel] );
-					}
-				}
-
-				if( minscore > -0.01 && maxscore < 0.01 ){
-					twob.clear_twobody( ir, jr );
-				} else {
-					// using namespace ObjexxFCL::format;
-					// #pragma omp critical
-					// std::cout << I(3,ir) << " " << I(3,jr) << " " << F(9,1,maxscore) << std::endl;
-				}
-
-			}
 		} catch( ... ) {
 			#ifdef USE_OPENMP
 			#pragma omp critical
@@ -640,28 +940,54 @@ get_twobody_tables(
 	std::vector<std::vector<float> > const & onebody_energies,
 	RotamerRFTablesManager & rotrfmanager,
 	MakeTwobodyOpts opts,
-	::scheme::objective::storage::TwoBodyTable<float> & twob
+	::scheme::objective::storage::TwoBodyTable<float> & twob,
+	std::string const & flatcachefile,
+	uint64_t flatkey
 ){
 	utility::io::izstream in;
 	std::string cachefile_found;
 	if( cachefile.size() ) cachefile_found = devel::scheme::open_for_read_on_path( cachepath, cachefile, in );
-	if( cachefile.size() && cachefile_found.size() ){
+	bool flatloaded = false;
+	if( flatcachefile.size() ){
+		MappedFile mapped( flatcachefile );
+		flatloaded = twob.load_flat( mapped.data(), mapped.size(), flatkey );
+	}
+	if( flatloaded ){
+		std::cout << "reading twobody energies from: " << flatcachefile << std::endl;
+	} else if( cachefile.size() && cachefile_found.size() ){
 		std::cout << "reading twobody energies from: " << cachefile_found << std::endl;
 		twob.load( in, description );
 		in.close();
+		if( flatcachefile.size() ){
+			std::cout << "saving twobody energies to: " << flatcachefile << std::endl;
+			write_flat_table_cache_file( flatcachefile, [&]( std::ostream & out ){ twob.save_flat( out, flatkey ); } );
+		}
 	} else {
 		twob.init( scaffold.size(), rot_index.size() );
 		make_twobody_tables( scaffold, rot_index, onebody_energies, rotrfmanager, opts, twob );
-		if( cachefile.size() ) std::cout << "created twobody energies and saving to: " << cachefile << std::endl;
-		if( description=="" ) description = "No description, Will sucks. Complain to willsheffler@gmail.com\n";
-		utility::io::ozstream out;//( cachefile );
-		devel::scheme::open_for_write_on_path( cachepath, cachefile, out, true );
-		twob.save( out, description );
-		out.close();
+		if( opts.lazy ){
+			std::cout << "twobody energies will be computed as needed, not saving to: " << cachefile << std::endl;
+		} else {
+			if( cachefile.size() ) std::cout << "created twobody energies and saving to: " << cachefile << std::endl;
+			if( description=="" ) description = "No description, Will sucks. Complain to willsheffler@gmail.com\n";
+			utility::io::ozstream out;//( cachefile );
+			devel::scheme::open_for_write_on_path( cachepath, cachefile, out, true );
+			twob.save( out, description );
+			out.close();
+			if( flatcachefile.size() ){
+				std::cout << "saving twobody energies to: " << flatcachefile << std::endl;
+				write_flat_table_cache_file( flatcachefile, [&]( std::ostream & out ){ twob.save_flat( out, flatkey ); } );
+			}
+		}
 	}
 
+	// lazy blocks get this as they are made, see make_twobody_tables
+
 
 	if ( opts.favorable_2body_multiplier != 1 ) {
+		for ( float & val : twob.arena_ ) { // tables loaded from flat files are compact
+			if ( val < 0 ) val *= opts.favorable_2body_multiplier;
+		}
 		for ( uint64_t i = 0; i < twob.twobody_.size(); i++ ) {
 			for ( uint64_t j = 0; j < twob.twobody_[i].size(); j++ ) {
 				for ( uint64_t k = 0; k < twob.twobody_[i][j].size(); k++ ) {
@@ -681,5 +1007,24 @@ get_twobody_tables(
 
 
 
-}}
+uint64_t
+twobody_tables_content_key(
+	uint64_t scaffold_key,
+	std::vector<std::vector<float> > const & onebody_energies,
+	MakeTwobodyOpts const & opts,
+	RotamerRFOpts const & rotrfopts
+){
+	std::size_t h = scaffold_key;
+	boost::hash_combine( h, onebody_score_function_key() ); // also in scaffold_key, but don't rely on it
+	for( auto const & row : onebody_energies ) boost::hash_range( h, row.begin(), row.end() );
+	boost::hash_combine( h, opts.onebody_threshold );
+	boost::hash_combine( h, opts.distance_cut );
+	boost::hash_combine( h, opts.hbond_weight );
+	boost::hash_combine( h, rotrfopts.oversample );
+	boost::hash_combine( h, rotrfopts.field_resl );
+	boost::hash_combine( h, rotrfopts.field_spread );
+	boost::hash_combine( h, rotrfopts.scale_atr );
+	return h;
+}
 
+}}
@@ -28,9 +28,30 @@ void get_onebody_rotamer_energies(
 	std::string const & cachefile,
 	bool replace_with_ala = true,
 	float favorable_1be_multiplier = 1,
-	float favorable_1be_cutoff = 0
+	float favorable_1be_cutoff = 0,
+	std::string const & flatcachefile = "", // see flat_table_cache_file, used before cachefile
+	uint64_t flatkey = 0
 );
 
+// hash of all weights and energy method options of the score function one-body rotamer energies
+// are computed with, which depends on the command line (-score:weights, hbond options, ...)
+uint64_t
+onebody_score_function_key();
+
+// content key for cached scaffold energy tables: scaffold coordinates, residue selection, rotamer
+// set and onebody_score_function_key
+uint64_t
+scaffold_tables_content_key(
+	core::pose::Pose const & scaffold,
+	utility::vector1<core::Size> const & scaffold_res,
+	devel::scheme::RotamerIndex const & rot_index
+);
+
+// content addressed, uncompressed, mmap-able cache file for a scaffold energy table
+// <dir>/<prefix>_<key in hex>.bin, "" if dir is ""
+std::string
+flat_table_cache_file( std::string const & dir, std::string const & prefix, uint64_t key );
+
 void
 compute_onebody_rotamer_energies(
 	core::pose::Pose const & scaffold,
@@ -163,11 +184,15 @@ struct MakeTwobodyOpts {
 	float distance_cut;
 	float hbond_weight;
 	float favorable_2body_multiplier;
+	bool compact_int16;
+	bool lazy; // compute twobody blocks on first access, not up front
 	MakeTwobodyOpts()
 		: onebody_threshold(2.0)
 		, distance_cut(15.0)
 		, hbond_weight(2.0)
 		, favorable_2body_multiplier(1)
+		, compact_int16(false)
+		, lazy(false)
 	{}
 };
 
@@ -191,7 +216,18 @@ get_twobody_tables(
 	std::vector<std::vector<float> > const & onebody_energies,
 	RotamerRFTablesManager & rotrfmanager,
 	MakeTwobodyOpts opts,
-	::scheme::objective::storage::TwoBodyTable<float> & twob
+	::scheme::objective::storage::TwoBodyTable<float> & twob,
+	std::string const & flatcachefile = "", // see flat_table_cache_file, used before cachefile
+	uint64_t flatkey = 0
+);
+
+// everything the raw twobody energies depend on
+uint64_t
+twobody_tables_content_key(
+	uint64_t scaffold_key,
+	std::vector<std::vector<float> > const & onebody_energies,
+	MakeTwobodyOpts const & opts,
+	RotamerRFOpts const & rotrfopts
 );
 
 
@@ -14,6 +14,7 @@
 
 
 #include <scheme/types.hh>
+#include <boost/functional/hash.hpp>
 #include <scheme/nest/NEST.hh>
 #include <scheme/objective/storage/TwoBodyTable.hh>
 #include <riflib/rifdock_typedefs.hh>
@@ -68,6 +69,7 @@ struct ScaffoldDataCache {
     shared_ptr<std::vector<std::string>> scaffold_sequence_glob0_p;            // Scaffold sequence in name3 space
     shared_ptr<std::vector< std::pair<int,int> > > local_rotamers_p;           // lower and upper bounds into rotamer_index for each local_seqpos
     std::string scaff_res_hashstr;
+    uint64_t scaff_content_key = 0;                                             // scaffold_tables_content_key, 0 until needed
     shared_ptr<std::vector<std::pair<core::Real,core::Real> > > scaffold_phi_psi_p; // Scaffold phi-psi
     shared_ptr<std::vector<bool>> scaffold_d_pos_p;                                  // Scaffold allow d postion base on phi-psi
     uint64_t debug_sanity;
@@ -326,6 +328,13 @@ struct ScaffoldDataCache {
 
         std::string cachefile_1be = "__1BE_"+scafftag+(opt.replace_all_with_ala_1bre?"_ALLALA":"")+"_reshash"+scaff_res_hashstr+".bin.gz";
         if( ! opt.cache_scaffold_data ) cachefile_1be = "";
+        std::string flatcachefile_1be;
+        uint64_t flatkey_1be = 0;
+        if( opt.scaffold_table_cache_dir.size() ){
+            flatkey_1be = get_scaff_content_key( *rot_index_p );
+            boost::hash_combine( flatkey_1be, opt.replace_all_with_ala_1bre );
+            flatcachefile_1be = flat_table_cache_file( opt.scaffold_table_cache_dir, "1be", flatkey_1be );
+        }
         std::cout << "rifdock: get_onebody_rotamer_energies" << std::endl;
         get_onebody_rotamer_energies(
                 *scaffold_centered_p,
@@ -336,7 +345,9 @@ struct ScaffoldDataCache {
                 cachefile_1be,
                 opt.replace_all_with_ala_1bre,
                 opt.favorable_1body_multiplier,
-                opt.favorable_1body_multiplier_cutoff
+                opt.favorable_1body_multiplier_cutoff,
+                flatcachefile_1be,
+                flatkey_1be
             );
 
         if( opt.restrict_to_native_scaffold_res ){
@@ -372,6 +383,14 @@ struct ScaffoldDataCache {
         }
     }
 
+    uint64_t
+    get_scaff_content_key( RotamerIndex const & rot_index ) {
+        if( scaff_content_key == 0 ){
+            scaff_content_key = scaffold_tables_content_key( *scaffold_centered_p, *scaffold_res_p, rot_index );
+        }
+        return scaff_content_key;
+    }
+
     // setup scaffold_twobody_p and local_twobody_p
     void
     setup_twobody_tables(  
@@ -387,6 +406,13 @@ struct ScaffoldDataCache {
         std::cout << "rifdock: get_twobody_tables" << std::endl;
         std::string cachefile2b = "__2BE_" + scafftag + "_reshash" + scaff_res_hashstr + ".bin.gz";
         if( ! opt.cache_scaffold_data || opt.extra_rotamers ) cachefile2b = "";
+        std::string flatcachefile_2be;
+        uint64_t flatkey_2be = 0;
+        if( opt.scaffold_table_cache_dir.size() ){
+            flatkey_2be = twobody_tables_content_key( get_scaff_content_key( *rot_index_p ), *scaffold_onebody_glob0_p,
+                                                      make2bopts, rotrf_table_manager.opts_ );
+            flatcachefile_2be = flat_table_cache_file( opt.scaffold_table_cache_dir, "2be", flatkey_2be );
+        }
         std::string dscrtmp;
         get_twobody_tables(
                 opt.data_cache_path,
@@ -397,11 +423,17 @@ struct ScaffoldDataCache {
                 *scaffold_onebody_glob0_p,
                 rotrf_table_manager,
                 make2bopts,
-                *scaffold_twobody_p
+                *scaffold_twobody_p,
+                flatcachefile_2be,
+                flatkey_2be
             );
 
 
-        local_twobody_p = scaffold_twobody_p->create_subtable( *scaffuseres_p, *scaffold_onebody_glob0_p, make2bopts.onebody_threshold );
+        // lazy: blocks are pulled from scaffold_twobody_p, which is in turn computed, as packing needs them
+        local_twobody_p = scaffold_twobody_p->create_subtable( *scaffuseres_p, *scaffold_onebody_glob0_p, make2bopts.onebody_threshold, make2bopts.lazy );
+        if( !make2bopts.lazy ){
+            local_twobody_p->compact( make2bopts.compact_int16 ); // one arena, per-thread clones are plain copies
+        }
     
 
         std::cout << "rifdock: twobody memuse: " << (float)scaffold_twobody_p->twobody_mem_use()/1000.0/1000.0 << "M" << std::endl;
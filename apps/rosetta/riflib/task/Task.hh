@@ -50,6 +50,11 @@ struct Task {
 
     virtual TaskType get_task_type() const = 0;
 
+    // called instead of running the task when a resumed TaskProtocol skips it. tasks that
+    // change state outside of the points and ProtocolData (scene mode, scaffold tables...)
+    // redo that here
+    virtual void restore_state( RifDockData & rdd, ProtocolData & pd ) {}
+
 
 };
 
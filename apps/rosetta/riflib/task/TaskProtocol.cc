@@ -14,7 +14,13 @@
 #include <riflib/types.hh>
 
 
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 
@@ -22,6 +28,256 @@
 namespace devel {
 namespace scheme {
 
+// the checkpoint is a flat binary dump in native byte order, only meant to be read back
+// by the same build. points carrying poses are never checkpointed, the poses can't be saved
+static char const CHECKPOINT_MAGIC[8] = { 'R','I','F','C','K','P','T','2' };
+
+template<class T> static void ckpt_write( std::ostream & out, T const & t ) { out.write( (char const*)&t, sizeof(T) ); }
+template<class T> static void ckpt_read ( std::istream & in , T & t ) { in.read( (char*)&t, sizeof(T) ); }
+
+static void ckpt_write( std::ostream & out, RifDockIndex const & rdi ) {
+    ckpt_write( out, rdi.nest_index );
+    ckpt_write( out, rdi.seeding_index );
+    ckpt_write( out, rdi.scaffold_index.depth );
+    ckpt_write( out, rdi.scaffold_index.member );
+}
+static void ckpt_read( std::istream & in, RifDockIndex & rdi ) {
+    ckpt_read( in, rdi.nest_index );
+    ckpt_read( in, rdi.seeding_index );
+    ckpt_read( in, rdi.scaffold_index.depth );
+    ckpt_read( in, rdi.scaffold_index.member );
+}
+
+static void ckpt_write( std::ostream & out, std::string const & s ) {
+    ckpt_write( out, (uint64_t)s.size() );
+    out.write( s.data(), s.size() );
+}
+static void ckpt_read( std::istream & in, std::string & s ) {
+    uint64_t n = 0;
+    ckpt_read( in, n );
+    s.resize( n );
+    if ( n ) in.read( &s[0], n );
+}
+
+typedef shared_ptr< std::vector< std::pair<intRot,intRot> > > RotamersP;
+static void ckpt_write_rotamers( std::ostream & out, RotamersP const & rots ) {
+    int64_t n = rots ? (int64_t)rots->size() : -1;
+    ckpt_write( out, n );
+    if ( n > 0 ) out.write( (char const*)rots->data(), n*sizeof(std::pair<intRot,intRot>) );
+}
+static void ckpt_read_rotamers( std::istream & in, RotamersP & rots ) {
+    int64_t n = -1;
+    ckpt_read( in, n );
+    rots = nullptr;
+    if ( n < 0 ) return;
+    rots = make_shared< std::vector< std::pair<intRot,intRot> > >( n );
+    if ( n > 0 ) in.read( (char*)rots->data(), n*sizeof(std::pair<intRot,intRot>) );
+}
+
+static void ckpt_write( std::ostream & out, SearchPoint const & sp ) {
+    ckpt_write( out, sp.score );
+    ckpt_write( out, sp.index );
+}
+static void ckpt_read( std::istream & in, SearchPoint & sp ) {
+    ckpt_read( in, sp.score );
+    ckpt_read( in, sp.index );
+}
+
+static void ckpt_write( std::ostream & out, SearchPointWithRots const & sp ) {
+    ckpt_write( out, sp.score );
+    ckpt_write( out, sp.prepack_rank );
+    ckpt_write( out, sp.index );
+    ckpt_write_rotamers( out, sp.rotamers_ );
+}
+static void ckpt_read( std::istream & in, SearchPointWithRots & sp ) {
+    ckpt_read( in, sp.score );
+    ckpt_read( in, sp.prepack_rank );
+    ckpt_read( in, sp.index );
+    ckpt_read_rotamers( in, sp.rotamers_ );
+}
+
+static void ckpt_write( std::ostream & out, RifDockResult const & r ) {
+    ckpt_write( out, r.dist0 );
+    ckpt_write( out, r.nopackscore );
+    ckpt_write( out, r.rifscore );
+    ckpt_write( out, r.stericscore );
+    ckpt_write( out, r.score );
+    ckpt_write( out, r.isamp );
+    ckpt_write( out, r.index );
+    ckpt_write( out, r.prepack_rank );
+    ckpt_write( out, r.cluster_score );
+    ckpt_write_rotamers( out, r.rotamers_ );
+}
+static void ckpt_read( std::istream & in, RifDockResult & r ) {
+    ckpt_read( in, r.dist0 );
+    ckpt_read( in, r.nopackscore );
+    ckpt_read( in, r.rifscore );
+    ckpt_read( in, r.stericscore );
+    ckpt_read( in, r.score );
+    ckpt_read( in, r.isamp );
+    ckpt_read( in, r.index );
+    ckpt_read( in, r.prepack_rank );
+    ckpt_read( in, r.cluster_score );
+    ckpt_read_rotamers( in, r.rotamers_ );
+}
+
+template<class Point>
+static void ckpt_write_points( std::ostream & out, shared_ptr<std::vector<Point>> const & points ) {
+    ckpt_write( out, (uint64_t)points->size() );
+    for ( Point const & pt : *points ) ckpt_write( out, pt );
+}
+template<class Point>
+static shared_ptr<std::vector<Point>> ckpt_read_points( std::istream & in ) {
+    uint64_t n = 0;
+    ckpt_read( in, n );
+    shared_ptr<std::vector<Point>> points = make_shared<std::vector<Point>>( n );
+    for ( Point & pt : *points ) ckpt_read( in, pt );
+    return points;
+}
+
+template<class Point>
+static bool ckpt_any_poses( shared_ptr<std::vector<Point>> const & points ) {
+    for ( Point const & pt : *points ) if ( pt.pose_ ) return true;
+    return false;
+}
+
+bool
+TaskProtocol::checkpoint_after( size_t taskno ) const {
+    if ( checkpoint_fname_.empty() ) return false;
+    for ( int after : checkpoint_after_ ) {
+        if ( after == (int)taskno || ( after == -1 && taskno+1 == tasks_.size() ) ) return true;
+    }
+    return false;
+}
+
+uint64_t
+TaskProtocol::protocol_key() const {
+    size_t h = 0;
+    boost::hash_combine( h, tasks_.size() );
+    for ( shared_ptr<Task> const & task : tasks_ ) boost::hash_combine( h, std::string( typeid(*task).name() ) );
+    boost::hash_combine( h, options_key_ );
+    return h;
+}
+
+bool
+TaskProtocol::save_checkpoint( size_t ntasks_done, TaskType type, ThreePointVectors const & points, ProtocolData const & pd ) const {
+
+    bool poses = false;
+    switch ( type ) {
+        case SearchPointTaskType: break;
+        case SearchPointWithRotsTaskType: poses = ckpt_any_poses( points.search_point_with_rotss ); break;
+        case RifDockResultTaskType: poses = ckpt_any_poses( points.rif_dock_results ); break;
+        default: { runtime_assert(false); }
+    }
+    if ( poses ) {
+        std::cout << "Not checkpointing after task " << ntasks_done << " of " << tasks_.size()
+                  << ", the points carry poses that can't be saved. Checkpoint before the rosetta tasks" << std::endl;
+        return false;
+    }
+
+    std::string const tmpfname = checkpoint_fname_ + ".tmp";
+    {
+        std::ofstream out( tmpfname, std::ios::binary );
+        runtime_assert_msg( out.good(), "can't open checkpoint file " + tmpfname );
+        out.write( CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC) );
+        ckpt_write( out, protocol_key() );
+        ckpt_write( out, (uint64_t)tasks_.size() );
+        ckpt_write( out, (uint64_t)ntasks_done );
+        ckpt_write( out, (int32_t)type );
+
+        ckpt_write( out, pd.non0_space_size );
+        ckpt_write( out, pd.total_search_effort );
+        ckpt_write( out, pd.npack );
+        ckpt_write( out, pd.time_rif );
+        ckpt_write( out, pd.time_pck );
+        ckpt_write( out, pd.time_ros );
+        ckpt_write( out, pd.hsearch_rate );
+        ckpt_write( out, pd.beam_multiplier );
+        ckpt_write( out, (uint64_t)pd.unique_scaffolds.size() );
+        for ( ScaffoldIndex const & si : pd.unique_scaffolds ) {
+            ckpt_write( out, si.depth );
+            ckpt_write( out, si.member );
+        }
+        ckpt_write( out, (uint64_t)pd.seeding_tags.size() );
+        for ( std::string const & tag : pd.seeding_tags ) ckpt_write( out, tag );
+
+        switch ( type ) {
+            case SearchPointTaskType: ckpt_write_points( out, points.search_points ); break;
+            case SearchPointWithRotsTaskType: ckpt_write_points( out, points.search_point_with_rotss ); break;
+            case RifDockResultTaskType: ckpt_write_points( out, points.rif_dock_results ); break;
+            default: { runtime_assert(false); }
+        }
+        out.close();
+        runtime_assert_msg( ! out.fail(), "failed writing checkpoint file " + tmpfname );
+    }
+    // a run killed mid-write leaves the previous checkpoint intact
+    runtime_assert_msg( std::rename( tmpfname.c_str(), checkpoint_fname_.c_str() ) == 0,
+                        "can't move checkpoint into place: " + checkpoint_fname_ );
+    std::cout << "Checkpoint after task " << ntasks_done << " of " << tasks_.size() << " written to " << checkpoint_fname_ << std::endl;
+    return true;
+}
+
+size_t
+TaskProtocol::load_checkpoint( TaskType & type, ThreePointVectors & points, ProtocolData & pd ) const {
+
+    std::ifstream in( checkpoint_fname_, std::ios::binary );
+    if ( ! in.good() ) {
+        std::cout << "No checkpoint at " << checkpoint_fname_ << ", starting from the beginning" << std::endl;
+        return 0;
+    }
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    in.read( magic, sizeof(magic) );
+    uint64_t key = 0, ntasks = 0, ntasks_done = 0;
+    ckpt_read( in, key );
+    ckpt_read( in, ntasks );
+    ckpt_read( in, ntasks_done );
+    if ( ! in.good() || ! std::equal( magic, magic+sizeof(magic), CHECKPOINT_MAGIC ) || ntasks_done > ntasks ) {
+        std::cout << "Checkpoint " << checkpoint_fname_ << " is unreadable or from another version, starting from the beginning" << std::endl;
+        return 0;
+    }
+    if ( key != protocol_key() || ntasks != tasks_.size() ) {
+        std::cout << "Checkpoint " << checkpoint_fname_ << " was written by different tasks or options, starting from the beginning" << std::endl;
+        return 0;
+    }
+    int32_t itype = 0;
+    ckpt_read( in, itype );
+    type = (TaskType)itype;
+
+    ckpt_read( in, pd.non0_space_size );
+    ckpt_read( in, pd.total_search_effort );
+    ckpt_read( in, pd.npack );
+    ckpt_read( in, pd.time_rif );
+    ckpt_read( in, pd.time_pck );
+    ckpt_read( in, pd.time_ros );
+    ckpt_read( in, pd.hsearch_rate );
+    ckpt_read( in, pd.beam_multiplier );
+    uint64_t n = 0;
+    ckpt_read( in, n );
+    pd.unique_scaffolds.resize( n );
+    for ( ScaffoldIndex & si : pd.unique_scaffolds ) {
+        ckpt_read( in, si.depth );
+        ckpt_read( in, si.member );
+    }
+    ckpt_read( in, n );
+    pd.seeding_tags.resize( n );
+    for ( std::string & tag : pd.seeding_tags ) ckpt_read( in, tag );
+    pd.start_rif = std::chrono::high_resolution_clock::now();
+    pd.hsearch_sorted_points = nullptr;
+    pd.hsearch_nsorted = 0;
+
+    points = ThreePointVectors();
+    switch ( type ) {
+        case SearchPointTaskType: points.search_points = ckpt_read_points<SearchPoint>( in ); break;
+        case SearchPointWithRotsTaskType: points.search_point_with_rotss = ckpt_read_points<SearchPointWithRots>( in ); break;
+        case RifDockResultTaskType: points.rif_dock_results = ckpt_read_points<RifDockResult>( in ); break;
+        default: { runtime_assert_msg( false, "bad point type in checkpoint " + checkpoint_fname_ ); }
+    }
+    runtime_assert_msg( ! in.fail(), "truncated checkpoint " + checkpoint_fname_ );
+
+    std::cout << "Resuming from " << checkpoint_fname_ << " after task " << ntasks_done << " of " << ntasks << std::endl;
+    return ntasks_done;
+}
+
 
 ThreePointVectors
 TaskProtocol::run( ThreePointVectors input, RifDockData & rdd, ProtocolData & pd ) {
@@ -45,6 +301,20 @@ TaskProtocol::run( ThreePointVectors input, RifDockData & rdd, ProtocolData & pd
 
     size_t current_taskno = 0;
 
+    if ( resume_ && ! checkpoint_fname_.empty() ) {
+        TaskType resumed_type;
+        ThreePointVectors resumed;
+        size_t ntasks_done = load_checkpoint( resumed_type, resumed, pd );
+        if ( ntasks_done > 0 ) {
+            for ( size_t itask = 0; itask < ntasks_done; itask++ ) tasks_[itask]->restore_state( rdd, pd );
+            working_search_points = resumed.search_points;
+            working_search_point_with_rotss = resumed.search_point_with_rotss;
+            working_rif_dock_results = resumed.rif_dock_results;
+            last_task_type = resumed_type;
+            current_taskno = ntasks_done;
+        }
+    }
+
 
     while ( current_taskno < tasks_.size() ) {
 
@@ -205,6 +475,11 @@ TaskProtocol::run( ThreePointVectors input, RifDockData & rdd, ProtocolData & pd
             return ThreePointVectors();
         }
 
+        if ( checkpoint_after( current_taskno-1 ) ) {
+            ThreePointVectors working { working_search_points, working_search_point_with_rotss, working_rif_dock_results };
+            save_checkpoint( current_taskno, last_task_type, working, pd );
+        }
+
     }
 
     ThreePointVectors to_return {
@@ -30,18 +30,52 @@ struct ThreePointVectors {
 struct TaskProtocol {
 
     TaskProtocol( std::vector<shared_ptr<Task>> const & tasks ) :
-    tasks_( tasks )
+    tasks_( tasks ),
+    resume_( false ),
+    options_key_( 0 )
     {}
 
+    // after each task number in after_tasks (0 based, -1 for the last task), the working
+    // points and ProtocolData are written to checkpoint_fname. with resume, run() starts
+    // from checkpoint_fname if it exists and was written by the same sequence of task types
+    // with the same options_key (see RifDockOpt::checkpoint_key)
+    void
+    set_checkpointing( std::string const & checkpoint_fname, std::vector<int> const & after_tasks, bool resume, uint64_t options_key = 0 ) {
+        checkpoint_fname_ = checkpoint_fname;
+        checkpoint_after_ = after_tasks;
+        resume_ = resume;
+        options_key_ = options_key;
+    }
 
     ThreePointVectors
     run( ThreePointVectors input, RifDockData & rdd, ProtocolData & pd );
 
 
+    // run() calls these, they're public so the file format can be tested without running tasks
+
+    // false without writing if the points carry poses, which checkpoints can't store
+    bool
+    save_checkpoint( size_t ntasks_done, TaskType type, ThreePointVectors const & points, ProtocolData const & pd ) const;
+
+    // returns the number of tasks done, 0 if there is no usable checkpoint
+    size_t
+    load_checkpoint( TaskType & type, ThreePointVectors & points, ProtocolData & pd ) const;
+
+
 private:
 
+    bool
+    checkpoint_after( size_t taskno ) const;
+
+    uint64_t
+    protocol_key() const;
+
 
     std::vector<shared_ptr<Task>> tasks_;
+    std::string checkpoint_fname_;
+    std::vector<int> checkpoint_after_;
+    bool resume_;
+    uint64_t options_key_;
 
 
 
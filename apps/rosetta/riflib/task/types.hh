@@ -14,6 +14,7 @@
 #include <riflib/rifdock_typedefs.hh>
 #include <riflib/rotamer_energy_tables.hh>
 #include <scheme/search/HackPack.hh>
+#include <scheme/search/CompactSearchPointCodec.hh>
 #include <riflib/RifBase.hh>
 #include <riflib/RifFactory.hh>
 
@@ -153,6 +154,9 @@ using _SearchPoint = tmplSearchPoint<_DirectorBigIndex<__Director>>;
 typedef _SearchPoint<DirectorBase> SearchPoint;
 
 
+typedef ::scheme::search::CompactSearchPointCodec< SearchPoint > CompactSearchPointCodec;
+
+
 
 
 
@@ -214,6 +218,10 @@ struct ProtocolData {
 
 // for hsearch
     double beam_multiplier;
+    // the first hsearch_nsorted points of *hsearch_sorted_points are the best ones, in order.
+    // set by HSearchScoreAtReslTask when it selects while scoring
+    std::vector<SearchPoint> const * hsearch_sorted_points;
+    uint64_t hsearch_nsorted;
 
 // for seeding positions
     std::vector<std::string> seeding_tags;
@@ -228,7 +236,9 @@ struct ProtocolData {
     time_pck(0),
     time_ros(0),
     hsearch_rate(0),
-    beam_multiplier(1)
+    beam_multiplier(1),
+    hsearch_sorted_points(nullptr),
+    hsearch_nsorted(0)
 
 
 
@@ -116,6 +116,48 @@ search_point_with_rotss_from_rif_dock_results(shared_ptr<std::vector<RifDockResu
 
 
 
+CompactSearchPointCodec
+compact_search_point_codec( RifDockData & rdd, int resl ) {
+    RifDockIndex sizes = rdd.director->size( resl, RifDockIndex() );
+    std::vector<uint64_t> scaffold_limits;
+    if ( rdd.scaffold_provider ) scaffold_limits = rdd.scaffold_provider->get_scaffold_index_limits();
+    return CompactSearchPointCodec( sizes.nest_index, sizes.seeding_index, scaffold_limits );
+}
+
+bool
+encode_search_points( CompactSearchPointCodec const & codec, std::vector<SearchPoint> const & search_points, std::vector<uint64_t> & compact ) {
+    bool fits = true;
+    #ifdef USE_OPENMP
+    #pragma omp parallel for reduction(&&:fits)
+    #endif
+    for ( size_t i = 0; i < search_points.size(); i++ ) {
+        fits = fits && codec.fits( search_points[i] );
+    }
+    if ( ! fits ) return false;
+
+    compact.resize( search_points.size() );
+    #ifdef USE_OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for ( size_t i = 0; i < search_points.size(); i++ ) {
+        compact[i] = codec.encode( search_points[i] );
+    }
+    return true;
+}
+
+void
+decode_search_points( CompactSearchPointCodec const & codec, std::vector<uint64_t> const & compact, std::vector<SearchPoint> & search_points ) {
+    search_points.resize( compact.size() );
+    #ifdef USE_OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for ( size_t i = 0; i < compact.size(); i++ ) {
+        search_points[i] = codec.decode( compact[i] );
+    }
+}
+
+
+
 }}
 
 
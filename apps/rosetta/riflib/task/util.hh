@@ -37,6 +37,17 @@ shared_ptr<std::vector<SearchPointWithRots>>
 search_point_with_rotss_from_rif_dock_results(shared_ptr<std::vector<RifDockResult>> rif_dock_results);
 
 
+// sized from the director's index ranges at resl and the scaffold provider's limits
+CompactSearchPointCodec
+compact_search_point_codec( RifDockData & rdd, int resl );
+
+// false, leaving compact untouched, if any point is out of the codec's ranges
+bool
+encode_search_points( CompactSearchPointCodec const & codec, std::vector<SearchPoint> const & search_points, std::vector<uint64_t> & compact );
+void
+decode_search_points( CompactSearchPointCodec const & codec, std::vector<uint64_t> const & compact, std::vector<SearchPoint> & search_points );
+
+
 
 }}
 
@@ -41,6 +41,11 @@
 
 #include <boost/functional/hash/hash.hpp>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 namespace devel {
 namespace scheme {
@@ -315,6 +320,24 @@ open_for_write_on_path(
 
 }
 
+MappedFile::MappedFile( std::string const & fname ) : data_(nullptr), size_(0) {
+	int fd = ::open( fname.c_str(), O_RDONLY );
+	if( fd < 0 ) return;
+	struct stat st;
+	if( ::fstat( fd, &st ) == 0 && st.st_size > 0 ){
+		void * p = ::mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( p != MAP_FAILED ){
+			data_ = (char const *)p;
+			size_ = st.st_size;
+		}
+	}
+	::close( fd );
+}
+
+MappedFile::~MappedFile(){
+	if( data_ ) ::munmap( (void*)data_, size_ );
+}
+
 
 
 
@@ -224,6 +224,20 @@ open_for_write_on_path(
 	bool create_directorys = false
 );
 
+// read-only memory map of a whole file, data() is null if it can't be mapped
+class MappedFile {
+public:
+	MappedFile( std::string const & fname );
+	~MappedFile();
+	char const * data() const { return data_; }
+	size_t size() const { return size_; }
+private:
+	MappedFile( MappedFile const & );
+	MappedFile & operator=( MappedFile const & );
+	char const * data_;
+	size_t size_;
+};
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// OMG! MOVE ME
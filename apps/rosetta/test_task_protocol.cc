@@ -0,0 +1,199 @@
+#include <iostream>
+
+#include <devel/init.hh>
+#include <core/pose/Pose.hh>
+
+#include <riflib/task/TaskProtocol.hh>
+#include <riflib/rifdock_tasks/UtilTasks.hh>
+
+#include <cstdio>
+#include <cstdlib>
+
+// checkpoint file round trips for TaskProtocol, exits nonzero on the first failure
+
+using namespace devel::scheme;
+
+static void check( bool ok, std::string const & what ) {
+	if ( ok ) return;
+	std::cout << "FAILED: " << what << std::endl;
+	std::exit(1);
+}
+
+static RifDockIndex make_index( uint64_t i ) {
+	return RifDockIndex( i*7919, i%5, ScaffoldIndex( i%3, i%11 ) );
+}
+
+static shared_ptr< std::vector< std::pair<intRot,intRot> > > make_rotamers( uint64_t i ) {
+	if ( i % 4 == 0 ) return nullptr;
+	auto rots = make_shared< std::vector< std::pair<intRot,intRot> > >();
+	for ( uint64_t j = 0; j < i%4 - 1; j++ ) rots->push_back( std::make_pair( (intRot)(i+j), (intRot)(2*i+j) ) );
+	return rots;
+}
+
+static bool same_rotamers( shared_ptr< std::vector< std::pair<intRot,intRot> > > const & a,
+                           shared_ptr< std::vector< std::pair<intRot,intRot> > > const & b ) {
+	if ( ! a || ! b ) return ! a && ! b;
+	return *a == *b;
+}
+
+static std::vector<shared_ptr<Task>> make_tasks( int n ) {
+	std::vector<shared_ptr<Task>> tasks;
+	for ( int i = 0; i < n; i++ ) tasks.push_back( make_shared<SortByScoreTask>() );
+	return tasks;
+}
+
+static ProtocolData make_protocol_data() {
+	ProtocolData pd;
+	pd.non0_space_size = 123;
+	pd.total_search_effort = 4567;
+	pd.npack = 89;
+	pd.time_rif = 1.5;
+	pd.time_pck = 2.5;
+	pd.time_ros = 3.5;
+	pd.hsearch_rate = 1e6;
+	pd.beam_multiplier = 3;
+	pd.unique_scaffolds.push_back( ScaffoldIndex( 0, 1 ) );
+	pd.unique_scaffolds.push_back( ScaffoldIndex( 2, 3 ) );
+	pd.seeding_tags.push_back( "seed_a" );
+	pd.seeding_tags.push_back( "" );
+	return pd;
+}
+
+static void check_protocol_data( ProtocolData const & a, ProtocolData const & b ) {
+	check( a.non0_space_size == b.non0_space_size && a.total_search_effort == b.total_search_effort && a.npack == b.npack, "pd counts" );
+	check( a.time_rif == b.time_rif && a.time_pck == b.time_pck && a.time_ros == b.time_ros, "pd times" );
+	check( a.hsearch_rate == b.hsearch_rate && a.beam_multiplier == b.beam_multiplier, "pd hsearch" );
+	check( a.unique_scaffolds == b.unique_scaffolds, "pd unique_scaffolds" );
+	check( a.seeding_tags == b.seeding_tags, "pd seeding_tags" );
+}
+
+static void test_round_trips( std::string const & fname ) {
+	TaskProtocol protocol( make_tasks(3) );
+	protocol.set_checkpointing( fname, std::vector<int>{ 1 }, true, 42 );
+	ProtocolData const pd = make_protocol_data();
+
+	{
+		ThreePointVectors points;
+		points.search_points = make_shared<std::vector<SearchPoint>>();
+		for ( uint64_t i = 0; i < 1000; i++ ) {
+			points.search_points->push_back( SearchPoint( make_index(i) ) );
+			points.search_points->back().score = -(float)i / 3;
+		}
+		check( protocol.save_checkpoint( 2, SearchPointTaskType, points, pd ), "save search points" );
+		TaskType type;
+		ThreePointVectors loaded;
+		ProtocolData lpd;
+		check( protocol.load_checkpoint( type, loaded, lpd ) == 2, "load search points" );
+		check( type == SearchPointTaskType && loaded.search_points && ! loaded.search_point_with_rotss && ! loaded.rif_dock_results, "search points type" );
+		check_protocol_data( pd, lpd );
+		check( loaded.search_points->size() == points.search_points->size(), "search points size" );
+		for ( size_t i = 0; i < points.search_points->size(); i++ ) {
+			check( loaded.search_points->at(i).score == points.search_points->at(i).score, "search point score" );
+			check( loaded.search_points->at(i).index == points.search_points->at(i).index, "search point index" );
+		}
+	}
+	{
+		ThreePointVectors points;
+		points.search_point_with_rotss = make_shared<std::vector<SearchPointWithRots>>();
+		for ( uint64_t i = 0; i < 1000; i++ ) {
+			points.search_point_with_rotss->push_back( SearchPointWithRots( make_index(i), i ) );
+			points.search_point_with_rotss->back().score = (float)i;
+			points.search_point_with_rotss->back().rotamers_ = make_rotamers(i);
+		}
+		check( protocol.save_checkpoint( 1, SearchPointWithRotsTaskType, points, pd ), "save search points with rots" );
+		TaskType type;
+		ThreePointVectors loaded;
+		ProtocolData lpd;
+		check( protocol.load_checkpoint( type, loaded, lpd ) == 1, "load search points with rots" );
+		check( type == SearchPointWithRotsTaskType && loaded.search_point_with_rotss, "search points with rots type" );
+		check( loaded.search_point_with_rotss->size() == points.search_point_with_rotss->size(), "search points with rots size" );
+		for ( size_t i = 0; i < points.search_point_with_rotss->size(); i++ ) {
+			SearchPointWithRots const & a = points.search_point_with_rotss->at(i), & b = loaded.search_point_with_rotss->at(i);
+			check( a.score == b.score && a.prepack_rank == b.prepack_rank && a.index == b.index, "search point with rots fields" );
+			check( same_rotamers( a.rotamers_, b.rotamers_ ), "search point with rots rotamers" );
+		}
+	}
+	{
+		ThreePointVectors points;
+		points.rif_dock_results = make_shared<std::vector<RifDockResult>>();
+		for ( uint64_t i = 0; i < 1000; i++ ) {
+			RifDockResult r;
+			r.dist0 = i; r.nopackscore = -1.0f*i; r.rifscore = 2.0f*i; r.stericscore = 0.5f*i;
+			r.score = 3.0f*i; r.isamp = i*13; r.index = make_index(i); r.prepack_rank = i; r.cluster_score = 0.25f*i;
+			r.rotamers_ = make_rotamers(i);
+			points.rif_dock_results->push_back( r );
+		}
+		check( protocol.save_checkpoint( 3, RifDockResultTaskType, points, pd ), "save rif dock results" );
+		TaskType type;
+		ThreePointVectors loaded;
+		ProtocolData lpd;
+		check( protocol.load_checkpoint( type, loaded, lpd ) == 3, "load rif dock results" );
+		check( type == RifDockResultTaskType && loaded.rif_dock_results, "rif dock results type" );
+		check( loaded.rif_dock_results->size() == points.rif_dock_results->size(), "rif dock results size" );
+		for ( size_t i = 0; i < points.rif_dock_results->size(); i++ ) {
+			RifDockResult const & a = points.rif_dock_results->at(i), & b = loaded.rif_dock_results->at(i);
+			check( a.dist0 == b.dist0 && a.nopackscore == b.nopackscore && a.rifscore == b.rifscore && a.stericscore == b.stericscore, "rif dock result scores" );
+			check( a.score == b.score && a.isamp == b.isamp && a.index == b.index && a.prepack_rank == b.prepack_rank && a.cluster_score == b.cluster_score, "rif dock result fields" );
+			check( same_rotamers( a.rotamers_, b.rotamers_ ), "rif dock result rotamers" );
+		}
+	}
+	std::cout << "round trips ok" << std::endl;
+}
+
+static void test_mismatch_rejected( std::string const & fname ) {
+	TaskProtocol protocol( make_tasks(3) );
+	protocol.set_checkpointing( fname, std::vector<int>{ 0 }, true, 42 );
+	ThreePointVectors points;
+	points.search_points = make_shared<std::vector<SearchPoint>>( 10 );
+	check( protocol.save_checkpoint( 1, SearchPointTaskType, points, make_protocol_data() ), "save for mismatch" );
+
+	TaskType type;
+	ThreePointVectors loaded;
+	ProtocolData lpd;
+
+	TaskProtocol other_options( make_tasks(3) );
+	other_options.set_checkpointing( fname, std::vector<int>{ 0 }, true, 43 );
+	check( other_options.load_checkpoint( type, loaded, lpd ) == 0, "options key mismatch rejected" );
+
+	TaskProtocol other_count( make_tasks(4) );
+	other_count.set_checkpointing( fname, std::vector<int>{ 0 }, true, 42 );
+	check( other_count.load_checkpoint( type, loaded, lpd ) == 0, "task count mismatch rejected" );
+
+	std::vector<shared_ptr<Task>> tasks = make_tasks(3);
+	tasks[2] = make_shared<DumpScoresTask>( "unused.dat" );
+	TaskProtocol other_tasks( tasks );
+	other_tasks.set_checkpointing( fname, std::vector<int>{ 0 }, true, 42 );
+	check( other_tasks.load_checkpoint( type, loaded, lpd ) == 0, "task type mismatch rejected" );
+
+	check( protocol.load_checkpoint( type, loaded, lpd ) == 1, "matching protocol still loads" );
+	std::cout << "mismatches rejected ok" << std::endl;
+}
+
+static void test_poses_not_saved( std::string const & fname ) {
+	std::remove( fname.c_str() );
+	TaskProtocol protocol( make_tasks(2) );
+	protocol.set_checkpointing( fname, std::vector<int>{ 0 }, true );
+	ThreePointVectors points;
+	points.rif_dock_results = make_shared<std::vector<RifDockResult>>( 10 );
+	points.rif_dock_results->at(5).pose_ = core::pose::PoseOP( new core::pose::Pose() );
+	check( ! protocol.save_checkpoint( 1, RifDockResultTaskType, points, make_protocol_data() ), "points with poses not saved" );
+
+	TaskType type;
+	ThreePointVectors loaded;
+	ProtocolData lpd;
+	check( protocol.load_checkpoint( type, loaded, lpd ) == 0, "nothing to resume after refusing" );
+	std::cout << "poses refused ok" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	::devel::init( argc, argv );
+
+	std::string const fname = "test_task_protocol.ckpt";
+	test_round_trips( fname );
+	test_mismatch_rejected( fname );
+	test_poses_not_saved( fname );
+	std::remove( fname.c_str() );
+
+	return 0;
+}
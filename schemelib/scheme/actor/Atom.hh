@@ -5,7 +5,9 @@
 #include "scheme/types.hh"
 #include "scheme/chemical/AtomData.hh"
 #include "scheme/io/dump_pdb_atom.hh"
+#include "scheme/util/container/SoAVector.hh"
 #include <iostream>
+#include <vector>
 
 namespace scheme {
 namespace actor {
@@ -154,6 +156,48 @@ void write_pdb( std::ostream & out, Atom<P> const & a, MetaData const & ){
 
 
 }
+
+namespace util {
+namespace container {
+
+///@brief SimpleAtoms as x, y, z, type, restype and atomnum arrays
+template< class P >
+struct SoATraits< actor::SimpleAtom<P> > {
+	typedef typename P::Scalar Float;
+	struct Arrays {
+		std::vector<Float> x, y, z;
+		std::vector<int16_t> type;
+		std::vector<int8_t> restype, atomnum;
+	};
+	static void push_back( Arrays & a, actor::SimpleAtom<P> const & atom ){
+		a.x.push_back( atom.position()[0] );
+		a.y.push_back( atom.position()[1] );
+		a.z.push_back( atom.position()[2] );
+		a.type.push_back( atom.type() );
+		a.restype.push_back( atom.restype() );
+		a.atomnum.push_back( atom.atomnum() );
+	}
+	static void clear( Arrays & a ){ a.x.clear(); a.y.clear(); a.z.clear(); a.type.clear(); a.restype.clear(); a.atomnum.clear(); }
+	template< class Xform >
+	static void transform( Arrays const & a, Xform const & xform, std::vector< actor::SimpleAtom<P> > & out ){
+		Float const r00 = xform.linear()(0,0), r01 = xform.linear()(0,1), r02 = xform.linear()(0,2);
+		Float const r10 = xform.linear()(1,0), r11 = xform.linear()(1,1), r12 = xform.linear()(1,2);
+		Float const r20 = xform.linear()(2,0), r21 = xform.linear()(2,1), r22 = xform.linear()(2,2);
+		Float const t0 = xform.translation()[0], t1 = xform.translation()[1], t2 = xform.translation()[2];
+		Float const *x = a.x.data(), *y = a.y.data(), *z = a.z.data();
+		for( size_t i = 0; i < out.size(); ++i ){
+			P p;
+			p[0] = r00*x[i] + r01*y[i] + r02*z[i] + t0;
+			p[1] = r10*x[i] + r11*y[i] + r12*z[i] + t1;
+			p[2] = r20*x[i] + r21*y[i] + r22*z[i] + t2;
+			out[i] = actor::SimpleAtom<P>( p, a.type[i], a.restype[i], a.atomnum[i] );
+		}
+	}
+};
+
+}
+}
+
 }
 
 #endif
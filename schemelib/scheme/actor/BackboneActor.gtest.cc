@@ -104,6 +104,28 @@ TEST( BackboneActor, test_get_N_CA_C ){
 }
 
 
+
+TEST( BackboneActor, SoAVector_transform_into ){
+	std::mt19937 rng(0);
+	util::container::SoAVector< BackboneActor<Xform> > bbs;
+	for( int i = 0; i < 50; ++i ){
+		Xform x;
+		numeric::rand_xform( rng, x );
+		bbs.push_back( BackboneActor<Xform>( x, 'A'+i%20, 'H', i ) );
+	}
+	Xform x;
+	numeric::rand_xform( rng, x );
+	std::vector< BackboneActor<Xform> > moved;
+	bbs.transform_into( x, moved );
+	ASSERT_EQ( bbs.size(), moved.size() );
+	for( size_t i = 0; i < bbs.size(); ++i ){
+		BackboneActor<Xform> ref( bbs[i], x );
+		ASSERT_TRUE( ref.position().isApprox( moved[i].position(), 1e-9 ) );
+		ASSERT_EQ( ref.aa_, moved[i].aa_ );
+		ASSERT_EQ( ref.index_, moved[i].index_ );
+	}
+}
+
 }
 }
 }
@@ -3,6 +3,9 @@
 
 #include <Eigen/Dense>
 #include <scheme/io/dump_pdb_atom.hh>
+#include <scheme/util/container/SoAVector.hh>
+
+#include <vector>
 
 #include <core/conformation/Residue.hh>
 #include <numeric/xyzVector.hh>
@@ -196,6 +199,61 @@ std::ostream & operator<<(std::ostream & out,BackboneActor<X> const& a){
 	return out << "BackboneActor " << a.ss_ << " " << a.aa_ << " " << a.index_;
 }
 
+}
+
+namespace util {
+namespace container {
+
+///@brief BackboneActor stubs as 9 rotation and 3 translation arrays, plus aa, ss and index
+template< class X >
+struct SoATraits< actor::BackboneActor<X> > {
+	typedef typename X::Scalar Float;
+	struct Arrays {
+		std::vector<Float> r[3][3], t[3];
+		std::vector<char> aa, ss;
+		std::vector<int> index;
+	};
+	static void push_back( Arrays & a, actor::BackboneActor<X> const & bb ){
+		for( int i = 0; i < 3; ++i ){
+			for( int j = 0; j < 3; ++j ) a.r[i][j].push_back( bb.position().linear()(i,j) );
+			a.t[i].push_back( bb.position().translation()[i] );
+		}
+		a.aa.push_back( bb.aa_ );
+		a.ss.push_back( bb.ss_ );
+		a.index.push_back( bb.index_ );
+	}
+	static void clear( Arrays & a ){
+		for( int i = 0; i < 3; ++i ){
+			for( int j = 0; j < 3; ++j ) a.r[i][j].clear();
+			a.t[i].clear();
+		}
+		a.aa.clear();
+		a.ss.clear();
+		a.index.clear();
+	}
+	template< class Xform >
+	static void transform( Arrays const & a, Xform const & xform, std::vector< actor::BackboneActor<X> > & out ){
+		Float xr[3][3], xt[3];
+		for( int i = 0; i < 3; ++i ){
+			for( int j = 0; j < 3; ++j ) xr[i][j] = xform.linear()(i,j);
+			xt[i] = xform.translation()[i];
+		}
+		for( size_t k = 0; k < out.size(); ++k ){
+			out[k].aa_ = a.aa[k];
+			out[k].ss_ = a.ss[k];
+			out[k].index_ = a.index[k];
+			X & p = out[k].position_;
+			for( int i = 0; i < 3; ++i ){
+				for( int j = 0; j < 3; ++j ){
+					p.linear()(i,j) = xr[i][0]*a.r[0][j][k] + xr[i][1]*a.r[1][j][k] + xr[i][2]*a.r[2][j][k];
+				}
+				p.translation()[i] = xr[i][0]*a.t[0][k] + xr[i][1]*a.t[1][k] + xr[i][2]*a.t[2][k] + xt[i];
+			}
+		}
+	}
+};
+
+}
 }
 }
 
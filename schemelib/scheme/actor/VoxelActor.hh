@@ -3,6 +3,8 @@
 
 #include "scheme/objective/voxel/VoxelArray.hh"
 
+#include <boost/mpl/bool.hpp>
+
 namespace scheme {
 namespace actor {
 
@@ -78,6 +80,8 @@ template< class VoxelActor, class Atom, bool REPL_ONLY = false >
 struct Score_Voxel_vs_Atom {
 	typedef float Result;
 	typedef std::pair<VoxelActor,Atom> Interaction;
+	// repulsion only can't lower a partial score, see ObjectiveFunction::score_with_cutoff
+	typedef boost::mpl::bool_<REPL_ONLY> NonNegative;
 	static std::string name(){ return "Score_Voxel_vs_Atom"; }
 	template<class Config>
 	Result operator()( VoxelActor const & v, Atom const & a, Config const& c ) const {
@@ -45,8 +45,8 @@ TEST( Director, test_NestDirector ){
 	scene.add_position(0);
 	scene.add_position(0);
 
-	NestDirector< Nest1D > d0(0);
-	NestDirector< Nest1D > d2(2);
+	NestDirector< Nest1D, uint64_t > d0(0);
+	NestDirector< Nest1D, uint64_t > d2(2);
 
 	d0.set_scene( 7, 3, scene );
 	ASSERT_EQ( Nest1D().set_and_get(7,3) , scene.position(0) );
@@ -96,7 +96,7 @@ TEST( Director, test_TreeDirector ){
 	int count = 0;
 	for( int resl = 0; resl < 8; ++resl ){
 		// cout << "================== resl " << resl << " ======================" << endl;
-		for( uint64_t i = 0; i < director.size(resl); ++i){
+		for( uint64_t i = 0; i < director.size(resl,0); ++i){
 			util::SimpleArray<2> tmp = refnest.set_and_get(i,resl);
 			// scene.set_position( 0, tmp[0] );
 			// scene.set_position( 1, tmp[1] );
@@ -118,6 +118,56 @@ TEST( Director, test_TreeDirector ){
 	ASSERT_NE( test->position(0)[0] , scene.position(0)[0] );
 }
 
+
+struct TestIndex {
+	uint64_t nest_index;
+	int scaffold_index;
+	TestIndex( uint64_t n = 0, int s = 0 ) : nest_index(n), scaffold_index(s) {}
+	bool operator==( TestIndex const & o ) const { return nest_index==o.nest_index && scaffold_index==o.scaffold_index; }
+};
+
+struct CountingTestScene : public TestScene {
+	int nreplace = 0;
+	virtual void replace_body( uint64_t, shared_ptr<ConformationBase const> ) override { ++nreplace; }
+	virtual shared_ptr<SceneBase<X1dim> > clone_deep() const override { return make_shared<CountingTestScene>(*this); }
+};
+
+struct TestScaffoldProvider {
+	typedef int ScaffoldIndex;
+	shared_ptr<ConformationBase const> get_scaffold( ScaffoldIndex ) const { return make_shared<ConformationBase>(); }
+};
+
+TEST( Director, set_scene_incremental ){
+	typedef scheme::nest::NEST<1,X1dim> Nest1D;
+	typedef Director< X1dim, TestIndex > Base;
+	std::vector< shared_ptr<Base> > directors;
+	directors.push_back( make_shared< NestDirector< Nest1D, TestIndex > >( 0 ) );
+	directors.push_back( make_shared< ScaffoldDirector< X1dim, TestScaffoldProvider, TestIndex > >(
+		make_shared<TestScaffoldProvider>(), 0 ) );
+	CompositeDirector< X1dim, TestIndex > director( directors );
+
+	CountingTestScene full, incr;
+	full.add_position(0);
+	incr.add_position(0);
+
+	TestIndex prev;
+	bool have_prev = false;
+	int const resl = 4; // 16 cells
+	for( int s = 0; s < 3; ++s ){
+		for( uint64_t n = 0; n < 10; ++n ){
+			TestIndex const i( (n*7)%16, s );
+			ASSERT_TRUE( director.set_scene( i, resl, full ) );
+			ASSERT_TRUE( have_prev ? director.set_scene_incremental( prev, resl, i, resl, incr )
+			                       : director.set_scene( i, resl, incr ) );
+			ASSERT_EQ( full.position(0), incr.position(0) );
+			prev = i;
+			have_prev = true;
+		}
+	}
+	ASSERT_EQ( 30, full.nreplace );
+	ASSERT_EQ( 3, incr.nreplace ); // once per scaffold
+}
+
 }
 }
 }
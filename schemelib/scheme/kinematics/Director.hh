@@ -5,10 +5,12 @@
 #include <scheme/kinematics/Director.meta.hh>
 
 #include "scheme/types.hh"
+#include "scheme/util/assert.hh"
 #include "scheme/kinematics/Scene.hh"
 #include "scheme/nest/MultiNest.hh"
 
 #include <boost/any.hpp>
+#include <Eigen/Geometry>
 
 #include <vector>
 
@@ -51,6 +53,21 @@ struct Director
 		Scene & scene
 	) const = 0;
 
+	///@brief same as set_scene( i, resl, scene ) on a scene whose last set_scene was
+	///       ( prev, prev_resl ) and returned true. directors may skip work that only
+	///       depends on parts of the index that did not change. default redoes everything
+	virtual
+	bool
+	set_scene_incremental(
+		BigIndex const & prev,
+		int prev_resl,
+		BigIndex const & i,
+		int resl,
+		Scene & scene
+	) const {
+		return set_scene( i, resl, scene );
+	}
+
 	virtual BigIndex size(int resl, BigIndex sizes) const = 0;
 
 };
@@ -128,6 +145,21 @@ struct NestDirector
 		return true;
 	}
 
+	// later directors may have moved ibody_ relative to this position, so only an
+	// identical index leaves the scene as is
+	virtual
+	bool
+	set_scene_incremental(
+		BigIndex const & prev,
+		int prev_resl,
+		BigIndex const & i,
+		int resl,
+		Scene & scene
+	) const {
+		if( prev_resl == resl && prev == i ) return true;
+		return set_scene( i, resl, scene );
+	}
+
 	virtual BigIndex size(int resl, BigIndex sizes) const {
 		set_nest_size(nest_.size(resl), sizes);
 		return sizes;
@@ -182,6 +214,24 @@ struct CompositeDirector
 		return true;
 	}
 
+	virtual
+	bool
+	set_scene_incremental(
+		BigIndex const & prev,
+		int prev_resl,
+		BigIndex const & i,
+		int resl,
+		Scene & scene
+	) const override {
+
+		for ( shared_ptr<Base> const & director : directors_ ) {
+			bool success = director->set_scene_incremental( prev, prev_resl, i, resl, scene );
+			if ( !success ) return false;
+		}
+
+		return true;
+	}
+
 	virtual BigIndex size(int resl, BigIndex sizes) const override {
 		for ( shared_ptr<Base> director : directors_ ) {
 			sizes = director->size(resl, sizes);
@@ -233,7 +283,7 @@ struct SeedingDirector
         int resl,
         Scene & scene
     ) const override {
-        runtime_assert( seeding_positions_ );
+        ALWAYS_ASSERT( seeding_positions_ );
             
         uint64_t si = i.seeding_index;
             
@@ -254,6 +304,20 @@ struct SeedingDirector
             
         return true;
     }
+
+    // composes with the position the NestDirector set, so redone whenever that was
+    virtual
+    bool
+    set_scene_incremental(
+        BigIndex const & prev,
+        int prev_resl,
+        BigIndex const & i,
+        int resl,
+        Scene & scene
+    ) const override {
+        if ( prev_resl == resl && prev == i ) return true;
+        return set_scene( i, resl, scene );
+    }
         
     // change the BigIndex Struct.
     virtual BigIndex size(int resl, BigIndex sizes) const override {
@@ -308,7 +372,7 @@ struct ScaffoldDirector
 		int resl,
 		Scene & scene
 	) const override {
-		runtime_assert( scaffold_provider_ );
+		ALWAYS_ASSERT( scaffold_provider_ );
 
 		ScaffoldIndex si = i.scaffold_index;
 
@@ -317,6 +381,20 @@ struct ScaffoldDirector
 		return true;
 	}
 
+	// the conformation only depends on the scaffold, positions are left alone
+	virtual
+	bool
+	set_scene_incremental(
+		BigIndex const & prev,
+		int prev_resl,
+		BigIndex const & i,
+		int resl,
+		Scene & scene
+	) const override {
+		if ( prev.scaffold_index == i.scaffold_index ) return true;
+		return set_scene( i, resl, scene );
+	}
+
 	// This doesn't actually work, the format of ScaffoldProvider.size() can't be returned in this format
 	virtual BigIndex size(int resl, BigIndex sizes) const override {
 		return sizes;
@@ -490,9 +568,8 @@ struct TreeDirector : public Director<_Position,_BigIndex,_Index> {
 		return true;
 	}
 
-	virtual void size(int resl, BigIndex & sizes) const { 
-		sizes = multinest_.size(resl);
-		return sizes;
+	virtual BigIndex size(int resl, BigIndex sizes) const {
+		return multinest_.size(resl);
 	}
 
 
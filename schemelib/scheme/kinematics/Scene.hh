@@ -14,6 +14,9 @@
 #include <boost/mpl/eval_if.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/transform.hpp>
+#include <boost/mpl/copy_if.hpp>
+#include <boost/mpl/remove_if.hpp>
+#include <boost/mpl/empty.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/fusion/include/vector.hpp>
 #include <boost/fusion/include/mpl.hpp>
@@ -124,6 +127,65 @@ namespace impl {
 	using m::false_;
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(Symmetric,true_)
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(RequireAbsolutePositioning,false_)
+	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(EarlyExit,false_)
+
+	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(BulkTransform,false_)
+
+	///@brief out[i] = Actor( container[i], x ), in one pass for BulkTransform containers
+	template<class Container, class Xform, class Actor>
+	typename boost::enable_if< typename get_BulkTransform_false_<Container>::type >::type
+	move_actors( Container const & container, Xform const & x, std::vector<Actor> & out ){
+		container.transform_into( x, out );
+	}
+	template<class Container, class Xform, class Actor>
+	typename boost::disable_if< typename get_BulkTransform_false_<Container>::type >::type
+	move_actors( Container const & container, Xform const & x, std::vector<Actor> & out ){
+		out.clear();
+		for( Actor const & a : container ) out.push_back( Actor( a, x ) );
+	}
+
+	///@brief this thread's buffer for the moved actors of one side of a body pair. reused by
+	///       every body pair so it is only reallocated when it grows
+	template<class Actor, int SIDE>
+	std::vector<Actor> & pair_side_scratch(){
+		static thread_local std::vector<Actor> scratch;
+		return scratch;
+	}
+
+	///@brief actors of one side of a body pair as visit_2b_inner would pass them: unmoved,
+	///       moved per access, or moved all at once into this thread's scratch for BulkTransform
+	///       containers. the scratch is overwritten by the next body pair on the thread, so
+	///       visitors must not start another scene visit
+	template<class Actor, int SIDE, class Container, class Position, bool MOVE,
+	         bool BULK = get_BulkTransform_false_<Container>::type::value >
+	struct PairSideActors {
+		Container const & c_;
+		PairSideActors( Container const & c, Position const & ) : c_(c) {}
+		Actor const & operator[]( size_t j ) const { return c_[j]; }
+	};
+	template<class Actor, int SIDE, class Container, class Position>
+	struct PairSideActors<Actor,SIDE,Container,Position,true,false> {
+		Container const & c_;
+		Position const & x_;
+		PairSideActors( Container const & c, Position const & x ) : c_(c), x_(x) {}
+		Actor operator[]( size_t j ) const { return Actor( c_[j], x_ ); }
+	};
+	template<class Actor, int SIDE, class Container, class Position>
+	struct PairSideActors<Actor,SIDE,Container,Position,true,true> {
+		std::vector<Actor> & moved_;
+		PairSideActors( Container const & c, Position const & x ) : moved_( pair_side_scratch<Actor,SIDE>() ) {
+			move_actors( c, x, moved_ );
+		}
+		Actor const & operator[]( size_t j ) const { return moved_[j]; }
+	};
+
+	///@brief visitors with EarlyExit stop the visit once done() is true
+	template<class Visitor>
+	typename boost::enable_if< typename get_EarlyExit_false_<Visitor>::type, bool >::type
+	visitor_done( Visitor const & visitor ){ return visitor.done(); }
+	template<class Visitor>
+	typename boost::disable_if< typename get_EarlyExit_false_<Visitor>::type, bool >::type
+	visitor_done( Visitor const & ){ return false; }
 
 	template<class _Interaction>
 	struct AccessVisitor {
@@ -336,6 +398,7 @@ namespace impl {
 		typedef std::vector<Body> Bodies;
 		typedef m::true_ DefinesInteractionWeight;
 		typedef m::true_ UseVisitor;
+		typedef m::true_ UseFusedVisitor;
 
 		Bodies bodies_;
 
@@ -479,6 +542,18 @@ namespace impl {
 		get_actor(Index ib, Index ia) const {
 			return conformation(ib).template get<Actor>().at(ia);
 		}
+		///@brief all Actors of body ib moved by x, in one pass if their container has BulkTransform
+		template<class Actor>
+		void
+		get_actors_moved( Index ib, Position const & x, std::vector<Actor> & out ) const {
+			impl::move_actors( conformation(ib).template get<Actor>(), x, out );
+		}
+		///@brief all Actors of body ib at its position, out[ia] == get_actor<Actor>(ib,ia)
+		template<class Actor>
+		void
+		get_actors_positioned( Index ib, std::vector<Actor> & out ) const {
+			get_actors_moved<Actor>( ib, this->position(ib), out );
+		}
 		template<class Actor>
 		void
 		clear_actors(Index ib){
@@ -604,6 +679,7 @@ namespace impl {
 				Container const & container = c.template get<Actor>();
 				BOOST_FOREACH( Actor const & a_0, container ){
 					visit_1b_inner(visitor,a_0,p);
+					if( impl::visitor_done(visitor) ) return;
 				}
 			}
 
@@ -625,52 +701,244 @@ namespace impl {
 		visit(Visitor & visitor) const {
 			typedef typename Visitor::Interaction::first_type Actor1;
 			typedef typename Visitor::Interaction::second_type Actor2;
-			typedef typename f::result_of::value_at_key<Conformation,Actor1>::type Container1;
-			typedef typename f::result_of::value_at_key<Conformation,Actor2>::type Container2;
-			typedef util::container::ContainerInteractions<typename Scene::Position,Container1,Container2,Index> ContInter;
-			typedef typename ContInter::Range ContRange;
-			typename util::container::get_citer<ContRange>::type iter,end;
+			typedef typename util::container::ContainerInteractions<typename Scene::Position,
+				typename f::result_of::value_at_key<Conformation,Actor1>::type,
+				typename f::result_of::value_at_key<Conformation,Actor2>::type,Index>::Range ContRange;
 			ContRange range;
 
 			Index const NBOD = (Index)bodies_.size();
 			Index const NSYM = (Index)this->symframes_.size();
-			for(Index i1 = 0; i1 < NBOD*NSYM; ++i1){
-				Conformation const & c1 =   conformation(i1);
-				Position     const & p1 = this->position(i1);
+			bool const orbits = use_orbits<Visitor>();
+			Index const NBOD1 = orbits ? NBOD : NBOD*NSYM;
+			for(Index i1 = 0; i1 < NBOD1; ++i1){
 				for(Index i2 = 0; i2 < NBOD*NSYM; ++i2){
-					if( i1 >= NBOD && i2 >= NBOD ) continue;
-					if( i1==i2 || (boost::is_same<Actor1,Actor2>::value && i2 <= i1) ) continue;
-					Conformation const & c2 =   conformation(i2);
-					Position     const & p2 = this->position(i2);
+					double const w = body_pair_weight< boost::is_same<Actor1,Actor2>::value >( i1, i2, NBOD, orbits );
+					if( w == 0.0 ) continue;
 
 					// // simple version, ~10-15% faster in simple case
+					// Conformation const & c1 = conformation(i1), & c2 = conformation(i2);
 					// Index const NACT1 = c1.template get<Actor1>().size();
 					// Index const NACT2 = c2.template get<Actor2>().size();
 					// for(Index j1 = 0; j1 < NACT1; ++j1){
-					// 	Actor1 a1( c1.template get<Actor1>()[j1], p1 );
+					// 	Actor1 a1( c1.template get<Actor1>()[j1], position(i1) );
 					// 	for(Index j2 = 0; j2 < NACT2; ++j2){
-					// 		Actor2 a2( c2.template get<Actor2>()[j2], p2 );
+					// 		Actor2 a2( c2.template get<Actor2>()[j2], position(i2) );
 					// 		visitor( std::make_pair(a1,a2), i1<NBOD&&i2<NBOD?1.0:0.5 );
 					// 	}
 					// }
 
-					Container1 const & container1 = c1.template get<Actor1>();
-					Container2 const & container2 = c2.template get<Actor2>();
 					Position const rel_pos = inverse(__position_unsafe__(i1))*( __position_unsafe__(i2) );
-					ContInter::get_interaction_range( rel_pos, container1, container2, range );
-					for( iter = get_cbegin(range),end  = get_cend(range); iter != end; ++iter){
-						double const w = i1<NBOD&&i2<NBOD?1.0:0.5;
-						Index j1,j2;
-						boost::tie(j1,j2) = *iter;
-						Actor1 const & a1_0( c1.template get<Actor1>()[j1] );
-						Actor2 const & a2_0( c2.template get<Actor2>()[j2] );
-						visit_2b_inner(visitor,a1_0,a2_0,p1,p2,rel_pos,w);
-					}
+					if( visit_2b_bodies<Actor1,Actor2>( visitor, i1, i2, rel_pos, w, range ) ) return;
+				}
+			}
+
+		}
+
+		///@brief visit each Interaction in Visitor::Interactions in one pass over the scene: each
+		///       asym body once for all onebody Interactions, then each body pair once for all pair
+		///       Interactions, sharing rel_pos. weights are the same as from visit, so results
+		///       differ from visiting each Interaction in turn only by summation order
+		///@note Visitor must have template operator()<Interaction>( a, w ) and ( a1, a2, w )
+		template<class Visitor>
+		void
+		visit_fused(Visitor & visitor) const {
+			typedef typename Visitor::Interactions Interactions;
+			typedef typename m::remove_if< Interactions, util::meta::is_pair<m::_1>, m::back_inserter<m::vector<> > >::type OneBody;
+			typedef typename m::copy_if  < Interactions, util::meta::is_pair<m::_1>, m::back_inserter<m::vector<> > >::type TwoBody;
+			bool done = false;
+
+			Index const NBOD = (Index)bodies_.size();
+			for(Index i = 0; i < NBOD; ++i){
+				m::for_each< OneBody, util::meta::type2type<m::_1> >( Visit1BFused<Visitor>( *this, visitor, i, done ) );
+				if( done ) return;
+			}
+			if( m::empty<TwoBody>::value ) return;
+
+			Index const NSYM = (Index)this->symframes_.size();
+			bool const orbits = use_orbits<Visitor>();
+			Index const NBOD1 = orbits ? NBOD : NBOD*NSYM;
+			for(Index i1 = 0; i1 < NBOD1; ++i1){
+				for(Index i2 = 0; i2 < NBOD*NSYM; ++i2){
+					if( i1==i2 || ( i1 >= NBOD && i2 >= NBOD ) ) continue;
+					Position const rel_pos = inverse(__position_unsafe__(i1))*( __position_unsafe__(i2) );
+					m::for_each< TwoBody, util::meta::type2type<m::_1> >(
+						Visit2BFused<Visitor>( *this, visitor, i1, i2, NBOD, orbits, rel_pos, done ) );
+					if( done ) return;
+				}
+			}
+		}
+
+	private:
+
+		// orbits only hold for relative positions, a visitor seeing absolute ones needs every pair
+		template<class Visitor>
+		bool use_orbits() const {
+			return !impl::get_RequireAbsolutePositioning_false_<Visitor>::type::value &&
+			       this->symframes_.size() > 1 && this->symframe_inverses_.size() == this->symframes_.size();
+		}
+
+		///@brief weight of the interactions between bodies i1 and i2, 0 if they are not visited.
+		///       SAME if both actors are of one type, then only i1 < i2 is visited
+		///@detail with symframe inverses known, (a,k*b) is the same pair as (b,inv(k)*a), and for
+		///        different actor types (k*a,b) as (a,inv(k)*b), so i1 need only be an asym body
+		///        and one representative of each orbit is visited with the orbit's weight
+		template<bool SAME>
+		double body_pair_weight( Index i1, Index i2, Index NBOD, bool orbits ) const {
+			if( i1 >= NBOD && i2 >= NBOD ) return 0.0;
+			if( i1==i2 || ( SAME && i2 <= i1 ) ) return 0.0;
+			if( !orbits || i2 < NBOD ) return i1<NBOD&&i2<NBOD?1.0:0.5;
+			if( !SAME ) return 1.0;
+			Index const k = i2/NBOD, b = i2%NBOD, kinv = this->symframe_inverses_[k];
+			if( b < i1 || ( b == i1 && kinv < k ) ) return 0.0;
+			return b == i1 && kinv == k ? 0.5 : 1.0;
+		}
+
+		///@brief visit all Actor1,Actor2 interactions between bodies i1 and i2
+		///@return true if the visitor is done
+		template<class Actor1, class Actor2, class Visitor, class ContRange>
+		bool
+		visit_2b_bodies(
+			Visitor & visitor,
+			Index i1,
+			Index i2,
+			Position const & rel_pos,
+			double w,
+			ContRange & range
+		) const {
+			typedef typename f::result_of::value_at_key<Conformation,Actor1>::type Container1;
+			typedef typename f::result_of::value_at_key<Conformation,Actor2>::type Container2;
+			// the same frames visit_2b_inner moves each actor by
+			bool const ABS = impl::get_RequireAbsolutePositioning_false_<Visitor>::type::value &&
+			                 impl::has_type_Position<Actor1>::value && impl::has_type_Position<Actor2>::value;
+			bool const MOVE1 = impl::has_type_Position<Actor1>::value && ( ABS || !impl::has_type_Position<Actor2>::value );
+			bool const MOVE2 = impl::has_type_Position<Actor2>::value;
+			typedef m::bool_<
+				( MOVE1 && impl::get_BulkTransform_false_<Container1>::type::value ) ||
+				( MOVE2 && impl::get_BulkTransform_false_<Container2>::type::value ) > Bulk;
+			return visit_2b_bodies_impl<Actor1,Actor2,MOVE1,MOVE2,ABS>( visitor, i1, i2, rel_pos, w, range, Bulk() );
+		}
 
+		///@brief visit_2b_bodies moving whole containers at once, for BulkTransform containers
+		template<class Actor1, class Actor2, bool MOVE1, bool MOVE2, bool ABS, class Visitor, class ContRange>
+		bool
+		visit_2b_bodies_impl(
+			Visitor & visitor,
+			Index i1,
+			Index i2,
+			Position const & rel_pos,
+			double w,
+			ContRange & range,
+			m::true_
+		) const {
+			typedef typename f::result_of::value_at_key<Conformation,Actor1>::type Container1;
+			typedef typename f::result_of::value_at_key<Conformation,Actor2>::type Container2;
+			typedef util::container::ContainerInteractions<typename Scene::Position,Container1,Container2,Index> ContInter;
+			typename util::container::get_citer<ContRange>::type iter,end;
+			Container1 const & container1 = conformation(i1).template get<Actor1>();
+			Container2 const & container2 = conformation(i2).template get<Actor2>();
+			ContInter::get_interaction_range( rel_pos, container1, container2, range );
+			if( util::container::get_cbegin(range) == util::container::get_cend(range) ) return false;
+			Position const x1 = ABS ? this->position(i1) : inverse(rel_pos);
+			Position const x2 = ABS ? this->position(i2) : rel_pos;
+			impl::PairSideActors<Actor1,1,Container1,Position,MOVE1> const actors1( container1, x1 );
+			impl::PairSideActors<Actor2,2,Container2,Position,MOVE2> const actors2( container2, x2 );
+			for( iter = util::container::get_cbegin(range),end  = util::container::get_cend(range); iter != end; ++iter){
+				Index j1,j2;
+				boost::tie(j1,j2) = *iter;
+				visitor.template operator()< std::pair<Actor1,Actor2> >( actors1[j1], actors2[j2], w );
+				if( impl::visitor_done(visitor) ) return true;
+			}
+			return false;
+		}
+
+		///@brief visit_2b_bodies building each moved actor per interaction, with visit_2b_inner
+		template<class Actor1, class Actor2, bool MOVE1, bool MOVE2, bool ABS, class Visitor, class ContRange>
+		bool
+		visit_2b_bodies_impl(
+			Visitor & visitor,
+			Index i1,
+			Index i2,
+			Position const & rel_pos,
+			double w,
+			ContRange & range,
+			m::false_
+		) const {
+			typedef typename f::result_of::value_at_key<Conformation,Actor1>::type Container1;
+			typedef typename f::result_of::value_at_key<Conformation,Actor2>::type Container2;
+			typedef util::container::ContainerInteractions<typename Scene::Position,Container1,Container2,Index> ContInter;
+			typename util::container::get_citer<ContRange>::type iter,end;
+			Conformation const & c1 =   conformation(i1);
+			Position     const & p1 = this->position(i1);
+			Conformation const & c2 =   conformation(i2);
+			Position     const & p2 = this->position(i2);
+			Container1 const & container1 = c1.template get<Actor1>();
+			Container2 const & container2 = c2.template get<Actor2>();
+			ContInter::get_interaction_range( rel_pos, container1, container2, range );
+			for( iter = util::container::get_cbegin(range),end  = util::container::get_cend(range); iter != end; ++iter){
+				Index j1,j2;
+				boost::tie(j1,j2) = *iter;
+				Actor1 const & a1_0( container1[j1] );
+				Actor2 const & a2_0( container2[j2] );
+				visit_2b_inner(visitor,a1_0,a2_0,p1,p2,rel_pos,w);
+				if( impl::visitor_done(visitor) ) return true;
+			}
+			return false;
+		}
+
+		template<class Visitor>
+		struct Visit1BFused {
+			This const & scene_;
+			Visitor & visitor_;
+			Index i_;
+			bool & done_;
+			Visit1BFused( This const & s, Visitor & v, Index i, bool & d ) : scene_(s), visitor_(v), i_(i), done_(d) {}
+			template<class Actor>
+			void operator()( util::meta::type2type<Actor> ) const {
+				if( done_ ) return;
+				Position const & p = scene_.position(i_);
+				BOOST_FOREACH( Actor const & a_0, scene_.conformation(i_).template get<Actor>() ){
+					scene_.visit_1b_fused_inner( visitor_, a_0, p );
+					if( impl::visitor_done(visitor_) ){ done_ = true; return; }
 				}
 			}
+		};
 
+		template<class Visitor>
+		struct Visit2BFused {
+			This const & scene_;
+			Visitor & visitor_;
+			Index i1_, i2_, nbod_;
+			bool orbits_;
+			Position const & rel_pos_;
+			bool & done_;
+			Visit2BFused( This const & s, Visitor & v, Index i1, Index i2, Index nbod, bool orbits, Position const & rel_pos, bool & d )
+			 : scene_(s), visitor_(v), i1_(i1), i2_(i2), nbod_(nbod), orbits_(orbits), rel_pos_(rel_pos), done_(d) {}
+			template<class Interaction>
+			void operator()( util::meta::type2type<Interaction> ) const {
+				typedef typename Interaction::first_type Actor1;
+				typedef typename Interaction::second_type Actor2;
+				if( done_ ) return;
+				double const w = scene_.template body_pair_weight< boost::is_same<Actor1,Actor2>::value >( i1_, i2_, nbod_, orbits_ );
+				if( w == 0.0 ) return;
+				typename util::container::ContainerInteractions<typename Scene::Position,
+					typename f::result_of::value_at_key<Conformation,Actor1>::type,
+					typename f::result_of::value_at_key<Conformation,Actor2>::type,Index>::Range range;
+				done_ = scene_.template visit_2b_bodies<Actor1,Actor2>( visitor_, i1_, i2_, rel_pos_, w, range );
+			}
+		};
+
+		template<class Visitor, class Actor>
+		typename boost::enable_if< impl::has_type_Position<Actor> >::type
+		visit_1b_fused_inner( Visitor & visitor, Actor const & a_0, Position const & p ) const {
+			visitor.template operator()<Actor>( Actor(a_0,p), 1.0 );
 		}
+		template<class Visitor, class Actor>
+		typename boost::disable_if< impl::has_type_Position<Actor> >::type
+		visit_1b_fused_inner( Visitor & visitor, Actor const & a_0, Position const &   ) const {
+			visitor.template operator()<Actor>( a_0, 1.0 );
+		}
+
+	public:
 
 		///@brief visit_2b_inner specialization handles case where both actors are positionable (not fixed)
 		template<class Visitor, class Actor1, class Actor2>
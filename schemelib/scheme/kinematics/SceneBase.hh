@@ -24,6 +24,7 @@ struct SceneBase {
 		std::vector<Position> symframes_; // include identity at first position
 		Index n_sym_bodies_, n_bodies_;
 		std::vector<Position> positions_;
+		std::vector<Index> symframe_inverses_; // symframes_[symframe_inverses_[k]] is the inverse of symframes_[k], empty if unknown
 
 	SceneBase() : n_bodies_(0), n_sym_bodies_(0), symframes_(1,Position::Identity()) {}
 
@@ -98,9 +99,27 @@ struct SceneBase {
 		return isym;
 	}
 
-	void set_symmetry(std::vector<Position> const & sym){ symframes_ = sym; update_symmetry(n_bodies_); }
-	void add_symframe(Position const & symframe){ symframes_.push_back(symframe); update_symmetry(n_bodies_); }
+	void set_symmetry(std::vector<Position> const & sym){ symframes_ = sym; symframe_inverses_.clear(); update_symmetry(n_bodies_); }
+	void add_symframe(Position const & symframe){ symframes_.push_back(symframe); symframe_inverses_.clear(); update_symmetry(n_bodies_); }
 	std::vector<Position> const & symframes() const { return symframes_; }
+
+	///@brief if every symframe's inverse is also a symframe, record which, so pair interactions
+	///       can be visited once per symmetry orbit. equal(a,b) compares Positions, approximately
+	///@return false, and orbits not used, if some inverse is missing
+	template< class Equal >
+	bool find_symframe_inverses( Equal const & equal ){
+		symframe_inverses_.clear();
+		std::vector<Index> inv( symframes_.size() );
+		for( Index k = 0; k < (Index)symframes_.size(); ++k ){
+			Index j = 0;
+			while( j < (Index)symframes_.size() && !equal( symframes_[j] * symframes_[k], Position::Identity() ) ) ++j;
+			if( j == (Index)symframes_.size() ) return false;
+			inv[k] = j;
+		}
+		symframe_inverses_ = inv;
+		return true;
+	}
+	std::vector<Index> const & symframe_inverses() const { return symframe_inverses_; }
 	Index nbodies() const { return n_sym_bodies_; }
 	Index nbodies_asym() const { return n_bodies_; }
 
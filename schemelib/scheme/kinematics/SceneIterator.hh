@@ -213,15 +213,15 @@ using std::endl;
 		SceneIter2B(){}
 		SceneIter2B(Scene const & s, Index ib1, Index ib2) : scene_(&s),ibody1_(ib1),ibody2_(ib2){}
 		void
-		update_range(){ // X * A = B, X = B * ~A
+		update_range(){ // body2 frame to body1 frame, same as Scene::visit
 			assert( ibody1_ < scene_->nbodies_asym() || ibody2_ < scene_->nbodies_asym() );
 			ContInter::get_interaction_range(
-				scene_->__position_unsafe__(ibody2_) * inverse( scene_->__position_unsafe__(ibody1_) ) ,
+				inverse( scene_->__position_unsafe__(ibody1_) ) * scene_->__position_unsafe__(ibody2_) ,
 				scene_->__conformation_unsafe__(ibody1_).template get<Actor1>()  ,
 				scene_->__conformation_unsafe__(ibody2_).template get<Actor2>()  ,
 				range_  );
-			iter_ = get_cbegin(range_);
-			end_  = get_cend(range_);
+			iter_ = util::container::get_cbegin(range_);
+			end_  = util::container::get_cend(range_);
 			// cout << "UPDATE_RANGE " << ibody1_ << " " << ibody2_ << " beg " << *iter_ << " end " << *end_ << endl;
 		}
 		static
@@ -60,6 +60,12 @@ typedef std::pair<Index2,Index2> Index4;
 	size_t ScoreADIADI::ncalls = 0;
 	std::ostream & operator<<(std::ostream & out,ScoreADIADI const& s){ return out << s.name(); }
 
+	struct ScoreADIADINonNeg : ScoreADIADI {
+		typedef m::true_ NonNegative;
+		static std::string name(){ return "ScoreADIADINonNeg"; }
+	};
+	std::ostream & operator<<(std::ostream & out,ScoreADIADINonNeg const& s){ return out << s.name(); }
+
 	struct ScoreADC {
 		typedef double Result;
 		typedef ADC Interaction;
@@ -178,6 +184,184 @@ TEST(SceneObjective,symmetry){
 
 }
 
+TEST(SceneObjective,symmetry_orbits){
+	typedef	objective::ObjectiveFunction<
+		m::vector<
+			ScoreADI,
+			ScoreADIADI,
+			ScoreADCADI
+		>,
+		Config
+	> ObjFun;
+	typedef ObjFun::Results Results;
+	ObjFun score;
+
+	typedef m::vector< ADI, ADC > Actors;
+	typedef Scene<impl::Conformation<Actors>,X1dim,size_t> Scene;
+
+	Scene scene(3);
+	scene.add_symframe(10);
+	scene.add_symframe(-10);
+	scene.add_symframe(25);
+	scene.add_symframe(-25);
+	scene.add_symframe(50); // self-inverse in a group of translations mod 100, here it has none
+	for( int i = 0; i < 3; ++i ){
+		scene.mutable_conformation_asym(i).add_actor( ADI(i,1) );
+		scene.mutable_conformation_asym(i).add_actor( ADI(2*i+1,2) );
+		scene.mutable_conformation_asym(i).add_actor( ADC(i-1,'1') );
+	}
+	scene.set_position( 1, X1dim(3) );
+	scene.set_position( 2, X1dim(-7) );
+
+	std::equal_to<X1dim> equal;
+	ASSERT_FALSE( scene.find_symframe_inverses( equal ) );
+	ASSERT_TRUE( scene.symframe_inverses().empty() );
+	scene.add_symframe(-50);
+
+	ScoreADIADI::ncalls = 0;
+	Results ref = score(scene);
+	size_t const ncalls_ref = ScoreADIADI::ncalls;
+
+	ASSERT_TRUE( scene.find_symframe_inverses( equal ) );
+	ASSERT_EQ( std::vector<size_t>({0,2,1,4,3,6,5}), scene.symframe_inverses() );
+	ScoreADIADI::ncalls = 0;
+	Results orb = score(scene);
+	ASSERT_NEAR( ref.get<ScoreADI>(), orb.get<ScoreADI>(), 1e-9 );
+	ASSERT_NEAR( ref.get<ScoreADIADI>(), orb.get<ScoreADIADI>(), 1e-9 );
+	ASSERT_NEAR( ref.get<ScoreADCADI>(), orb.get<ScoreADCADI>(), 1e-9 );
+	// 3 asym body pairs and 3x18 asym x copy body pairs, 4 actor pairs each. no frame is
+	// its own inverse, so each asym x copy pair has exactly one equivalent
+	ASSERT_EQ( 4*3 + 4*3*18, ncalls_ref );
+	ASSERT_EQ( 4*3 + 4*3*18/2, ScoreADIADI::ncalls );
+
+	// changing the frames drops the inverses
+	scene.add_symframe(77);
+	ASSERT_TRUE( scene.symframe_inverses().empty() );
+}
+
+// not invariant to moving both actors by the same frame, so orbits would change it
+struct AbsoluteADIADIVisitor {
+	typedef std::pair<ADI,ADI> Interaction;
+	typedef m::vector<Interaction> Interactions;
+	typedef m::true_ RequireAbsolutePositioning;
+	double sum = 0;
+	size_t ncalls = 0;
+	template<class I>
+	void operator()( ADI const & a1, ADI const & a2, double w ){
+		++ncalls;
+		sum += w * ( a1.position().val_ + 3*a2.position().val_ ) * a1.data_;
+	}
+};
+
+TEST(SceneObjective,symmetry_orbits_absolute_visitor){
+	typedef m::vector< ADI, ADC > Actors;
+	typedef Scene<impl::Conformation<Actors>,X1dim,size_t> Scene;
+
+	Scene scene(2);
+	scene.add_symframe(10);
+	scene.add_symframe(-10);
+	scene.add_symframe(25);
+	scene.add_symframe(-25);
+	for( int i = 0; i < 2; ++i ){
+		scene.mutable_conformation_asym(i).add_actor( ADI(i,1) );
+		scene.mutable_conformation_asym(i).add_actor( ADI(2*i+1,2) );
+	}
+	scene.set_position( 1, X1dim(3) );
+
+	AbsoluteADIADIVisitor ref, ref_fused;
+	scene.visit( ref );
+	scene.visit_fused( ref_fused );
+	ASSERT_NE( 0, ref.sum );
+	ASSERT_NEAR( ref.sum, ref_fused.sum, 1e-9 );
+
+	ASSERT_TRUE( scene.find_symframe_inverses( std::equal_to<X1dim>() ) );
+	AbsoluteADIADIVisitor orb, orb_fused;
+	scene.visit( orb );
+	scene.visit_fused( orb_fused );
+	ASSERT_NEAR( ref.sum, orb.sum, 1e-9 );
+	ASSERT_NEAR( ref.sum, orb_fused.sum, 1e-9 );
+	ASSERT_EQ( ref.ncalls, orb.ncalls );
+	ASSERT_EQ( ref.ncalls, orb_fused.ncalls );
+}
+
+TEST(SceneObjective,fused_matches_separate){
+	typedef m::vector< ScoreADI, ScoreADC, ScoreADIADI, ScoreADCADI > Objectives;
+	typedef objective::ObjectiveFunction< Objectives, Config > ObjFun;
+	typedef objective::ObjectiveFunction< Objectives, Config, true > FusedObjFun;
+	ObjFun score;
+	FusedObjFun score_fused;
+
+	typedef m::vector< ADI, ADC > Actors;
+	typedef Scene<impl::Conformation<Actors>,X1dim,size_t> Scene;
+
+	Scene scene(3);
+	scene.add_symframe(10);
+	scene.add_symframe(-10);
+	for( int i = 0; i < 3; ++i ){
+		scene.mutable_conformation_asym(i).add_actor( ADI(i,1) );
+		scene.mutable_conformation_asym(i).add_actor( ADI(2*i+1,2) );
+		scene.mutable_conformation_asym(i).add_actor( ADC(i-1,'1'+i) );
+	}
+	scene.set_position( 1, X1dim(3) );
+	scene.set_position( 2, X1dim(-7) );
+
+	for( int orbits = 0; orbits < 2; ++orbits ){
+		if( orbits ) ASSERT_TRUE( scene.find_symframe_inverses( std::equal_to<X1dim>() ) );
+		ScoreADIADI::ncalls = 0;
+		ObjFun::Results ref = score(scene);
+		size_t const ncalls_ref = ScoreADIADI::ncalls;
+		ScoreADIADI::ncalls = 0;
+		FusedObjFun::Results fused = score_fused(scene);
+		ASSERT_EQ( ncalls_ref, ScoreADIADI::ncalls );
+		ASSERT_NEAR( ref.get<ScoreADI   >(), fused.get<ScoreADI   >(), 1e-9 );
+		ASSERT_NEAR( ref.get<ScoreADC   >(), fused.get<ScoreADC   >(), 1e-9 );
+		ASSERT_NEAR( ref.get<ScoreADIADI>(), fused.get<ScoreADIADI>(), 1e-9 );
+		ASSERT_NEAR( ref.get<ScoreADCADI>(), fused.get<ScoreADCADI>(), 1e-9 );
+		ASSERT_GT( ref.get<ScoreADCADI>(), 0 );
+	}
+}
+
+TEST(SceneObjective,score_with_cutoff){
+	typedef	objective::ObjectiveFunction<
+		m::vector<
+			ScoreADI,
+			ScoreADIADINonNeg
+		>,
+		Config
+	> ObjFun;
+	typedef ObjFun::Results Results;
+	ObjFun score;
+
+	typedef m::vector< ADI, ADC > Actors;
+	typedef Scene<impl::Conformation<Actors>,X1dim,size_t> Scene;
+
+	Scene scene(2);
+	for( int i = 0; i < 10; ++i ){
+		scene.mutable_conformation_asym(0).add_actor( ADI(i,-10) );
+		scene.mutable_conformation_asym(1).add_actor( ADI(i,-10) );
+	}
+	scene.set_position( 1, X1dim(100) );
+	Results full = score(scene);
+	ASSERT_EQ( full, Results(-200,10000) );
+
+	Results r;
+	ScoreADIADI::ncalls = 0;
+	ASSERT_TRUE( score.score_with_cutoff( scene, Config(), full.sum(), r ) );
+	ASSERT_EQ( full, r );
+	ASSERT_EQ( 100, ScoreADIADI::ncalls );
+
+	// the onebody terms are scored first, then pair terms until the total is > cut
+	ScoreADIADI::ncalls = 0;
+	ASSERT_FALSE( score.score_with_cutoff( scene, Config(), 0, r ) );
+	ASSERT_GT( r.sum(), 0 );
+	ASSERT_EQ( 2, ScoreADIADI::ncalls ); // -200 + 100 + 101
+
+	// no pair terms needed
+	ScoreADIADI::ncalls = 0;
+	ASSERT_FALSE( score.score_with_cutoff( scene, Config(), -300, r ) );
+	ASSERT_EQ( 0, ScoreADIADI::ncalls );
+}
+
 
 
 
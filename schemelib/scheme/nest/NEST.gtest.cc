@@ -10,6 +10,7 @@
 #include "scheme/nest/pmap/DiscreteChoiceMap.hh"
 #include <boost/foreach.hpp>
 #include <iterator>
+#include <memory>
 
 // #include <Eigen/Core>
 
@@ -220,6 +221,22 @@ TEST(NEST,bounds){
 	#endif
 }
 
+TEST(NEST,get_states){
+	NEST<3> nest(2);
+	for( int resl = 0; resl < 4; ++resl ){
+		std::vector<uint64_t> index;
+		for( uint64_t i = 0; i < nest.size(resl)+3; i += 3 ) index.push_back(i);
+		std::vector< NEST<3>::Value > vals( index.size() );
+		std::unique_ptr<bool[]> valid( new bool[index.size()] );
+		nest.get_states( &index[0], index.size(), resl, &vals[0], valid.get() );
+		for( size_t k = 0; k < index.size(); ++k ){
+			NEST<3>::Value ref;
+			ASSERT_EQ( nest.get_state( index[k], resl, ref ), valid[k] );
+			if( valid[k] ) ASSERT_EQ( ref, vals[k] );
+		}
+	}
+}
+
 TEST(NEST,virtual_get_index){
 	std::mt19937 rng((unsigned int)time(0));
 	std::uniform_real_distribution<> uniform;
@@ -13,6 +13,8 @@
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <boost/type_traits/make_signed.hpp>
 #include <boost/any.hpp>
@@ -203,6 +205,62 @@ namespace nest {
 			std::exit(-1);
 		}
 
+		////////////////// batch decode through the parameter map's params_to_values if it
+		////////////////// has one, else params_to_value one at a time
+		SCHEME_HAS_CONST_MEMBER_FUNCTION_6(params_to_values)
+
+		template<class Nest>
+		typename boost::enable_if_c<
+			has_const_member_fun_params_to_values<
+				typename Nest::ParamMapType,
+				void,
+				typename Nest::Params const *,
+				typename Nest::Index const *,
+				size_t,
+				typename Nest::Index,
+				typename Nest::Value *,
+				bool *
+				>::value,
+			void >::type
+		params_to_values(
+			Nest const & nest,
+			typename Nest::Params const * params,
+			typename Nest::Index const * cell_index,
+			size_t n,
+			typename Nest::Index resl,
+			typename Nest::Value * values,
+			bool * valid
+		) {
+			nest.params_to_values( params, cell_index, n, resl, values, valid );
+		}
+
+		template<class Nest>
+		typename boost::disable_if_c<
+			has_const_member_fun_params_to_values<
+				typename Nest::ParamMapType,
+				void,
+				typename Nest::Params const *,
+				typename Nest::Index const *,
+				size_t,
+				typename Nest::Index,
+				typename Nest::Value *,
+				bool *
+				>::value,
+			void >::type
+		params_to_values(
+			Nest const & nest,
+			typename Nest::Params const * params,
+			typename Nest::Index const * cell_index,
+			size_t n,
+			typename Nest::Index resl,
+			typename Nest::Value * values,
+			bool * valid
+		) {
+			for( size_t k = 0; k < n; ++k ){
+				valid[k] = nest.params_to_value( params[k], cell_index[k], resl, values[k] );
+			}
+		}
+
 
 		SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(Scalar,double)
 
@@ -444,6 +502,42 @@ namespace nest {
 			return set_value( index, resl, v );
 		}
 
+		///@brief get_state for n indices at once, valid[k] is false iff index[k] is invalid
+		///@detail runs of indices with the same parent, like the ONE<<DIM children of one bin,
+		///        share the undilation of their common bits. the params are then decoded
+		///        together by the ParamMap's params_to_values if it has one (OriTransMap)
+		///@note values[k] is unspecified where !valid[k]
+		void
+		get_states( Index const * index, size_t n, Index resl, Value * values, bool * valid ) const {
+			assert(resl<=MAX_RESL_ONE_CELL); // not rigerous check if Ncells > 1
+			size_t const BATCH = 64;
+			Params params[BATCH];
+			Index cell_index[BATCH];
+			Index const nsize = size(resl);
+			Index const hier_mask = (ONE<<(DIM*resl))-1;
+			Float const scale = 1.0 / Float(ONE<<resl);
+			Index parent = std::numeric_limits<Index>::max();
+			Index parent_undilated[DIM];
+			for( size_t b = 0; b < n; b += BATCH ){
+				size_t const m = std::min( BATCH, n-b );
+				for( size_t k = 0; k < m; ++k ){
+					Index const i = index[b+k] < nsize ? index[b+k] : 0; // flagged invalid below
+					Index const hier_index = i & hier_mask;
+					cell_index[k] = i >> (DIM*resl);
+					if( i>>DIM != parent ){
+						parent = i>>DIM;
+						for( size_t d = 0; d < DIM; ++d ) parent_undilated[d] = util::undilate<DIM>( hier_index>>DIM>>d ) << 1;
+					}
+					for( size_t d = 0; d < DIM; ++d ){
+						Index const undilated = parent_undilated[d] | ( hier_index>>d & ONE );
+						params[k][d] = ( static_cast<Float>(undilated) + 0.5 ) * scale;
+					}
+				}
+				impl::params_to_values( *this, params, cell_index, m, resl, values+b, valid+b );
+				for( size_t k = 0; k < m; ++k ) if( index[b+k] >= nsize ) valid[b+k] = false;
+			}
+		}
+
 		///////////////////////////////////////
 		//// virtual interface functions
 		///////////////////////////////////////
@@ -3,6 +3,9 @@
 #include "scheme/nest/pmap/OriTransMap.hh"
 #include "scheme/nest/NEST.hh"
 
+#include <memory>
+#include <random>
+
 
 
 namespace scheme {
@@ -71,6 +74,37 @@ TEST( OriTransMap, lookups_multicell_ori ){
 	ASSERT_LE( nfail*1./end, 0.1 );
 }
 
+TEST( OriTransMap, get_states_matches_get_state ){
+	typedef Eigen::Transform<float,3,Eigen::AffineCompact> EigenXform;
+	typedef NEST<6,EigenXform,OriTransMap,util::StoreNothing,uint64_t,float,false> Nest;
+
+	Nest nest( 30.0, -8.0, 8.0, 4 );
+	std::mt19937_64 rng(0);
+	for( int resl = 0; resl < 4; ++resl ){
+		// children of random parents in blocks of 64, as hsearch expands them, then random indices
+		std::vector<uint64_t> index;
+		for( int i = 0; i < 20; ++i ){
+			uint64_t const parent = rng() % nest.size( std::max( 0, resl-1 ) );
+			for( uint64_t j = 0; j < 64; ++j ) index.push_back( resl ? parent*64+j : ( parent + j ) % nest.size(0) );
+		}
+		for( int i = 0; i < 100; ++i ) index.push_back( rng() % nest.size( resl ) );
+		index.push_back( nest.size( resl ) ); // out of range
+		std::vector<EigenXform> x( index.size() );
+		std::unique_ptr<bool[]> valid( new bool[ index.size() ] );
+		nest.get_states( &index[0], index.size(), resl, &x[0], valid.get() );
+		int nvalid = 0;
+		for( size_t k = 0; k < index.size(); ++k ){
+			EigenXform ref;
+			ASSERT_EQ( nest.get_state( index[k], resl, ref ), valid[k] );
+			if( !valid[k] ) continue;
+			++nvalid;
+			ASSERT_TRUE( x[k].matrix().isApprox( ref.matrix(), 1e-5 ) );
+		}
+		ASSERT_FALSE( valid[ index.size()-1 ] );
+		ASSERT_GT( nvalid, index.size()/2 );
+	}
+}
+
 TEST( OriTransMap, name ){
 	typedef Eigen::Transform<double,3,Eigen::AffineCompact> EigenXform;
 
@@ -9,6 +9,7 @@
 #include <Eigen/Dense>
 
 #include <boost/static_assert.hpp>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -94,6 +95,42 @@ namespace scheme { namespace nest { namespace pmap {
 			return true;
 		}
 
+		///@brief params_to_value for n cells at once, valid[k] false iff params[k] is invalid
+		///@detail orientations are decoded as a batch by OriMap::params_to_values
+		///@note values[k] is unspecified where !valid[k]
+		void params_to_values(
+			Params const * params,
+			Index const * cell_index,
+			size_t n,
+			Index resl,
+			Value * values,
+			bool * valid
+		) const {
+			size_t const BATCH = 64;
+			Index const ncori = ori_map_.num_cells();
+			P3 pori[BATCH];
+			Index cori[BATCH];
+			M m[BATCH];
+			for( size_t b = 0; b < n; b += BATCH ){
+				size_t const nb = std::min( BATCH, n-b );
+				for( size_t k = 0; k < nb; ++k ){
+					pori[k] = P3( params[b+k], 0 );
+					cori[k] = cell_index[b+k] % ncori;
+				}
+				ori_map_.params_to_values( pori, cori, nb, resl, m, valid+b );
+				for( size_t k = 0; k < nb; ++k ){
+					V v;
+					valid[b+k] &= trans_map_.params_to_value( P3( params[b+k], 3 ), cell_index[b+k] / ncori, resl, v );
+					if( !valid[b+k] ) continue;
+					Value & value = values[b+k];
+					value = Value( m[k] );
+					value.translation()[0] = v[0];
+					value.translation()[1] = v[1];
+					value.translation()[2] = v[2];
+				}
+			}
+		}
+
 		///@brief sets params/cell_index from value
 		///@note necessary for value lookup and neighbor lookup
 		bool value_to_params(
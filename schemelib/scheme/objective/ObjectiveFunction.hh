@@ -15,6 +15,8 @@
 // #include <boost/mpl/copy.hpp>
 // #include <boost/mpl/copy_if.hpp>
 #include <boost/mpl/transform.hpp>
+#include <boost/mpl/count_if.hpp>
+#include <boost/mpl/remove_if.hpp>
 // #include <boost/mpl/int.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/fusion/include/vector.hpp>
@@ -177,6 +179,37 @@ namespace impl {
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(UseVisitor,false_)
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(HasPre,false_)
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(HasPost,false_)
+	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(NonNegative,false_)
+
+	///@brief helper class tests Objective scores Interaction and may contribute < 0
+	template<class Interaction>
+	struct objective_may_be_negative_on {
+		template<class Objective>
+		struct apply : m::bool_<
+			boost::is_same<Interaction,typename Objective::Interaction>::value &&
+			!get_NonNegative_false_<Objective>::type::value > {};
+	};
+
+	///@brief helper class tests all Objectives on Interaction are NonNegative, so partial sums only go up
+	template<class Objectives>
+	struct interaction_is_nonnegative {
+		template<class Interaction>
+		struct apply : m::bool_<
+			m::count_if< Objectives, objective_may_be_negative_on<Interaction> >::type::value == 0 > {};
+	};
+
+	///@brief helper functor adds weighted results of each objective to sum
+	template< class Results, class Weights >
+	struct SumWeightedResults {
+		Results const & results;
+		Weights const & weights;
+		double & sum;
+		SumWeightedResults( Results const & r, Weights const & w, double & s ) : results(r),weights(w),sum(s) {}
+		template<class Objective>
+		void operator()(Objective const &) const {
+			sum += (double)weights.template get<Objective>() * (double)results.template get<Objective>();
+		}
+	};
 
 	template<class InteractionSource, class Placeholder>
 	typename boost::disable_if<typename get_DefinesInteractionWeight_false_<InteractionSource>::type,double>::type
@@ -524,6 +557,261 @@ namespace impl {
 
 
 
+	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(UseFusedVisitor,false_)
+
+	///@brief visitor for InteractionSource::visit_fused, feeds each interaction of any of
+	///       Interactions to all objectives on that Interaction type
+	template<
+		class _Interactions,
+		class ObjectiveMap,
+		class Results,
+		class Scratches,
+		class Config
+	>
+	struct FusedObjectivesVisitor {
+
+		typedef _Interactions Interactions;
+
+		ObjectiveMap const & objective_map_;
+		Results & results_;
+		Scratches & scratches_;
+		Config const & config_;
+
+		FusedObjectivesVisitor(
+			ObjectiveMap const & f,
+			Results & r,
+			Scratches & s,
+			Config const & c
+		) : objective_map_(f), results_(r), scratches_(s), config_(c){}
+
+		template< class I >
+		void
+		operator()( I const & interaction, double weight ) {
+			f::for_each(
+				objective_map_.template get<I>(),
+				EvalObjective< I, Results , Scratches, Config >
+					         ( interaction, results_, scratches_, config_, weight )
+			);
+		}
+		template< class I >
+		typename boost::enable_if< util::meta::is_pair<I> , void >::type
+		operator()(
+			typename I::first_type const & a1,
+			typename I::second_type const & a2,
+			double weight
+		) {
+			f::for_each(
+				objective_map_.template get<I>(),
+				EvalObjectiveSplitPair< I, Results, Scratches, Config >
+					         ( a1, a2, results_, scratches_, config_, weight )
+			);
+		}
+
+	};
+
+	///@brief evaluate objectives for each of InteractionTypes, one pass over the source per type
+	template< class InteractionTypes, class InteractionSource, class ObjectiveMap, class Results, class Scratches, class Config >
+	void
+	eval_objectives(
+		InteractionSource const & source,
+		ObjectiveMap const & objective_map,
+		Results & results,
+		Scratches & scratches,
+		Config const & config,
+		m::false_
+	){
+		m::for_each< InteractionTypes, util::meta::type2type<m::_1> >(
+			EvalObjectives< InteractionSource, ObjectiveMap, Results, Scratches, Config >
+			              ( source, objective_map, results, scratches, config )
+		);
+	}
+	///@brief evaluate objectives for all of InteractionTypes in one InteractionSource::visit_fused pass
+	template< class InteractionTypes, class InteractionSource, class ObjectiveMap, class Results, class Scratches, class Config >
+	void
+	eval_objectives(
+		InteractionSource const & source,
+		ObjectiveMap const & objective_map,
+		Results & results,
+		Scratches & scratches,
+		Config const & config,
+		m::true_
+	){
+		FusedObjectivesVisitor< InteractionTypes, ObjectiveMap, Results, Scratches, Config >
+			visitor( objective_map, results, scratches, config );
+		source.visit_fused( visitor );
+	}
+
+	///@brief helper functor adds the weighted results of each objective for Interaction to sum
+	template< class ObjectiveMap, class Results, class Weights >
+	struct SumObjectivesOf {
+		ObjectiveMap const & objective_map_;
+		Results const & results_;
+		Weights const & weights_;
+		double & sum_;
+		SumObjectivesOf( ObjectiveMap const & f, Results const & r, Weights const & w, double & s )
+		 : objective_map_(f),results_(r),weights_(w),sum_(s) {}
+		template<class Interaction>
+		void operator()(util::meta::type2type<Interaction>) const {
+			f::for_each( objective_map_.template get<Interaction>(), SumWeightedResults<Results,Weights>( results_, weights_, sum_ ) );
+		}
+	};
+
+	///@brief ObjectivesVisitor that asks the InteractionSource to stop once base + the weighted
+	///       results of its objectives exceed cut. only valid for NonNegative objectives
+	template<
+		class _Interaction,
+		class Objectives,
+		class Results,
+		class Scratches,
+		class Config,
+		class Weights
+	>
+	struct CutoffObjectivesVisitor : ObjectivesVisitor<_Interaction,Objectives,Results,Scratches,Config> {
+		typedef m::true_ EarlyExit;
+		Weights const & weights_;
+		double base_, cut_;
+		CutoffObjectivesVisitor(
+			Objectives const & o,
+			Results & r,
+			Scratches & s,
+			Config const & c,
+			Weights const & w,
+			double base,
+			double cut
+		) : ObjectivesVisitor<_Interaction,Objectives,Results,Scratches,Config>(o,r,s,c), weights_(w), base_(base), cut_(cut) {}
+		bool done() const {
+			double sum = base_;
+			f::for_each( this->objectives_, SumWeightedResults<Results,Weights>( this->results_, weights_, sum ) );
+			return sum > cut_;
+		}
+	};
+
+	///@brief helper functor to call each objective for Interaction, stopping once the
+	///       weighted total is > cut. sets aborted and skips later Interactions if so
+	template<
+		class InteractionSource,
+		class ObjectiveMap,
+		class Results,
+		class Scratches,
+		class Config,
+		class Weights,
+		class Enable = void
+	>
+	struct EvalObjectivesCutoff {};
+
+	// iteration version, checks after every interaction
+	template< class InteractionSource, class ObjectiveMap, class Results, class Scratches, class Config, class Weights >
+	struct EvalObjectivesCutoff<
+		InteractionSource,
+		ObjectiveMap,
+		Results,
+		Scratches,
+		Config,
+		Weights,
+		typename boost::disable_if<typename get_UseVisitor_false_<InteractionSource>::type>::type
+	> {
+		InteractionSource const & interaction_source_;
+		ObjectiveMap const & objective_map_;
+		Results & results_;
+		Scratches & scratches_;
+		Config const & config_;
+		Weights const & weights_;
+		double & base_;
+		double cut_;
+		bool & aborted_;
+
+		EvalObjectivesCutoff(
+			InteractionSource const & p,
+			ObjectiveMap const & f,
+			Results & r,
+			Scratches & s,
+			Config const & c,
+			Weights const & w,
+			double & base,
+			double cut,
+			bool & aborted
+		) : interaction_source_(p),objective_map_(f),results_(r),scratches_(s),config_(c),weights_(w),base_(base),cut_(cut),aborted_(aborted) {}
+
+		template<class Interaction>	void
+		operator()(util::meta::type2type<Interaction>) const {
+			if( aborted_ ) return;
+			typedef typename InteractionSource::template interaction_placeholder_type<Interaction>::type Placeholder;
+			typedef typename f::result_of::value_at_key<ObjectiveMap,Interaction>::type Objectives;
+			Objectives const & objectives = objective_map_.template get<Interaction>();
+			BOOST_FOREACH(
+				Placeholder const & interaction_placeholder,
+				interaction_source_.template get_interactions<Interaction>()
+			){
+				double weight = get_interaction_weight(interaction_source_,interaction_placeholder);
+				Interaction const & interaction =
+					get_interaction_from_placeholder<
+							Interaction,
+							Placeholder,
+							InteractionSource
+						>( interaction_placeholder, interaction_source_ );
+				f::for_each(
+					objectives,
+					EvalObjective< Interaction, Results , Scratches, Config >
+					             ( interaction, results_, scratches_, config_, weight )
+				);
+				double sum = base_;
+				f::for_each( objectives, SumWeightedResults<Results,Weights>( results_, weights_, sum ) );
+				if( sum > cut_ ){
+					aborted_ = true;
+					return;
+				}
+			}
+			f::for_each( objectives, SumWeightedResults<Results,Weights>( results_, weights_, base_ ) );
+		}
+	};
+
+	// visitor version, the InteractionSource must check EarlyExit visitors
+	template< class InteractionSource, class ObjectiveMap, class Results, class Scratches, class Config, class Weights >
+	struct EvalObjectivesCutoff<
+		InteractionSource,
+		ObjectiveMap,
+		Results,
+		Scratches,
+		Config,
+		Weights,
+		typename boost::enable_if<typename get_UseVisitor_false_<InteractionSource>::type>::type
+	> {
+		InteractionSource const & interaction_source_;
+		ObjectiveMap const & objective_map_;
+		Results & results_;
+		Scratches & scratches_;
+		Config const & config_;
+		Weights const & weights_;
+		double & base_;
+		double cut_;
+		bool & aborted_;
+
+		EvalObjectivesCutoff(
+			InteractionSource const & p,
+			ObjectiveMap const & f,
+			Results & r,
+			Scratches & s,
+			Config const & c,
+			Weights const & w,
+			double & base,
+			double cut,
+			bool & aborted
+		) : interaction_source_(p),objective_map_(f),results_(r),scratches_(s),config_(c),weights_(w),base_(base),cut_(cut),aborted_(aborted) {}
+
+		template<class Interaction>	void
+		operator()(util::meta::type2type<Interaction>) const {
+			if( aborted_ ) return;
+			typedef typename f::result_of::value_at_key<ObjectiveMap,Interaction>::type Objectives;
+			Objectives const & objectives = objective_map_.template get<Interaction>();
+			CutoffObjectivesVisitor<Interaction,Objectives,Results,Scratches,Config,Weights>
+				visitor(objectives,results_,scratches_,config_,weights_,base_,cut_);
+			interaction_source_.visit(visitor);
+			if( visitor.done() ) aborted_ = true;
+			f::for_each( objectives, SumWeightedResults<Results,Weights>( results_, weights_, base_ ) );
+		}
+	};
+
+
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(InteractionTypes,void)
 	SCHEME_MEMBER_TYPE_DEFAULT_TEMPLATE(Result,double)
 
@@ -550,9 +838,13 @@ struct ObjectiveConcept {
 ///@brief a generic objective function for interacting bodies
 ///@tparam Objectives sequence of types modeling the Objective concept
 ///@tparam Config a global config object passed to each Objective
+///@tparam FUSED if the InteractionSource has UseFusedVisitor, score all interaction types in
+///        one visit_fused pass instead of one pass per type, so each body, or body pair, is
+///        touched once for all objectives
 template<
 	typename _Objectives,
-	typename _Config
+	typename _Config,
+	bool FUSED = false
 	>
 struct ObjectiveFunction {
 
@@ -623,6 +915,28 @@ struct ObjectiveFunction {
 	///@brief default c'tor, init weights_ to 1
 	ObjectiveFunction() : weights_(1.0) {}
 
+	///@brief only operate on interactions contained in source
+	template<class InteractionSource>
+	struct mutual_interaction_types {
+		typedef typename impl::get_InteractionTypes_void<InteractionSource>::type SourceInteractionTypes;
+		typedef typename m::eval_if<
+				boost::is_same<void,SourceInteractionTypes>,
+				InteractionTypes,
+				util::meta::intersect<
+					InteractionTypes,
+					SourceInteractionTypes
+				>
+			>::type
+			type;
+	};
+
+	///@brief fuse only if asked and the source can
+	template<class InteractionSource>
+	struct use_fused : m::and_<
+		m::bool_<FUSED>,
+		typename impl::get_UseFusedVisitor_false_<InteractionSource>::type
+	> {};
+
 	///@brief accessor for Objectives, may be used to configure or initialize Objective instances
 	template<class Objective>
 	Objective &
@@ -644,18 +958,9 @@ struct ObjectiveFunction {
 		Config const & config,
 		Results & results
 	) const {
-		// make sure we only operate on interactions contained in source
-		typedef typename impl::get_InteractionTypes_void<InteractionSource>::type SourceInteractionTypes;
-		typedef typename m::eval_if<
-				boost::is_same<void,SourceInteractionTypes>,
-				InteractionTypes,
-				util::meta::intersect<
-					InteractionTypes,
-					SourceInteractionTypes
-				>
-			>::type
-			MutualInteractionTypes;
+		typedef typename mutual_interaction_types<InteractionSource>::type MutualInteractionTypes;
 		BOOST_STATIC_ASSERT(( m::size<MutualInteractionTypes>::value ));
+		typedef typename use_fused<InteractionSource>::type Fused;
 
 		Scratches scratches;
 
@@ -675,15 +980,7 @@ struct ObjectiveFunction {
 		#ifdef DEBUG_IO
 			std::cout << "ObjectiveFunction operator()" << std::endl;
 		#endif
-		m::for_each< MutualInteractionTypes, util::meta::type2type<m::_1> >(
-			impl::EvalObjectives<
-				InteractionSource,
-				ObjectiveMap,
-				Results,
-				Scratches,
-				Config
-			>( source, objective_map_, results, scratches, config )
-		);
+		impl::eval_objectives<MutualInteractionTypes>( source, objective_map_, results, scratches, config, Fused() );
 
 		#ifdef DEBUG_IO
 			std::cout << "ObjectiveFunction post" << std::endl;
@@ -726,6 +1023,61 @@ struct ObjectiveFunction {
 		return this->operator()<InteractionSource>(source,default_config_);
 	}
 
+	///@brief evaluate a InteractionSource, giving up once the weighted total must be > cut
+	///@detail Interactions whose Objectives all declare NonNegative are scored last, after
+	///        everything else including post(), checking the running total after each one.
+	///        Objectives are NonNegative if no interaction, pre or post can lower their result
+	///@param results weighted, as from operator()(source,config); incomplete if stopped early
+	///@return false if stopped early, then results.sum() > cut
+	template<class InteractionSource>
+	bool
+	score_with_cutoff(
+		InteractionSource const & source,
+		Config const & config,
+		double cut,
+		Results & results
+	) const {
+		typedef typename mutual_interaction_types<InteractionSource>::type MutualInteractionTypes;
+		BOOST_STATIC_ASSERT(( m::size<MutualInteractionTypes>::value ));
+		typedef typename m::copy_if<
+				MutualInteractionTypes,
+				impl::interaction_is_nonnegative<Objectives>,
+				m::back_inserter<m::vector<> >
+			>::type MonotoneInteractionTypes;
+		typedef typename m::remove_if<
+				MutualInteractionTypes,
+				impl::interaction_is_nonnegative<Objectives>,
+				m::back_inserter<m::vector<> >
+			>::type OtherInteractionTypes;
+
+		typedef impl::EvalObjectivesPre <InteractionSource,ObjectiveMap,Results,Scratches,Config> Pre;
+		typedef impl::EvalObjectivesPost<InteractionSource,ObjectiveMap,Results,Scratches,Config> Post;
+		typedef impl::EvalObjectivesCutoff<InteractionSource,ObjectiveMap,Results,Scratches,Config,Weights> EvalCutoff;
+
+		Scratches scratches;
+		Results raw;
+		m::for_each< MutualInteractionTypes, util::meta::type2type<m::_1> >( Pre( source, objective_map_, raw, scratches, config ) );
+		impl::eval_objectives<OtherInteractionTypes>( source, objective_map_, raw, scratches, config,
+			typename use_fused<InteractionSource>::type() );
+		m::for_each< OtherInteractionTypes, util::meta::type2type<m::_1> >( Post( source, objective_map_, raw, scratches, config ) );
+
+		double base = 0;
+		bool aborted = false;
+		m::for_each< OtherInteractionTypes, util::meta::type2type<m::_1> >(
+			impl::SumObjectivesOf<ObjectiveMap,Results,Weights>( objective_map_, raw, weights_, base ) );
+		if( base > cut ){
+			aborted = true;
+		} else {
+			m::for_each< MonotoneInteractionTypes, util::meta::type2type<m::_1> >(
+				EvalCutoff( source, objective_map_, raw, scratches, config, weights_, base, cut, aborted ) );
+		}
+		if( !aborted ){
+			m::for_each< MonotoneInteractionTypes, util::meta::type2type<m::_1> >( Post( source, objective_map_, raw, scratches, config ) );
+		}
+		results = raw * weights_;
+		return !aborted;
+	}
+
 };
 
 
@@ -11,11 +11,11 @@ namespace objective {
 namespace m = boost::mpl;
 namespace f = boost::fusion;
 
-template<class O,class C> struct ObjectiveFunction;
+template<class O,class C,bool F> struct ObjectiveFunction;
 
-template<typename O,typename C>
-std::ostream & operator<<(std::ostream & out, ObjectiveFunction<O,C> const & obj){
-	typedef ObjectiveFunction<O,C> OBJ;
+template<typename O,typename C,bool F>
+std::ostream & operator<<(std::ostream & out, ObjectiveFunction<O,C,F> const & obj){
+	typedef ObjectiveFunction<O,C,F> OBJ;
 	out << "ObjectiveFunction" << std::endl;
 	out << "    Interactions:" << std::endl;
 		m::for_each<typename OBJ::InteractionTypes>(util::meta::PrintType(out,"        "));
@@ -7,6 +7,9 @@
 #include <Eigen/Geometry>
 #include <random>
 #include <sparsehash/dense_hash_set>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 
 namespace scheme { namespace objective { namespace hash { namespace xhnbtest {
 
@@ -509,14 +512,17 @@ TEST( XformHashNeighbors, Quat_BCC7_Zorder_check_general_neighbors ){
 
 		}
 
-		std::ofstream out( "test.sxhn", std::ios::binary );
+		char const * tmpdir = std::getenv( "TMPDIR" );
+		std::string const fname = std::string( tmpdir ? tmpdir : "/tmp" ) + "/test.sxhn";
+		std::ofstream out( fname.c_str(), std::ios::binary );
 		nb.save( out );
 		out.close();
 
 		XNB nb2( cart_bound, ang_bound, xh, NSAMP*50.0 );
-		std::ifstream in( "test.sxhn", std::ios::binary );
+		std::ifstream in( fname.c_str(), std::ios::binary );
 		ASSERT_TRUE( nb2.load( in ) );
 		in.close();
+		std::remove( fname.c_str() );
 
 		// XformHash const hasher_;
 		// std::map< Key, std::vector<Key> > ori_cache_;
@@ -9,6 +9,8 @@
 #include <random>
 #include "scheme/util/Timer.hh"
 
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 
 namespace scheme { namespace objective { namespace hash { namespace xmtest {
@@ -56,14 +58,17 @@ TEST( XformMap, stores_correctly ){
 	// 	ASSERT_FALSE( xmap.save( out, "foo" ) );
 	// 	out.close();
 	// }
-	std::ofstream out("test.sxm" , std::ios::binary );
+	char const * tmpdir = std::getenv( "TMPDIR" );
+	std::string const fname = std::string( tmpdir ? tmpdir : "/tmp" ) + "/test.sxm";
+	std::ofstream out( fname.c_str(), std::ios::binary );
 	ASSERT_TRUE( xmap.save( out, "foo" ) );
 	out.close();
 
 	XformMap< Xform, double > xmap_loaded;
-	std::ifstream in( "test.sxm"  , std::ios::binary );
+	std::ifstream in( fname.c_str(), std::ios::binary );
 	ASSERT_TRUE( xmap_loaded.load( in ) );
 	in.close();
+	std::remove( fname.c_str() );
 
 	ASSERT_EQ( xmap.cart_resl_, xmap_loaded.cart_resl_ );
 	ASSERT_EQ( xmap.ang_resl_, xmap_loaded.ang_resl_ );	
@@ -2,6 +2,10 @@
 
 #include "scheme/objective/storage/TwoBodyTable.hh"
 
+#include <random>
+#include <sstream>
+#include <thread>
+
 namespace scheme { namespace objective { namespace storage { namespace ritest {
 
 using std::cout;
@@ -45,4 +49,167 @@ TEST( TwoBodyTable, test ){
 
 
 
+// random onebody energies, filtered at 0, and random twobody blocks on every other edge
+void
+fill_random( TwoBodyTable<float> & twob, std::mt19937 & rng ){
+	std::uniform_real_distribution<float> runif(-2,1);
+	int const nres = twob.onebody_.shape()[0], nrot = twob.onebody_.shape()[1];
+	for( int ires = 0; ires < nres; ++ires )
+		for( int irot = 0; irot < nrot; ++irot )
+			twob.set_onebody( ires, irot, runif(rng) );
+	twob.init_onebody_filter( 0.0 );
+	for( int ir = 0; ir < nres; ++ir ){
+	for( int jr = 0; jr < ir; ++jr ){
+		if( (ir+jr)%2 ) continue;
+		twob.init_twobody( ir, jr );
+		for( int k = 0; k < twob.twobody_[ir][jr].num_elements(); ++k ){
+			twob.twobody_[ir][jr].data()[k] = runif(rng);
+		}
+	}}
+}
+
+TEST( TwoBodyTable, compact ){
+
+	std::mt19937 rng(0);
+	int const nres = 6, nrot = 7;
+
+	TwoBodyTable<float> twob( nres, nrot );
+	fill_random( twob, rng );
+
+	shared_ptr< TwoBodyTable<float> > flat = twob.clone(), flat16 = twob.clone();
+	flat->compact();
+	flat16->compact( true );
+	EXPECT_TRUE( flat->check_equal( twob ) );
+	EXPECT_TRUE( twob.check_equal( *flat ) );
+	EXPECT_TRUE( flat->check_equal( *flat->clone() ) );
+	EXPECT_TRUE( flat16->check_equal( *flat16->clone() ) );
+
+	for( int ir = 0; ir < nres; ++ir ){
+	for( int jr = 0; jr < nres; ++jr ){
+		EXPECT_EQ( twob.has_twobody(ir,jr), flat->has_twobody(ir,jr) );
+		for( int irot = 0; irot < nrot; ++irot ){
+		for( int jrot = 0; jrot < nrot; ++jrot ){
+			if( ir == jr ) continue;
+			EXPECT_EQ( twob.twobody( ir, jr, irot, jrot ), flat->twobody( ir, jr, irot, jrot ) );
+			if( twob.all2sel_[ir][irot] >= 0 && twob.all2sel_[jr][jrot] >= 0 ){
+				EXPECT_NEAR( twob.twobody( ir, jr, irot, jrot ), flat16->twobody( ir, jr, irot, jrot ), 1.0/64.0 );
+			}
+		}}
+	}}
+
+	flat->upweight_edge( 2, 0, twob.sel2all_[2][0], twob.sel2all_[0][0], 1.0 );
+	flat16->upweight_edge( 2, 0, twob.sel2all_[2][0], twob.sel2all_[0][0], 1.0 );
+	if( twob.has_twobody(2,0) ) EXPECT_FALSE( flat->check_equal( twob ) );
+	flat->restore_edge( 2, 0, twob.sel2all_[2][0], twob.sel2all_[0][0], twob.clone() );
+	EXPECT_TRUE( flat->check_equal( twob ) );
+
+	std::ostringstream out;
+	flat->save( out, "test" );
+	std::istringstream in( out.str() );
+	TwoBodyTable<float> loaded;
+	std::string description;
+	loaded.load( in, description );
+	EXPECT_EQ( description, "test" );
+	EXPECT_TRUE( loaded.check_equal( twob ) );
+
+}
+
+TEST( TwoBodyTable, lazy ){
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(-2,1);
+	int const nres = 7, nrot = 6;
+
+	TwoBodyTable<float> twob( nres, nrot );
+	shared_ptr< TwoBodyTable<float> > lazy_p = make_shared< TwoBodyTable<float> >( nres, nrot );
+	TwoBodyTable<float> & lazy = *lazy_p;
+	for( int ires = 0; ires < nres; ++ires )
+		for( int irot = 0; irot < nrot; ++irot )
+			twob.set_onebody( ires, irot, runif(rng) );
+	lazy.onebody_ = twob.onebody_;
+	twob.init_onebody_filter( 0.0 );
+	lazy.init_onebody_filter( 0.0 );
+	auto fill = []( TwoBodyTable<float> & t, int ir, int jr ){
+		if( (ir+jr)%3 == 0 ) return;
+		t.init_twobody( ir, jr );
+		for( int k = 0; k < t.twobody_[ir][jr].num_elements(); ++k ){
+			t.twobody_[ir][jr].data()[k] = std::sin( ir*100 + jr*10 + k );
+		}
+	};
+	for( int ir = 0; ir < nres; ++ir ) for( int jr = 0; jr < ir; ++jr ) fill( twob, ir, jr );
+
+	std::atomic<int> nfill(0);
+	lazy.make_lazy( [&nfill,fill]( TwoBodyTable<float> & t, int ir, int jr ){ ++nfill; fill( t, ir, jr ); } );
+	EXPECT_EQ( 0, lazy.twobody_mem_use() );
+	EXPECT_EQ( twob.twobody( 3, 1, twob.sel2all_[3][0], twob.sel2all_[1][0] ),
+	           lazy.twobody( 1, 3, twob.sel2all_[3][0], twob.sel2all_[1][0] ) );
+	EXPECT_EQ( 1, nfill );
+
+	// many threads touching all edges, each block is still filled in exactly once
+	std::vector< std::thread > threads;
+	for( int ithread = 0; ithread < 8; ++ithread ){
+		threads.push_back( std::thread( [&lazy,nres](){
+			for( int ir = 0; ir < nres; ++ir )
+				for( int jr = 0; jr < nres; ++jr )
+					lazy.twobody_rotlocalnumbering( ir, jr, 0, 0 );
+		}));
+	}
+	for( auto & t : threads ) t.join();
+	EXPECT_EQ( nres*(nres-1)/2, nfill );
+	EXPECT_TRUE( lazy.check_equal( twob ) );
+
+	// lazy subtables and clones pull from their parent
+	std::vector<bool> sel( nres, true );
+	sel[2] = false;
+	std::vector<std::vector<float> > new1b( nres, std::vector<float>( nrot ) );
+	for( int ires = 0; ires < nres; ++ires )
+		for( int irot = 0; irot < nrot; ++irot )
+			new1b[ires][irot] = twob.onebody_[ires][irot];
+	auto sub = twob.create_subtable( sel, new1b, -0.5 );
+	auto lazysub = lazy.create_subtable( sel, new1b, -0.5, true );
+	auto lazyclone = lazysub->clone();
+	EXPECT_EQ( 0, lazyclone->twobody_mem_use() );
+	EXPECT_TRUE( lazyclone->check_equal( *sub ) );
+	EXPECT_TRUE( lazysub->check_equal( *sub ) );
+	lazyclone->compact();
+	EXPECT_TRUE( lazyclone->check_equal( *sub ) );
+
+	// an untouched lazy clone still works after everything it came from is gone
+	auto orphan = lazy.create_subtable( sel, new1b, -0.5, true )->clone();
+	lazysub.reset();
+	lazy_p.reset();
+	EXPECT_EQ( 0, orphan->twobody_mem_use() );
+	EXPECT_TRUE( orphan->check_equal( *sub ) );
+
+}
+
+TEST( TwoBodyTable, flat_io ){
+
+	std::mt19937 rng(0);
+	int const nres = 5, nrot = 9;
+
+	TwoBodyTable<float> twob( nres, nrot );
+	fill_random( twob, rng );
+
+	std::ostringstream out;
+	twob.save_flat( out, 1234 );
+	std::string const buf = out.str();
+
+	TwoBodyTable<float> loaded;
+	EXPECT_FALSE( loaded.load_flat( buf.data(), buf.size(), 4321 ) );
+	EXPECT_FALSE( loaded.load_flat( buf.data(), buf.size()-4, 1234 ) );
+	ASSERT_TRUE( loaded.load_flat( buf.data(), buf.size(), 1234 ) );
+	EXPECT_TRUE( loaded.compact_ );
+	EXPECT_TRUE( loaded.check_equal( twob ) );
+	EXPECT_TRUE( twob.check_equal( loaded ) );
+
+	// compact tables write the same thing
+	auto flat = twob.clone();
+	flat->compact();
+	std::ostringstream out2;
+	flat->save_flat( out2, 1234 );
+	EXPECT_EQ( buf, out2.str() );
+
+}
+
 }}}}
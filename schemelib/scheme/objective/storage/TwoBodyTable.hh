@@ -3,10 +3,16 @@
 
 #include "scheme/util/SimpleArray.hh"
 #include "scheme/util/assert.hh"
+#include "scheme/numeric/FixedPoint.hh"
 
 #include <boost/multi_array.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <set>
 
 namespace scheme { namespace objective { namespace storage {
@@ -16,20 +22,43 @@ namespace scheme { namespace objective { namespace storage {
 // fill in onebody
 // call init_onebody_filter
 // fill in twobody
+// optionally call compact() when done filling in twobody
+// OR call make_lazy() instead of filling in twobody, blocks are then filled on first access
 // NOTE: global/local rotamer number mapping is done here
 // global/local residue numbering MUST be handled in the client code
+// NOTE: lazy subtables and lazy clones keep their source alive, so a table they are made
+// from must be owned by a shared_ptr
 template< class _Data = float >
-struct TwoBodyTable {
+struct TwoBodyTable : public std::enable_shared_from_this< TwoBodyTable<_Data> > {
 	typedef _Data Data;
 	typedef TwoBodyTable<Data> This;
 	typedef boost::multi_array< Data, 2 > Array2D;
 	typedef boost::multi_array< Array2D, 2 > TwoBody;
+	typedef ::scheme::numeric::FixedPoint< 64, int16_t > Fixed16; // 1/64 resl, saturates at +-512
 
 	size_t nres_, nrot_;
 	Array2D onebody_;
 	boost::multi_array< int, 2 > all2sel_, sel2all_;
 	std::vector<int> nsel_;
-	TwoBody twobody_;
+	TwoBody twobody_; // per-pair blocks, used while filling in, empty once compact
+
+	// compact storage: all nsel x nsel blocks contiguous in one arena
+	bool compact_ = false, compact_int16_ = false;
+	std::vector< std::pair<int32_t,int32_t> > edges_; // ir,jr pairs with a block, row-major order
+	std::vector< int64_t > block_offset_; // nres x nres, offset of block in arena, -1 if none
+	std::vector< Data > arena_;
+	std::vector< Fixed16 > arena16_;
+
+	// lazy mode: fill( *this, ir, jr ) is called once, on first access, for each ir > jr
+	// and should init_twobody( ir, jr ) and fill the block in, or leave it empty
+	typedef std::function< void( This &, int, int ) > LazyFill;
+	struct Lazy {
+		LazyFill fill;
+		std::vector< std::once_flag > once;
+		std::vector< std::atomic<bool> > done;
+		Lazy( LazyFill f, size_t n ) : fill(f), once(n), done(n) {}
+	};
+	shared_ptr< Lazy > lazy_;
 
 	TwoBodyTable() {} // for use with load() and clone()
 
@@ -49,6 +78,24 @@ struct TwoBodyTable {
 	shared_ptr<This>
 	clone() {
 		shared_ptr<This> tbt = make_shared<This>();
+		if( compact_ ){
+			tbt->nres_ = nres_;
+			tbt->nrot_ = nrot_;
+			tbt->onebody_.resize( boost::extents[nres_][nrot_] );
+			tbt->all2sel_.resize( boost::extents[nres_][nrot_] );
+			tbt->sel2all_.resize( boost::extents[nres_][nrot_] );
+			tbt->onebody_ = onebody_;
+			tbt->all2sel_ = all2sel_;
+			tbt->sel2all_ = sel2all_;
+			tbt->nsel_ = nsel_;
+			tbt->compact_ = compact_;
+			tbt->compact_int16_ = compact_int16_;
+			tbt->edges_ = edges_;
+			tbt->block_offset_ = block_offset_;
+			tbt->arena_ = arena_;
+			tbt->arena16_ = arena16_;
+			return tbt;
+		}
 		tbt->nres_ = nres_;
 		tbt->nrot_ = nrot_;
 		tbt->init( nres_, nrot_ );
@@ -56,6 +103,16 @@ struct TwoBodyTable {
 		tbt->all2sel_ = all2sel_;
 		tbt->sel2all_ = sel2all_;
 		tbt->nsel_ = nsel_;
+		if( lazy_ ){
+			// clone copies blocks from this table as needed, and holds on to it
+			shared_ptr<This const> master = this->shared_from_this();
+			tbt->make_lazy( [master]( This & t, int ir, int jr ){
+				if( !master->has_twobody( ir, jr ) ) return;
+				t.init_twobody( ir, jr );
+				t.twobody_[ir][jr] = master->twobody_[ir][jr];
+			});
+			return tbt;
+		}
 
 
   		for( int ir = 0; ir < nres_; ++ir ){
@@ -65,7 +122,7 @@ struct TwoBodyTable {
   			tbt->twobody_[ir][jr] = twobody_[ir][jr];
   		}
 		}
-		runtime_assert( check_equal(*tbt));
+		ALWAYS_ASSERT( check_equal(*tbt) );
 		return tbt;
 	}
 
@@ -90,10 +147,55 @@ struct TwoBodyTable {
 		onebody_[ires][irot] = val;
 	}
 
+	void make_lazy( LazyFill fill ){
+		ALWAYS_ASSERT_MSG( !compact_, "can't make_lazy a compact TwoBodyTable" );
+		twobody_.resize( boost::extents[0][0] );
+		twobody_.resize( boost::extents[nres_][nres_] );
+		lazy_ = make_shared<Lazy>( fill, nres_*nres_ );
+	}
+	// fill in block ir,jr if lazy and not done yet, safe to call from multiple threads
+	void ensure_twobody( int ir, int jr ) const {
+		if( !lazy_ || ir <= jr ) return;
+		size_t const i = ir*nres_ + jr;
+		if( lazy_->done[i].load( std::memory_order_acquire ) ) return;
+		This * self = const_cast<This*>( this ); // blocks are logically part of the const table
+		std::call_once( lazy_->once[i], [self,ir,jr,i](){
+			self->lazy_->fill( *self, ir, jr );
+			self->lazy_->done[i].store( true, std::memory_order_release );
+		});
+	}
+
+	bool has_twobody( int ir, int jr ) const {
+		if( compact_ ) return block_offset_[ ir*nres_ + jr ] >= 0;
+		ensure_twobody( ir, jr );
+		return twobody_[ir][jr].num_elements() > 0;
+	}
+
+	// ir/jr and irl/jrl must already be ordered as stored, block must exist
+	Data twobody_block_value( int ir, int jr, int irl, int jrl ) const {
+		if( compact_ ){
+			int64_t const i = block_offset_[ ir*nres_ + jr ] + irl*nsel_[jr] + jrl;
+			return compact_int16_ ? Data( (float)arena16_[i] ) : arena_[i];
+		}
+		return twobody_[ ir ][ jr ][ irl ][ jrl ];
+	}
+	void set_twobody_block_value( int ir, int jr, int irl, int jrl, Data const & val ){
+		if( compact_ ){
+			int64_t const i = block_offset_[ ir*nres_ + jr ] + irl*nsel_[jr] + jrl;
+			if( compact_int16_ ) arena16_[i] = to_fixed16( val );
+			else                 arena_[i] = val;
+			return;
+		}
+		twobody_[ ir ][ jr ][ irl ][ jrl ] = val;
+	}
+	static Fixed16 to_fixed16( Data const & val ){
+		return Fixed16( std::max( -511.0f, std::min( 511.0f, (float)val ) ) );
+	}
+
 	Data twobody( int ires, int jres, int irot, int jrot ) const {
 		int const ir = ires > jres ? ires : jres;
 		int const jr = ires > jres ? jres : ires;
-		if( twobody_[ir][jr].num_elements() > 0 ){
+		if( has_twobody( ir, jr ) ){
 			int const irotlocal = all2sel_[ires][irot];
 			int const jrotlocal = all2sel_[jres][jrot];
 			if( irotlocal < 0 || jrotlocal < 0 ){
@@ -102,7 +204,7 @@ struct TwoBodyTable {
 			// swap if jres > ires
 			int const irl = ires > jres ? irotlocal : jrotlocal;
 			int const jrl = ires > jres ? jrotlocal : irotlocal;
-			return twobody_[ ir ][ jr ][ irl ][ jrl ];
+			return twobody_block_value( ir, jr, irl, jrl );
 		} else {
 			return Data(0.0);
 		}
@@ -113,6 +215,13 @@ struct TwoBodyTable {
 		int const jr  = ires > jres ? jres : ires;
 		int const irl = ires > jres ? irotlocal : jrotlocal;
 		int const jrl = ires > jres ? jrotlocal : irotlocal;
+		if( compact_ ){
+			int64_t const offset = block_offset_[ ir*nres_ + jr ];
+			if( offset < 0 ) return Data(0.0);
+			int64_t const i = offset + irl*nsel_[jr] + jrl;
+			return compact_int16_ ? Data( (float)arena16_[i] ) : arena_[i];
+		}
+		ensure_twobody( ir, jr );
 		if( twobody_[ir][jr].num_elements() > 0 ){
 			return twobody_[ ir ][ jr ][ irl ][ jrl ];
 		} else {
@@ -124,7 +233,7 @@ struct TwoBodyTable {
 	upweight_edge( int ires, int jres, int irot, int jrot, Data upweight ) {
 		int const ir = ires > jres ? ires : jres;
 		int const jr = ires > jres ? jres : ires;
-		if( twobody_[ir][jr].num_elements() > 0 ){
+		if( has_twobody( ir, jr ) ){
 			int const irotlocal = all2sel_[ires][irot];
 			int const jrotlocal = all2sel_[jres][jrot];
 			if( irotlocal < 0 || jrotlocal < 0 ){
@@ -133,7 +242,7 @@ struct TwoBodyTable {
 			// swap if jres > ires
 			int const irl = ires > jres ? irotlocal : jrotlocal;
 			int const jrl = ires > jres ? jrotlocal : irotlocal;
-			twobody_[ ir ][ jr ][ irl ][ jrl ] += upweight;
+			set_twobody_block_value( ir, jr, irl, jrl, twobody_block_value( ir, jr, irl, jrl ) + upweight );
 		} 
 	}
 	void
@@ -141,7 +250,7 @@ struct TwoBodyTable {
 	{
 		int const ir = ires > jres ? ires : jres;
 		int const jr = ires > jres ? jres : ires;
-		if( twobody_[ir][jr].num_elements() > 0 ){
+		if( has_twobody( ir, jr ) ){
 			int const irotlocal = all2sel_[ires][irot];
 			int const jrotlocal = all2sel_[jres][jrot];
 			if( irotlocal < 0 || jrotlocal < 0 ){
@@ -150,10 +259,48 @@ struct TwoBodyTable {
 			// swap if jres > ires
 			int const irl = ires > jres ? irotlocal : jrotlocal;
 			int const jrl = ires > jres ? jrotlocal : irotlocal;
-			twobody_[ ir ][ jr ][ irl ][ jrl ] = twob->twobody_[ ir ][ jr ][ irl ][ jrl ];
+			set_twobody_block_value( ir, jr, irl, jrl, twob->twobody_block_value( ir, jr, irl, jrl ) );
 		} 
 	}
 
+	// move all twobody blocks into one contiguous arena, optionally as int16 fixed point
+	// the table can't be filled in via twobody_ / init_twobody after this
+	// a lazy table is filled in completely first
+	void compact( bool use_int16 = false ){
+		if( compact_ ) return;
+		edges_.clear();
+		block_offset_.assign( nres_*nres_, -1 );
+		int64_t size = 0;
+		for( int ir = 0; ir < nres_; ++ir ){
+		for( int jr = 0; jr < nres_; ++jr ){
+			ensure_twobody( ir, jr );
+			size_t const N = twobody_[ir][jr].num_elements();
+			if( N == 0 ) continue;
+			ALWAYS_ASSERT( N == nsel_[ir]*nsel_[jr] );
+			edges_.push_back( std::make_pair( ir, jr ) );
+			block_offset_[ ir*nres_ + jr ] = size;
+			size += N;
+		}}
+		arena_.clear();
+		arena16_.clear();
+		if( use_int16 ) arena16_.resize( size );
+		else            arena_  .resize( size );
+		for( int iedge = 0; iedge < edges_.size(); ++iedge ){
+			int const ir = edges_[iedge].first, jr = edges_[iedge].second;
+			Data const * block = twobody_[ir][jr].data();
+			int64_t const offset = block_offset_[ ir*nres_ + jr ];
+			size_t const N = twobody_[ir][jr].num_elements();
+			if( use_int16 ){
+				for( int k = 0; k < N; ++k ) arena16_[offset+k] = to_fixed16( block[k] );
+			} else {
+				std::copy( block, block+N, arena_.begin()+offset );
+			}
+		}
+		twobody_.resize( boost::extents[0][0] );
+		lazy_.reset();
+		compact_ = true;
+		compact_int16_ = use_int16;
+	}
 
 	// assumes onebody energies have been filled in at this point!
 	void init_onebody_filter( float thresh ){
@@ -185,6 +332,9 @@ struct TwoBodyTable {
 	}
 	int twobody_mem_use() const {
 		int memuse = 0;
+		if( compact_ ){
+			return arena_.size()*sizeof(_Data) + arena16_.size()*sizeof(Fixed16) + block_offset_.size()*sizeof(int64_t);
+		}
 		for(int i = 0; i < nres_; ++i){
 		for(int j = 0; j < nres_; ++j){
 			memuse += twobody_[i][j].num_elements()*sizeof(_Data);
@@ -215,11 +365,13 @@ struct TwoBodyTable {
   		for( int ir = 0; ir < nres_; ++ir ){
   		for( int jr = 0; jr < nres_; ++jr ){
 
-  			iseq &= twobody_[ir][jr].num_elements() == other.twobody_[ir][jr].num_elements();
+  			iseq &= has_twobody( ir, jr ) == other.has_twobody( ir, jr );
 	  		if( !iseq ) return false;
-	  		for( int k = 0; k < twobody_[ir][jr].num_elements(); ++k ){
-		  		iseq &= twobody_[ir][jr].data()[k] == other.twobody_[ir][jr].data()[k];
-	  		}
+	  		if( !has_twobody( ir, jr ) ) continue;
+	  		for( int irl = 0; irl < nsel_[ir]; ++irl ){
+	  		for( int jrl = 0; jrl < nsel_[jr]; ++jrl ){
+		  		iseq &= twobody_block_value( ir, jr, irl, jrl ) == other.twobody_block_value( ir, jr, irl, jrl );
+	  		}}
 
 
   		}}
@@ -246,17 +398,106 @@ struct TwoBodyTable {
   		}
   		for( int ir = 0; ir < nres_; ++ir ){
   		for( int jr = 0; jr < nres_; ++jr ){
+  			if( compact_ ){
+  				// same format as uncompacted
+	  			size_t const N = has_twobody( ir, jr ) ? nsel_[ir]*nsel_[jr] : 0;
+		  		out.write( (char*)&N, sizeof(size_t) );
+		  		if( N == 0 ) continue;
+		  		int64_t const offset = block_offset_[ ir*nres_ + jr ];
+		  		if( compact_int16_ ){
+		  			for( int k = 0; k < N; ++k ){
+		  				Data const val = (float)arena16_[offset+k];
+		  				out.write( (char*)&val, sizeof(Data) );
+		  			}
+		  		} else {
+		  			out.write( (char*)&arena_[offset], N*sizeof(Data) );
+		  		}
+		  		continue;
+  			}
+  			ensure_twobody( ir, jr );
   			size_t const N = twobody_[ir][jr].num_elements();
   			if( N != 0 && N != nsel_[ir]*nsel_[jr] ){
   				std::cout << "bad N: " << N << " should be 0 or " << nsel_[ir]*nsel_[jr] << std::endl;
   				ALWAYS_ASSERT( N == 0 || N == nsel_[ir]*nsel_[jr] );
   			}
 	  		out.write( (char*)&N, sizeof(size_t) );
-	  		for( int k = 0; k < N; ++k ){
-		  		out.write( (char*)&( twobody_[ir][jr].data()[k] ), sizeof(Data) );
-	  		}
+	  		out.write( (char*)twobody_[ir][jr].data(), N*sizeof(Data) );
   		}}
 	}
+	// flat format: fixed header then 8-byte aligned raw arrays in the compact layout, so a
+	// memory mapped file is read with one copy per array. key identifies the table contents
+	static char const * flat_magic(){ return "2BFLAT01"; }
+	static size_t flat_pad( size_t n ){ return (n+7)/8*8; }
+	void save_flat( std::ostream & out, uint64_t key ) const {
+		std::vector< int64_t > offsets( nres_*nres_, -1 );
+		uint64_t size = 0;
+		for( int ir = 0; ir < nres_; ++ir ){
+		for( int jr = 0; jr < nres_; ++jr ){
+			if( !has_twobody( ir, jr ) ) continue;
+			offsets[ ir*nres_ + jr ] = size;
+			size += nsel_[ir]*nsel_[jr];
+		}}
+		uint64_t const header[5] = { key, nres_, nrot_, size, sizeof(Data) };
+		char const zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		out.write( flat_magic(), 8 );
+		out.write( (char const*)header, sizeof(header) );
+		out.write( (char const*)onebody_.data(), nres_*nrot_*sizeof(Data) );
+		out.write( zeros, flat_pad( nres_*nrot_*sizeof(Data) ) - nres_*nrot_*sizeof(Data) );
+		std::vector< int32_t > tmp( all2sel_.data(), all2sel_.data()+nres_*nrot_ );
+		out.write( (char const*)tmp.data(), nres_*nrot_*sizeof(int32_t) );
+		tmp.assign( sel2all_.data(), sel2all_.data()+nres_*nrot_ );
+		out.write( (char const*)tmp.data(), nres_*nrot_*sizeof(int32_t) );
+		tmp.assign( nsel_.begin(), nsel_.end() );
+		out.write( (char const*)tmp.data(), nres_*sizeof(int32_t) );
+		size_t const nint = 2*nres_*nrot_ + nres_;
+		out.write( zeros, flat_pad( nint*sizeof(int32_t) ) - nint*sizeof(int32_t) );
+		out.write( (char const*)offsets.data(), offsets.size()*sizeof(int64_t) );
+		for( int ir = 0; ir < nres_; ++ir ){
+		for( int jr = 0; jr < nres_; ++jr ){
+			if( offsets[ ir*nres_ + jr ] < 0 ) continue;
+			for( int irl = 0; irl < nsel_[ir]; ++irl ){
+			for( int jrl = 0; jrl < nsel_[jr]; ++jrl ){
+				Data const val = twobody_block_value( ir, jr, irl, jrl );
+				out.write( (char const*)&val, sizeof(Data) );
+			}}
+		}}
+	}
+	// loads a compact table, returns false if buf isn't a flat table with this key
+	bool load_flat( char const * buf, size_t nbytes, uint64_t key ){
+		uint64_t header[5];
+		if( nbytes < 8 + sizeof(header) || std::memcmp( buf, flat_magic(), 8 ) ) return false;
+		std::memcpy( header, buf+8, sizeof(header) );
+		if( header[0] != key || header[4] != sizeof(Data) ) return false;
+		size_t const nres = header[1], nrot = header[2], size = header[3];
+		size_t const nint = 2*nres*nrot + nres;
+		size_t const n1b = flat_pad( nres*nrot*sizeof(Data) ), nints = flat_pad( nint*sizeof(int32_t) );
+		if( nbytes != 8 + sizeof(header) + n1b + nints + nres*nres*sizeof(int64_t) + size*sizeof(Data) ) return false;
+		init( nres, nrot );
+		char const * p = buf + 8 + sizeof(header);
+		std::memcpy( onebody_.data(), p, nres*nrot*sizeof(Data) );
+		p += n1b;
+		int32_t const * ints = (int32_t const *)p;
+		std::copy( ints, ints + nres*nrot, all2sel_.data() );
+		std::copy( ints + nres*nrot, ints + 2*nres*nrot, sel2all_.data() );
+		nsel_.assign( ints + 2*nres*nrot, ints + nint );
+		p += nints;
+		block_offset_.resize( nres*nres );
+		std::memcpy( block_offset_.data(), p, nres*nres*sizeof(int64_t) );
+		p += nres*nres*sizeof(int64_t);
+		arena_.resize( size );
+		std::memcpy( arena_.data(), p, size*sizeof(Data) );
+		arena16_.clear();
+		edges_.clear();
+		for( int ir = 0; ir < nres_; ++ir ){
+		for( int jr = 0; jr < nres_; ++jr ){
+			if( block_offset_[ ir*nres_ + jr ] >= 0 ) edges_.push_back( std::make_pair( ir, jr ) );
+		}}
+		twobody_.resize( boost::extents[0][0] );
+		lazy_.reset();
+		compact_ = true;
+		compact_int16_ = false;
+		return true;
+	}
 	void load( std::istream & in, std::string & description ) {
 // std::cout << __FILE__ << ":" << __LINE__ << " " << __FUNCTION__ << " " << "" << std::endl;
 		size_t dsrcrize;
@@ -269,6 +510,12 @@ struct TwoBodyTable {
   		delete buf;
   		in.read( (char*)&nres_, sizeof(size_t) );
   		in.read( (char*)&nrot_, sizeof(size_t) );
+  		compact_ = compact_int16_ = false;
+  		lazy_.reset();
+  		edges_.clear();
+  		block_offset_.clear();
+  		arena_.clear();
+  		arena16_.clear();
   		onebody_.resize( boost::extents[nres_][nrot_] );
   		all2sel_.resize( boost::extents[nres_][nrot_] );
   		sel2all_.resize( boost::extents[nres_][nrot_] );
@@ -303,11 +550,41 @@ struct TwoBodyTable {
   		}}
 	}
 
+	void fill_subtable_block( This & newt, int ilocal, int jlocal, int iglobal, int jglobal ) const {
+		newt.init_twobody( ilocal, jlocal );
+		Data minscore = 9e9, maxscore = -9e9;
+		if( !has_twobody( iglobal, jglobal ) ){
+			// no table in old table, subtable will also have nothing
+			newt.clear_twobody( ilocal, jlocal );
+		} else {
+			for( int ilocalrot = 0; ilocalrot < newt.nsel_[ilocal]; ++ilocalrot ){
+				int iglobalrot = newt.sel2all_[ ilocal ][ ilocalrot ];
+				int ioldrot = all2sel_[ iglobal ][ iglobalrot ];
+			for( int jlocalrot = 0; jlocalrot < newt.nsel_[jlocal]; ++jlocalrot ){
+				int jglobalrot = newt.sel2all_[ jlocal ][ jlocalrot ];
+				int joldrot = all2sel_[ jglobal ][ jglobalrot ];
+				Data score = 9e9;
+				if( ioldrot >= 0 && joldrot >= 0 ){
+					score = this->twobody_block_value( iglobal, jglobal, ioldrot, joldrot );
+				}
+				newt.twobody_[ilocal][jlocal][ilocalrot][jlocalrot] = score;
+				minscore = std::min( minscore, score );
+				maxscore = std::max( maxscore, score );
+			}}
+			if( minscore > -0.01 && maxscore < 0.01 ){
+				ALWAYS_ASSERT( 0 <= ilocal && ilocal < newt.nres_ );
+				ALWAYS_ASSERT( 0 <= jlocal && jlocal < newt.nres_ );
+				newt.clear_twobody( ilocal, jlocal );
+			}
+		}
+	}
+
 	shared_ptr< TwoBodyTable<Data> >
 	create_subtable(
 		std::vector<bool> const & res_selection,
 		std::vector<std::vector<float> > const & new1b, // always in global numbering
-		float filter1bthresh
+		float filter1bthresh,
+		bool lazy = false // fill in subtable blocks from this table on first access
 	) const {
 		shared_ptr< TwoBodyTable<Data> > newt_p = make_shared<TwoBodyTable<Data> >();
 		TwoBodyTable & newt( *newt_p );
@@ -340,37 +617,18 @@ struct TwoBodyTable {
 		}
 		// std::cout << "create_subtable: new nres: " << newt.nres_ << std::endl;
 		newt.init_onebody_filter( filter1bthresh ); // inits & fills all2sel_, sel2all_, and nsel_
+		if( lazy ){
+			// the subtable holds on to this
+			shared_ptr<This const> parent = this->shared_from_this();
+			newt.make_lazy( [parent,res_l2g]( This & t, int ilocal, int jlocal ){
+				parent->fill_subtable_block( t, ilocal, jlocal, res_l2g[ilocal], res_l2g[jlocal] );
+			});
+			return newt_p;
+		}
 		newt.twobody_.resize( boost::extents[newt.nres_][newt.nres_] );
 		for( int ilocal = 0; ilocal < newt.nres_; ++ilocal ){
 		for( int jlocal = 0; jlocal < newt.nres_; ++jlocal ){
-			int iglobal = res_l2g[ilocal];
-			int jglobal = res_l2g[jlocal];
-			newt.init_twobody( ilocal, jlocal );
-			Data minscore = 9e9, maxscore = -9e9;
-			if( twobody_[iglobal][jglobal].num_elements() == 0 ){
-				// no table in old table, subtable will also have nothing
-				newt.clear_twobody( ilocal, jlocal );
-			} else {
-				for( int ilocalrot = 0; ilocalrot < newt.nsel_[ilocal]; ++ilocalrot ){
-					int iglobalrot = newt.sel2all_[ ilocal ][ ilocalrot ];
-					int ioldrot = all2sel_[ iglobal ][ iglobalrot ];
-				for( int jlocalrot = 0; jlocalrot < newt.nsel_[jlocal]; ++jlocalrot ){
-					int jglobalrot = newt.sel2all_[ jlocal ][ jlocalrot ];
-					int joldrot = all2sel_[ jglobal ][ jglobalrot ];
-					Data score = 9e9;
-					if( ioldrot >= 0 && joldrot >= 0 ){
-						score = this->twobody_[iglobal][jglobal][ioldrot][joldrot];
-					}
-					newt.twobody_[ilocal][jlocal][ilocalrot][jlocalrot] = score;
-					minscore = std::min( minscore, score );
-					maxscore = std::max( maxscore, score );
-				}}
-				if( minscore > -0.01 && maxscore < 0.01 ){
-					ALWAYS_ASSERT( 0 <= ilocal && ilocal < newt.nres_ );
-					ALWAYS_ASSERT( 0 <= jlocal && jlocal < newt.nres_ );
-					newt.clear_twobody( ilocal, jlocal );
-				}
-			}
+			fill_subtable_block( newt, ilocal, jlocal, res_l2g[ilocal], res_l2g[jlocal] );
 		}}
 		return newt_p;
 	}
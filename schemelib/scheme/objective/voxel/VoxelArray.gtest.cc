@@ -92,4 +92,27 @@ TEST(VoxelArray,io){
 }
 
 
+TEST(VoxelArray,at_batch){
+	typedef util::SimpleArray<3,float> F3;
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> uniform(-4,5);
+
+	VoxelArray<3,float> a( F3(-1,-2,-3), F3(1,2,3), 0.37 );
+	for(size_t i = 0; i < a.num_elements(); ++i) a.data()[i] = uniform(rng);
+
+	std::vector<F3> pos(1000);
+	for( auto & p : pos ) p = F3( uniform(rng), uniform(rng), uniform(rng) );
+	std::vector<float> out( pos.size() );
+	a.at_batch( pos.size(), &pos[0], &out[0] );
+	int nin = 0;
+	for( int k = 0; k < pos.size(); ++k ){
+		ASSERT_EQ( a.at( pos[k] ), out[k] );
+		nin += out[k] != 0.0f;
+	}
+	ASSERT_GT( nin, 0 );
+	ASSERT_LT( nin, pos.size() );
+
+}
+
+
 }}}}
@@ -79,6 +79,27 @@ struct VoxelArray : boost::multi_array<_Float,_DIM> {
 		else return 0.0;
 	}
 
+	// same as at( v[k] ) for k in [0,n), but with no per-lookup branches so the
+	// index math and gather vectorize
+	template<class V>
+	void at_batch( size_t n, V const * v, Float * out ) const {
+		BOOST_STATIC_ASSERT((DIM==3));
+		int64_t const n0 = this->shape()[0], n1 = this->shape()[1], n2 = this->shape()[2];
+		int64_t const s0 = this->strides()[0], s1 = this->strides()[1], s2 = this->strides()[2];
+		Float const lb0 = lb_[0], lb1 = lb_[1], lb2 = lb_[2];
+		Float const cs0 = cs_[0], cs1 = cs_[1], cs2 = cs_[2];
+		Float const * const dat = this->data();
+		for( size_t k = 0; k < n; ++k ){
+			// truncation toward zero, as in floats_to_index
+			int64_t const i0 = (int64_t)( (v[k][0]-lb0)/cs0 );
+			int64_t const i1 = (int64_t)( (v[k][1]-lb1)/cs1 );
+			int64_t const i2 = (int64_t)( (v[k][2]-lb2)/cs2 );
+			bool const inbounds = 0 <= i0 && i0 < n0 && 0 <= i1 && i1 < n1 && 0 <= i2 && i2 < n2;
+			int64_t const idx = inbounds ? i0*s0 + i1*s1 + i2*s2 : 0;
+			out[k] = inbounds ? dat[idx] : (Float)0;
+		}
+	}
+
 	// void write(std::ostream & out) const {
 	// 	out.write( (char const*)&lb_, sizeof(Bounds) );
 	// 	out.write( (char const*)&ub_, sizeof(Bounds) );
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <scheme/search/AdaptiveBeam.hh>
+
+#include <algorithm>
+#include <random>
+
+namespace scheme { namespace search { namespace abtest {
+
+struct Pt { float score; };
+
+std::vector<Pt> linear_scores( int n, float step ){
+	std::vector<Pt> pts( n );
+	for( int i = 0; i < n; ++i ) pts[i].score = -100 + i * step;
+	return pts;
+}
+
+TEST( AdaptiveBeam, clamps_to_fracs ){
+	AdaptiveBeam beam( 0.1, 4.0, 0.0, 0.0 );
+	ASSERT_EQ( beam.min_keep( 1000 ), 100 );
+	ASSERT_EQ( beam.max_keep( 1000 ), 4000 );
+	ASSERT_EQ( beam.min_keep( 3 ), 1 );
+	ASSERT_EQ( AdaptiveBeam( 0.5, 0.1, 0, 0 ).max_keep( 100 ), 50 ); // max never below min
+
+	std::vector<Pt> pts = linear_scores( 100000, 0.001 ); // all below the cut of 0
+	std::shuffle( pts.begin(), pts.end(), std::mt19937(0) );
+
+	// no slack, only points tied with the reference can beat it: clamped up to min_frac
+	AdaptiveBeam::Stats stats;
+	ASSERT_EQ( beam.size( pts, 0, 1000, &stats ), 100 );
+	ASSERT_EQ( stats.can_beat, 99 );
+	ASSERT_FLOAT_EQ( stats.ref_score, -100 + 99 * 0.001 );
+
+	// huge slack, everything below the cut could beat it: clamped down to max_frac
+	AdaptiveBeam wide( 0.1, 4.0, 1e6, 0.0 );
+	ASSERT_EQ( wide.size( pts, 0, 1000, &stats ), 4000 );
+	ASSERT_EQ( stats.can_beat, pts.size() );
+}
+
+TEST( AdaptiveBeam, slack_sets_size_between_clamps ){
+	std::vector<Pt> pts = linear_scores( 100000, 0.001 );
+	std::shuffle( pts.begin(), pts.end(), std::mt19937(1) );
+	// reference is the 100th best, -99.901. slack 1.5 admits scores below -98.401
+	AdaptiveBeam beam( 0.1, 4.0, 1.5, 0.0 );
+	AdaptiveBeam::Stats stats;
+	uint64_t const keep = beam.size( pts, 0, 1000, &stats );
+	ASSERT_NEAR( (double)keep, 1599, 1 );
+	ASSERT_EQ( keep, stats.can_beat );
+	ASSERT_EQ( keep, stats.keep );
+
+	// more slack, more kept
+	ASSERT_GT( AdaptiveBeam( 0.1, 4.0, 2.5, 0.0 ).size( pts, 0, 1000 ), keep );
+
+	// the score cut caps the threshold no matter the slack
+	AdaptiveBeam capped( 0.1, 4.0, 1.5, -99.5 );
+	ASSERT_NEAR( (double)capped.size( pts, 0, 1000 ), 500, 1 );
+}
+
+TEST( AdaptiveBeam, sorted_prefix_matches_unsorted ){
+	std::vector<Pt> pts = linear_scores( 20000, 0.01 );
+	std::shuffle( pts.begin(), pts.end(), std::mt19937(2) );
+	AdaptiveBeam beam( 0.25, 3.0, 2.0, 50.0 );
+	uint64_t const unsorted = beam.size( pts, 0, 400 );
+
+	std::vector<Pt> sorted = pts;
+	std::sort( sorted.begin(), sorted.end(), []( Pt a, Pt b ){ return a.score < b.score; } );
+	ASSERT_EQ( beam.size( sorted, 100, 400 ), unsorted ); // ref is inside the sorted prefix
+	ASSERT_EQ( beam.size( sorted, 0, 400 ), unsorted );
+
+	// only the best max_keep held, as the fused hsearch stage does
+	sorted.resize( beam.max_keep( 400 ) );
+	ASSERT_EQ( beam.size( sorted, sorted.size(), 400 ), unsorted );
+}
+
+TEST( AdaptiveBeam, few_points ){
+	AdaptiveBeam beam( 0.1, 4.0, 1.0, 0.0 );
+	std::vector<Pt> none;
+	ASSERT_EQ( beam.size( none, 0, 1000 ), 100 );
+	std::vector<Pt> three = linear_scores( 3, 1.0 );
+	AdaptiveBeam::Stats stats;
+	ASSERT_EQ( beam.size( three, 0, 1000, &stats ), 100 ); // callers keep min( size, points )
+	ASSERT_FLOAT_EQ( stats.ref_score, -98 ); // the worst point is the reference
+	ASSERT_EQ( stats.can_beat, 3 );
+}
+
+}}}
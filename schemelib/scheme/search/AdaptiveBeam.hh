@@ -0,0 +1,68 @@
+#ifndef INCLUDED_search_AdaptiveBeam_HH
+#define INCLUDED_search_AdaptiveBeam_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace scheme { namespace search {
+
+///@brief beam size from the score distribution of one hierarchical search stage
+///@detail keeps the points that could still beat the reference point once refined, where
+///        the reference is the min_keep'th best and a point may improve by up to slack.
+///        the result is clamped to [min_frac, max_frac] * base_keep, and never below 1
+struct AdaptiveBeam {
+	float min_frac, max_frac;
+	float slack; // score units, callers scale it by the stage resolution
+	float score_cut;
+
+	AdaptiveBeam( float _min_frac, float _max_frac, float _slack, float _score_cut )
+		: min_frac(_min_frac), max_frac(_max_frac), slack(_slack), score_cut(_score_cut) {}
+
+	uint64_t min_keep( uint64_t base_keep ) const { return std::max<uint64_t>( 1, base_keep * min_frac ); }
+	uint64_t max_keep( uint64_t base_keep ) const { return std::max<uint64_t>( min_keep( base_keep ), base_keep * max_frac ); }
+
+	// what size() saw, for reporting
+	struct Stats { uint64_t keep = 0, can_beat = 0; float ref_score = 0; };
+
+	///@param nsorted the first nsorted points are the best ones, in order
+	///@note points only needs a float score. counting only the best max_keep points
+	///      gives the same size as counting all of them
+	template< class Point >
+	uint64_t size( std::vector<Point> const & points, uint64_t nsorted, uint64_t base_keep, Stats * stats = nullptr ) const {
+		uint64_t const lo = min_keep( base_keep ), hi = max_keep( base_keep );
+		if( points.empty() ) return lo;
+		uint64_t const iref = std::min<uint64_t>( lo, points.size() ) - 1;
+
+		float ref_score;
+		if( iref < nsorted ){
+			ref_score = points[iref].score;
+		} else {
+			std::vector<float> scores( points.size() );
+			for( size_t i = 0; i < points.size(); ++i ) scores[i] = points[i].score;
+			std::nth_element( scores.begin(), scores.begin() + iref, scores.end() );
+			ref_score = scores[iref];
+		}
+
+		float const thresh = std::min( score_cut, ref_score + slack );
+		uint64_t can_beat = 0;
+		#ifdef USE_OPENMP
+		#pragma omp parallel for reduction(+:can_beat)
+		#endif
+		for( int64_t i = 0; i < (int64_t)points.size(); ++i ){
+			can_beat += points[i].score < thresh;
+		}
+
+		uint64_t const keep = std::max( lo, std::min( hi, can_beat ) );
+		if( stats ){
+			stats->keep = keep;
+			stats->can_beat = can_beat;
+			stats->ref_score = ref_score;
+		}
+		return keep;
+	}
+};
+
+}}
+
+#endif
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <scheme/search/CompactSearchPointCodec.hh>
+
+#include <cmath>
+#include <random>
+#include <tuple>
+
+namespace scheme { namespace search { namespace cspctest {
+
+struct TestScaffoldIndex { uint64_t depth = 0, member = 0; };
+struct TestIndex { uint64_t nest_index = 0, seeding_index = 0; TestScaffoldIndex scaffold_index; };
+struct TestSearchPoint { float score = 9e9; TestIndex index; };
+
+typedef CompactSearchPointCodec< TestSearchPoint > Codec;
+
+TestSearchPoint
+random_point( std::vector<uint64_t> const & limits, uint64_t nest_size, uint64_t seeding_size, std::mt19937 & rng ){
+	std::uniform_real_distribution<float> runif( -100, 100 );
+	TestSearchPoint sp;
+	sp.score = runif(rng);
+	sp.index.nest_index = std::uniform_int_distribution<uint64_t>( 0, nest_size-1 )(rng);
+	sp.index.seeding_index = std::uniform_int_distribution<uint64_t>( 0, seeding_size-1 )(rng);
+	sp.index.scaffold_index.depth = std::uniform_int_distribution<uint64_t>( 0, limits.size()-1 )(rng);
+	sp.index.scaffold_index.member = std::uniform_int_distribution<uint64_t>( 0, limits[sp.index.scaffold_index.depth]-1 )(rng);
+	return sp;
+}
+
+TEST( CompactSearchPointCodec, encode_decode_round_trip ){
+	std::mt19937 rng(0);
+	std::vector<uint64_t> limits { 1, 7, 300 };
+	for( uint64_t nest_size : { uint64_t(1), uint64_t(1000), uint64_t(1)<<30 } ){
+		Codec c( nest_size, 17, limits );
+		ASSERT_TRUE( c.ok() );
+		ASSERT_EQ( c.score_bits, std::min( 32, 64 - c.index_bits() ) );
+		for( int i = 0; i < 10000; ++i ){
+			TestSearchPoint sp = random_point( limits, nest_size, 17, rng );
+			ASSERT_TRUE( c.fits( sp ) );
+			TestSearchPoint dec = c.decode( c.encode( sp ) );
+			ASSERT_EQ( dec.index.nest_index, sp.index.nest_index );
+			ASSERT_EQ( dec.index.seeding_index, sp.index.seeding_index );
+			ASSERT_EQ( dec.index.scaffold_index.depth, sp.index.scaffold_index.depth );
+			ASSERT_EQ( dec.index.scaffold_index.member, sp.index.scaffold_index.member );
+			// dropping the low mantissa bits truncates toward -inf
+			float const tol = std::abs( sp.score ) * std::ldexp( 1.0f, 32 - c.score_bits - 22 );
+			ASSERT_LE( dec.score, sp.score );
+			ASSERT_GE( dec.score, sp.score - tol );
+			if( c.score_bits == 32 ) ASSERT_EQ( dec.score, sp.score );
+		}
+	}
+}
+
+// member is the most significant index field, nest_index the least
+std::tuple<uint64_t,uint64_t,uint64_t,uint64_t>
+index_tuple( TestSearchPoint const & sp ){
+	return std::make_tuple( sp.index.scaffold_index.member, sp.index.scaffold_index.depth, sp.index.seeding_index, sp.index.nest_index );
+}
+
+TEST( CompactSearchPointCodec, sorts_by_score_then_index ){
+	std::mt19937 rng(1);
+	std::vector<uint64_t> limits { 5, 5 };
+	Codec c( 1<<20, 3, limits );
+	ASSERT_TRUE( c.ok() );
+	std::vector<TestSearchPoint> pts;
+	for( int i = 0; i < 5000; ++i ) pts.push_back( random_point( limits, 1<<20, 3, rng ) );
+	for( int i = 0; i < 500; ++i ){ pts.push_back( pts[i] ); pts.back().index.nest_index ^= 1; } // score ties
+	pts.push_back( TestSearchPoint() ); // the 9e9 "failed" score sorts last
+	for( size_t i = 0; i < pts.size(); ++i ){
+		for( size_t j = i % 7; j < pts.size(); j += 7 ){
+			TestSearchPoint a = pts[i], b = pts[j];
+			uint64_t const ea = c.encode(a), eb = c.encode(b);
+			if( a.score < b.score ) ASSERT_LE( ea, eb ); // rounding can only make them equal
+			float const ra = c.decode(ea).score, rb = c.decode(eb).score;
+			if( ra < rb ) ASSERT_LT( ea, eb );
+			if( ra == rb ) ASSERT_EQ( ea < eb, index_tuple(a) < index_tuple(b) );
+		}
+	}
+}
+
+TEST( CompactSearchPointCodec, score_cut_matches_exact_path ){
+	Codec c( uint64_t(1) << 48, 1, std::vector<uint64_t>{ 1 } ); // 16 score bits, coarse rounding
+	ASSERT_TRUE( c.ok() );
+	float const cut = -1.2345f;
+	TestSearchPoint at_cut;
+	at_cut.score = cut;
+	ASSERT_LT( c.decode( c.encode( at_cut ) ).score, cut ); // rounding alone would let it pass
+
+	c.score_cut = cut;
+	std::mt19937 rng(3);
+	std::vector<float> scores { cut, std::nextafter( cut, 0.0f ), std::nextafter( cut, -1.0f ),
+	                            cut + 1e-3f, cut - 1e-3f, -100, 100, 9e9 };
+	for( int i = 0; i < 1000; ++i ) scores.push_back( std::uniform_real_distribution<float>( cut-0.01, cut+0.01 )(rng) );
+	for( float score : scores ){
+		TestSearchPoint sp;
+		sp.score = score;
+		sp.index.nest_index = 12345;
+		TestSearchPoint const dec = c.decode( c.encode( sp ) );
+		// the filter HSearchScaleToReslTask applies after decoding
+		ASSERT_EQ( sp.score >= cut, dec.score >= cut ) << score;
+		ASSERT_EQ( dec.index.nest_index, sp.index.nest_index );
+	}
+}
+
+TEST( CompactSearchPointCodec, rejects_64_bit_indices ){
+	std::vector<uint64_t> limits { 2 };
+	Codec wide( ~uint64_t(0), 1, limits ); // 64 nest bits + 1 member bit
+	ASSERT_FALSE( wide.representable() );
+	ASSERT_FALSE( wide.ok() );
+	TestSearchPoint sp;
+	sp.score = 1;
+	ASSERT_FALSE( wide.fits( sp ) );
+
+	Codec exact( uint64_t(1) << 63, 1, std::vector<uint64_t>{ 1 } ); // 63 bits, 1 left for score
+	ASSERT_TRUE( exact.representable() );
+	ASSERT_EQ( exact.score_bits, 1 );
+	ASSERT_FALSE( exact.ok() );
+	sp.index.nest_index = ( uint64_t(1) << 63 ) - 1;
+	ASSERT_TRUE( exact.fits( sp ) );
+	ASSERT_EQ( exact.decode( exact.encode( sp ) ).index.nest_index, sp.index.nest_index );
+
+	Codec none;
+	ASSERT_FALSE( none.ok() );
+	ASSERT_TRUE( none.fits( TestSearchPoint() ) );
+	ASSERT_FALSE( none.fits( sp ) );
+}
+
+}}}
@@ -0,0 +1,90 @@
+#ifndef INCLUDED_search_CompactSearchPointCodec_HH
+#define INCLUDED_search_CompactSearchPointCodec_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace scheme { namespace search {
+
+///@brief packs a search point into one uint64_t that sorts by score, then index
+///@detail the index fields get just enough bits for the ranges given, the score keeps
+///        whatever is left over of its order preserving 32 bit form, so decoded scores are
+///        rounded. SearchPoint needs float score and index.{nest_index,seeding_index,
+///        scaffold_index.depth,scaffold_index.member}
+///@note if the index fields need 64 bits or more nothing fits, ok() and fits() are false.
+///      rounding moves scores down, so a point at or above a score cut could decode below
+///      it. scores >= score_cut are encoded as +inf, which decodes exactly
+template< class SearchPoint >
+struct CompactSearchPointCodec {
+	int nest_bits, seeding_bits, depth_bits, member_bits, score_bits;
+	float score_cut;
+
+	CompactSearchPointCodec() : nest_bits(0), seeding_bits(0), depth_bits(0), member_bits(0), score_bits(0),
+		score_cut( std::numeric_limits<float>::infinity() ) {}
+
+	CompactSearchPointCodec( uint64_t nest_size, uint64_t seeding_size, std::vector<uint64_t> const & scaffold_limits )
+	  : score_cut( std::numeric_limits<float>::infinity() ) {
+		uint64_t max_members = 1;
+		for ( uint64_t n : scaffold_limits ) max_members = std::max( max_members, n );
+		nest_bits = bits_for( nest_size );
+		seeding_bits = bits_for( seeding_size );
+		depth_bits = bits_for( scaffold_limits.size() );
+		member_bits = bits_for( max_members );
+		score_bits = representable() ? std::min( 32, 64 - index_bits() ) : 0;
+	}
+
+	int index_bits() const { return nest_bits + seeding_bits + depth_bits + member_bits; }
+
+	// every field, and so every shift below, is narrower than 64 bits
+	bool representable() const { return index_bits() < 64; }
+
+	// below this many score bits the rounding starts to reorder real score differences
+	bool ok( int min_score_bits = 16 ) const { return representable() && score_bits >= min_score_bits; }
+
+	bool fits( SearchPoint const & sp ) const {
+		return representable()
+			&& shr( sp.index.nest_index, nest_bits ) == 0
+			&& shr( sp.index.seeding_index, seeding_bits ) == 0
+			&& shr( sp.index.scaffold_index.depth, depth_bits ) == 0
+			&& shr( sp.index.scaffold_index.member, member_bits ) == 0;
+	}
+
+	// only meaningful if fits( sp )
+	uint64_t encode( SearchPoint const & sp ) const {
+		float const score = sp.score >= score_cut ? std::numeric_limits<float>::infinity() : sp.score;
+		uint32_t u;
+		std::memcpy( &u, &score, sizeof(u) );
+		uint32_t key = ( u & 0x80000000u ) ? ~u : ( u | 0x80000000u );
+		uint64_t word = shr( key, 32 - score_bits );
+		word = shl( word, member_bits  ) | (uint64_t)sp.index.scaffold_index.member;
+		word = shl( word, depth_bits   ) | (uint64_t)sp.index.scaffold_index.depth;
+		word = shl( word, seeding_bits ) | (uint64_t)sp.index.seeding_index;
+		word = shl( word, nest_bits    ) | (uint64_t)sp.index.nest_index;
+		return word;
+	}
+
+	SearchPoint decode( uint64_t word ) const {
+		SearchPoint sp;
+		sp.index.nest_index               = word & low_mask( nest_bits    ); word = shr( word, nest_bits    );
+		sp.index.seeding_index            = word & low_mask( seeding_bits ); word = shr( word, seeding_bits );
+		sp.index.scaffold_index.depth     = word & low_mask( depth_bits   ); word = shr( word, depth_bits   );
+		sp.index.scaffold_index.member    = word & low_mask( member_bits  ); word = shr( word, member_bits  );
+		uint32_t key = (uint32_t)shl( word, 32 - score_bits );
+		uint32_t u = ( key & 0x80000000u ) ? ( key & 0x7fffffffu ) : ~key;
+		std::memcpy( &sp.score, &u, sizeof(u) );
+		return sp;
+	}
+
+private:
+	static int bits_for( uint64_t n ) { int b = 0; while ( b < 64 && ( n-1 ) >> b ) b++; return n > 1 ? b : 0; }
+	static uint64_t low_mask( int b ) { return b >= 64 ? ~uint64_t(0) : ( uint64_t(1) << b ) - 1; }
+	template< class I > static uint64_t shr( I w, int b ) { return b >= 64 ? 0 : (uint64_t)w >> b; }
+	static uint64_t shl( uint64_t w, int b ) { return b >= 64 ? 0 : w << b; }
+};
+
+}}
+
+#endif
@@ -20,4 +20,251 @@ TEST( HackPack, create_empty_packer ){
 
 }
 
+shared_ptr< ::scheme::objective::storage::TwoBodyTable<float> >
+make_random_twob( int nres, int nrot, std::mt19937 & rng )
+{
+	std::uniform_real_distribution<float> runif(-1,1);
+	auto twob = make_shared< ::scheme::objective::storage::TwoBodyTable<float> >( nres, nrot );
+	for( int ires = 0; ires < nres; ++ires ){
+		for( int irot = 0; irot < nrot; ++irot ) twob->set_onebody( ires, irot, runif(rng) );
+		twob->set_onebody( ires, 0, 0.0 ); // "ala"
+	}
+	twob->init_onebody_filter( 0.5 );
+	for( int ir = 0; ir < nres; ++ir ){
+	for( int jr = 0; jr < ir; ++jr ){
+		if( (ir+jr)%3 == 0 ) continue; // leave some edges empty
+		twob->init_twobody( ir, jr );
+		for( int k = 0; k < twob->twobody_[ir][jr].num_elements(); ++k ){
+			twob->twobody_[ir][jr].data()[k] = runif(rng);
+		}
+	}}
+	return twob;
+}
+
+TEST( HackPack, cached_energy_delta ){
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(0,1);
+	int const nres = 8, nrot = 10;
+	auto twob = make_random_twob( nres, nrot, rng );
+
+	HackPackOpts opts;
+	opts.exact_max_work = 0; // make sure pack() anneals
+	HackPack packer( opts, 0 );
+	packer.reinitialize( twob );
+	for( int ires = 0; ires < nres; ++ires ){
+		for( int irot = 1; irot < nrot; ++irot ){
+			packer.add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+		}
+	}
+	packer.assign_random_rots();
+	packer.init_twobody_sums( packer.current_rots_ );
+
+	for( int itest = 0; itest < 1000; ++itest ){
+		int32_t ires, irot;
+		packer.randrot_not_current_uniform_rot( ires, irot );
+		float const delta = packer.compute_energy_delta( packer.current_rots_, ires, irot );
+		ASSERT_NEAR( delta, packer.compute_energy_delta_cached( ires, irot ), 0.001 );
+		if( runif(rng) < 0.5 ){
+			packer.update_twobody_sums( ires, irot );
+			packer.current_rots_[ires] = irot;
+		}
+	}
+
+	std::vector<std::pair<int32_t,int32_t> > result_rots;
+	float const score = packer.pack( result_rots );
+	ASSERT_EQ( result_rots.size(), nres );
+	ASSERT_NEAR( score, packer.compute_energy_full( packer.current_rots_ ), 0.001 );
+
+}
+
+TEST( HackPack, neighbor_graph ){
+
+	std::mt19937 rng(1);
+	int const nres = 9, nrot = 6;
+	auto twob = make_random_twob( nres, nrot, rng );
+
+	HackPackOpts opts;
+	HackPack packer( opts, 0 );
+	for( int irepeat = 0; irepeat < 2; ++irepeat ){ // reinitialize must reset nbrs
+		packer.reinitialize( twob );
+		for( int ires = 0; ires < nres; ++ires ){
+			if( ires == 4 ) continue;
+			for( int irot = 1; irot < nrot; ++irot ){
+				packer.add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+			}
+		}
+		for( int itest = 0; itest < 100; ++itest ){
+			packer.assign_random_rots();
+			float brute = 0;
+			for( int i = 0; i < packer.nres_; ++i ){
+				HackPack::RotInfo const & irot = packer.res_rots_[i].second[ packer.current_rots_[i] ];
+				brute += irot.second;
+				for( int j = 0; j < i; ++j ){
+					HackPack::RotInfo const & jrot = packer.res_rots_[j].second[ packer.current_rots_[j] ];
+					brute += twob->twobody_rotlocalnumbering( packer.res_rots_[i].first, packer.res_rots_[j].first, irot.first, jrot.first );
+				}
+			}
+			ASSERT_NEAR( brute, packer.compute_energy_full( packer.current_rots_ ), 0.001 );
+		}
+	}
+
+}
+
+float
+brute_force_min_energy( HackPack & packer )
+{
+	std::vector<int32_t> rots( packer.nres_, 0 );
+	float best = 9e9;
+	while( true ){
+		best = std::min( best, packer.compute_energy_full( rots ) );
+		int i = 0;
+		for( ; i < packer.nres_; ++i ){
+			if( ++rots[i] < packer.res_rots_[i].second.size() ) break;
+			rots[i] = 0;
+		}
+		if( i == packer.nres_ ) break;
+	}
+	return best;
+}
+
+TEST( HackPack, dee_keeps_gmec ){
+
+	std::mt19937 rng(2);
+	int const nres = 5, nrot = 8;
+	HackPackOpts opts;
+	HackPack packer( opts, 0 );
+
+	int ntot = 0, npruned = 0;
+	for( int itest = 0; itest < 20; ++itest ){
+		auto twob = make_random_twob( nres, nrot, rng );
+		packer.reinitialize( twob );
+		for( int ires = 0; ires < nres; ++ires ){
+			for( int irot = 1; irot < nrot; ++irot ){
+				packer.add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+			}
+		}
+		ntot += packer.rot_list_.size();
+		float const gmec = brute_force_min_energy( packer );
+		npruned += packer.dee_prune();
+		ASSERT_EQ( ntot-npruned, packer.dee_nrots_total_-packer.dee_nrots_pruned_ );
+		for( int ires = 0; ires < packer.nres_; ++ires ) ASSERT_GT( packer.res_rots_[ires].second.size(), 0 );
+		ASSERT_NEAR( gmec, brute_force_min_energy( packer ), 0.0001 );
+	}
+	cout << "DEE pruned " << npruned << " of " << ntot << " rotamers" << endl;
+	ASSERT_GT( npruned, 0 );
+
+}
+
+TEST( HackPack, exact_pack_matches_brute_force ){
+
+	std::mt19937 rng(3);
+	int const nres = 6, nrot = 6;
+	HackPackOpts opts;
+	opts.exact_max_treewidth = nres;
+	opts.exact_max_work = 1e9;
+	HackPack packer( opts, 0 );
+
+	for( int itest = 0; itest < 10; ++itest ){
+		auto twob = make_random_twob( nres, nrot, rng );
+		packer.reinitialize( twob );
+		for( int ires = 0; ires < nres; ++ires ){
+			for( int irot = 1; irot < nrot; ++irot ){
+				packer.add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+			}
+		}
+		float const gmec = brute_force_min_energy( packer );
+		ASSERT_TRUE( packer.pack_exact() );
+		ASSERT_NEAR( gmec, packer.score_, 0.0001 );
+		std::vector<std::pair<int32_t,int32_t> > result_rots;
+		ASSERT_NEAR( gmec, packer.pack( result_rots ), 0.0001 );
+	}
+	EXPECT_EQ( packer.npacks_exact_, packer.npacks_ );
+	EXPECT_GT( packer.npacks_, 0u );
+	packer.reset_stats();
+	EXPECT_EQ( 0, packer.npacks_ );
+	EXPECT_EQ( 0, packer.npacks_exact_ );
+
+	opts.exact_max_treewidth = 0; // every res has neighbors here
+	HackPack packer2( opts, 0 );
+	packer2.reinitialize( make_random_twob( nres, nrot, rng ) );
+	for( int ires = 0; ires < nres; ++ires ){
+		for( int irot = 1; irot < nrot; ++irot ){
+			packer2.add_tmp_rot( ires, irot, packer2.twob_->onebody(ires,irot) );
+		}
+	}
+	EXPECT_FALSE( packer2.pack_exact() );
+
+}
+
+TEST( HackPack, replica_exchange_finds_gmec ){
+
+	std::mt19937 rng(5);
+	int const nres = 6, nrot = 6;
+	HackPackOpts opts;
+	opts.exact_max_work = 0;
+	opts.pt_nreplicas = 6;
+	opts.pt_rounds = 20;
+	HackPack packer( opts, 0 );
+	packer.rng.seed( 5 );
+
+	for( int itest = 0; itest < 10; ++itest ){
+		auto twob = make_random_twob( nres, nrot, rng );
+		packer.reinitialize( twob );
+		for( int ires = 0; ires < nres; ++ires ){
+			for( int irot = 1; irot < nrot; ++irot ){
+				packer.add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+			}
+		}
+		float const gmec = brute_force_min_energy( packer );
+		std::vector<std::pair<int32_t,int32_t> > result_rots;
+		float const score = packer.pack( result_rots );
+		ASSERT_NEAR( gmec, score, 0.0001 );
+		ASSERT_NEAR( score, packer.compute_energy_full( packer.global_best_rots_ ), 0.0001 );
+		// every temperature slot holds exactly one replica
+		std::vector<int32_t> at_temp = packer.pt_replica_at_temp_;
+		std::sort( at_temp.begin(), at_temp.end() );
+		for( int k = 0; k < opts.pt_nreplicas; ++k ) ASSERT_EQ( k, at_temp[k] );
+	}
+	EXPECT_EQ( 0, packer.npacks_exact_ );
+
+}
+
+// with the same number of substitution attempts, replica exchange should find lower energies
+// than the annealing schedule on problems too big to always solve. annealing makes
+// 8*pack_n_iters passes of pack_iters attempts, replica exchange pt_nreplicas*pt_rounds plus a quench
+TEST( HackPack, replica_exchange_not_worse_than_annealing ){
+
+	std::mt19937 rng(7);
+	int const nres = 20, nrot = 10;
+	HackPackOpts anneal_opts;
+	anneal_opts.exact_max_work = 0;
+	anneal_opts.pack_n_iters = 2;
+	HackPackOpts pt_opts = anneal_opts;
+	pt_opts.pt_nreplicas = 3;
+	pt_opts.pt_rounds = 5;
+	ASSERT_EQ( 8*anneal_opts.pack_n_iters, pt_opts.pt_nreplicas*pt_opts.pt_rounds+1 );
+
+	HackPack anneal( anneal_opts, 0 ), pt( pt_opts, 0 );
+	anneal.rng.seed( 1 );
+	pt.rng.seed( 1 );
+	double anneal_sum = 0, pt_sum = 0;
+	for( int itest = 0; itest < 20; ++itest ){
+		auto twob = make_random_twob( nres, nrot, rng );
+		for( HackPack * packer : { &anneal, &pt } ){
+			packer->reinitialize( twob );
+			for( int ires = 0; ires < nres; ++ires ){
+				for( int irot = 1; irot < nrot; ++irot ){
+					packer->add_tmp_rot( ires, irot, twob->onebody(ires,irot) );
+				}
+			}
+		}
+		std::vector<std::pair<int32_t,int32_t> > result_rots;
+		anneal_sum += anneal.pack( result_rots );
+		pt_sum += pt.pack( result_rots );
+	}
+	ASSERT_LE( pt_sum, anneal_sum );
+
+}
+
 }}}
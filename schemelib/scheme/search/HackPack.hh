@@ -4,6 +4,7 @@
 #include "scheme/objective/storage/TwoBodyTable.hh"
 
 	#include <random>
+	#include <set>
 	#include <boost/foreach.hpp>
 
 
@@ -51,6 +52,15 @@ struct HackPackOpts
 	float user_rotamer_bonus_constant = -2; //-2
 	float user_rotamer_bonus_per_chi = -2; // 2
 	bool  rescore_rots_before_insertion = true;		// this isn't a real flag, gets used in MyScoreBBActorVsRif
+	bool  dee_prune = false; // goldstein dead end elimination before annealing
+	int   dee_max_iters = 10;
+	int   pt_nreplicas = 0; // >1 for replica exchange instead of annealing
+	int   pt_rounds = 2; // each replica makes pt_rounds*(pack_iter_mult*nrots+10) substitution attempts
+	int   pt_swap_interval = 10;
+	float pt_temp_max = 10.0;
+	float pt_temp_min = 0.1;
+	int   exact_max_treewidth = 3; // solve exactly instead of annealing if the res graph is this simple...
+	float exact_max_work = 0; // ...and the dp tables are this small in total, 0 (default) always anneals
 };
 inline
 std::ostream & operator<<( std::ostream & out, HackPackOpts const & hpo ){
@@ -69,6 +79,15 @@ std::ostream & operator<<( std::ostream & out, HackPackOpts const & hpo ){
 		<< "\n  user_rotamer_bonus_constant " << hpo.user_rotamer_bonus_constant 
 		<< "\n  user_rotamer_bonus_per_chi" << hpo.user_rotamer_bonus_per_chi
 		<< "\n  rescore_rots_before_insertion " << hpo.rescore_rots_before_insertion
+		<< "\n  dee_prune " << hpo.dee_prune
+		<< "\n  dee_max_iters " << hpo.dee_max_iters
+		<< "\n  pt_nreplicas " << hpo.pt_nreplicas
+		<< "\n  pt_rounds " << hpo.pt_rounds
+		<< "\n  pt_swap_interval " << hpo.pt_swap_interval
+		<< "\n  pt_temp_max " << hpo.pt_temp_max
+		<< "\n  pt_temp_min " << hpo.pt_temp_min
+		<< "\n  exact_max_treewidth " << hpo.exact_max_treewidth
+		<< "\n  exact_max_work " << hpo.exact_max_work
 
 
 	    << std::endl;
@@ -81,6 +100,7 @@ struct HackPack
 	typedef std::pair< int32_t, std::vector< RotInfo > > RotInfos;
 	int nres_; // total res currently stored
 	std::vector< RotInfos > res_rots_; // iresapp + list of irottwob/onebody pairs
+	std::vector< std::vector< int32_t > > res_nbrs_; // local res with a twobody block vs. each local res
 	std::vector< std::pair<int32_t,int32_t> > rot_list_; // list of ireslocal / irotlocal pairs
 	std::vector< int32_t > current_rots_, trial_best_rots_, global_best_rots_; // current rotamer in local numbering
 	std::mt19937 rng;
@@ -88,6 +108,17 @@ struct HackPack
 	float score_, trial_best_score_, global_best_score_;
 	HackPackOpts opts_;
 	int32_t default_rot_num_;
+	// running sum, per local res/rot, of twobody energy vs. the current_rots_ of all other res
+	// lets a substitution trial be a single lookup; only neighbors' sums change on accept
+	std::vector< int32_t > rot_offset_; // start of each local res's rots in twob_sums_
+	std::vector< float > twob_sums_;
+	uint64_t dee_nrots_total_ = 0, dee_nrots_pruned_ = 0; // running totals since reset_stats()
+	uint64_t npacks_ = 0, npacks_exact_ = 0;
+	void reset_stats(){ dee_nrots_total_ = dee_nrots_pruned_ = npacks_ = npacks_exact_ = 0; }
+	// replica exchange state, twobody sums of replica k start at k*rot_offset_[nres_]
+	std::vector< std::vector< int32_t > > pt_rots_;
+	std::vector< float > pt_sums_, pt_scores_, pt_temps_;
+	std::vector< int32_t > pt_replica_at_temp_;
 	HackPack(
 		// ::scheme::objective::storage::TwoBodyTable<float> const & twob,
 		HackPackOpts const & opts,
@@ -122,6 +153,9 @@ struct HackPack
 			rotinfos.first = -1;
 			rotinfos.second.clear();
 		}
+		BOOST_FOREACH( std::vector< int32_t > & nbrs, res_nbrs_ ){
+			nbrs.clear();
+		}
 		nres_ = 0;
 	}
 	template< class Int >
@@ -151,6 +185,7 @@ struct HackPack
 				++nres_;
 				if( res_rots_.size() < nres_ ) res_rots_.resize( nres_ );
 				res_rots_.at(nres_-1).first = ires;
+				add_res_nbrs( nres_-1 );
 				// always allow ALA as an option:
 				int alarot = twob_->all2sel_[ires][ default_rot_num_ ];
 				if( alarot >= 0 ) {
@@ -178,6 +213,24 @@ struct HackPack
 	}
 
 
+	// twobody tables only have blocks for residue pairs within some distance,
+	// so only those local res pairs are visited during packing
+	void add_res_nbrs( int32_t const & ilres )
+	{
+		if( res_nbrs_.size() < nres_ ) res_nbrs_.resize( nres_ );
+		res_nbrs_.at(ilres).clear();
+		int32_t const iresglobal = res_rots_.at(ilres).first;
+		for( int jlres = 0; jlres < ilres; ++jlres ){
+			int32_t const jresglobal = res_rots_.at(jlres).first;
+			int32_t const ir = std::max( iresglobal, jresglobal );
+			int32_t const jr = std::min( iresglobal, jresglobal );
+			if( twob_->has_twobody( ir, jr ) ){
+				res_nbrs_.at(ilres).push_back( jlres );
+				res_nbrs_.at(jlres).push_back( ilres );
+			}
+		}
+	}
+
 	float
 	compute_energy_full(
 		std::vector< int32_t > const & rots
@@ -201,7 +254,8 @@ struct HackPack
 			int32_t const irottwob   = res_rots_.at(ires).second.at( irotlocal ).first;
 			float const ionebody     = res_rots_.at(ires).second.at( irotlocal ).second;
 			score += ionebody;
-			for( int jres = 0; jres < ires; ++jres ){
+			BOOST_FOREACH( int32_t const & jres, res_nbrs_[ires] ){
+				if( jres > ires ) continue;
 					assert( 0 <= jres && jres < rots.size() );
 				int32_t const jrotlocal = rots.at(jres);
 					assert( 0 <= jres && jres < res_rots_.size() );
@@ -239,8 +293,7 @@ struct HackPack
 		float   const ionebodynew = res_rots_.at(ilres).second.at(  ilrotnew   ).second;
 		delta -= ionebodyold;
 		delta += ionebodynew;
-		for( int j = 0; j < nres_; ++j ){
-			if( j == ilres ) continue;
+		BOOST_FOREACH( int32_t const & j, res_nbrs_[ilres] ){
 			int32_t const jresglobal = res_rots_.at(j).first;
 			int32_t const jrottwob   = res_rots_.at(j).second.at( rots.at(j) ).first;
 			float   const jonebody   = res_rots_.at(j).second.at( rots.at(j) ).second;
@@ -272,6 +325,307 @@ struct HackPack
 		}
 		return delta;
 	}
+	void init_rot_offsets()
+	{
+		rot_offset_.resize( nres_+1 );
+		rot_offset_[0] = 0;
+		for( int ires = 0; ires < nres_; ++ires ){
+			rot_offset_[ires+1] = rot_offset_[ires] + res_rots_[ires].second.size();
+		}
+	}
+	void init_twobody_sums( std::vector< int32_t > const & rots )
+	{
+		init_rot_offsets();
+		twob_sums_.assign( rot_offset_[nres_], 0.0f );
+		init_twobody_sums( rots, &twob_sums_[0] );
+	}
+	// sums must be zeroed, rot_offset_[nres_] long
+	void init_twobody_sums( std::vector< int32_t > const & rots, float * sums ) const
+	{
+		for( int ires = 0; ires < nres_; ++ires ){
+			int32_t const iresglobal = res_rots_[ires].first;
+			std::vector< RotInfo > const & irots = res_rots_[ires].second;
+			float * isums = sums + rot_offset_[ires];
+			BOOST_FOREACH( int32_t const & jres, res_nbrs_[ires] ){
+				int32_t const jresglobal = res_rots_[jres].first;
+				int32_t const jrottwob   = res_rots_[jres].second[ rots.at(jres) ].first;
+				for( int irot = 0; irot < irots.size(); ++irot ){
+					isums[irot] += twob_->twobody_rotlocalnumbering( iresglobal, jresglobal, irots[irot].first, jrottwob );
+				}
+			}
+		}
+	}
+	// same as compute_energy_delta( current_rots_, ... ) but O(1), requires init_twobody_sums( current_rots_ )
+	float
+	compute_energy_delta_cached(
+		int32_t const & ilres,
+		int32_t const & ilrotnew
+	) const {
+		return compute_energy_delta_cached( current_rots_, &twob_sums_[0], ilres, ilrotnew );
+	}
+	float
+	compute_energy_delta_cached(
+		std::vector< int32_t > const & rots,
+		float const * sums,
+		int32_t const & ilres,
+		int32_t const & ilrotnew
+	) const {
+		int32_t const ilrotold = rots[ilres];
+		std::vector< RotInfo > const & irots = res_rots_[ilres].second;
+		float const * isums = sums + rot_offset_[ilres];
+		float const delta = irots[ilrotnew].second - irots[ilrotold].second + isums[ilrotnew] - isums[ilrotold];
+		if( -123460.0 > delta || delta > 123460.0 ){
+			// recompute the slow way, which will report / throw as appropriate
+			return compute_energy_delta( rots, ilres, ilrotnew );
+		}
+		return delta;
+	}
+	// call before current_rots_[ilres] is changed to ilrotnew
+	void update_twobody_sums(
+		int32_t const & ilres,
+		int32_t const & ilrotnew
+	){
+		update_twobody_sums( current_rots_, &twob_sums_[0], ilres, ilrotnew );
+	}
+	void update_twobody_sums(
+		std::vector< int32_t > const & rots,
+		float * sums,
+		int32_t const & ilres,
+		int32_t const & ilrotnew
+	) const {
+		int32_t const iresglobal  = res_rots_[ilres].first;
+		int32_t const irottwobold = res_rots_[ilres].second[ rots[ilres] ].first;
+		int32_t const irottwobnew = res_rots_[ilres].second[ ilrotnew ].first;
+		BOOST_FOREACH( int32_t const & jres, res_nbrs_[ilres] ){
+			int32_t const jresglobal = res_rots_[jres].first;
+			std::vector< RotInfo > const & jrots = res_rots_[jres].second;
+			float * jsums = sums + rot_offset_[jres];
+			for( int jrot = 0; jrot < jrots.size(); ++jrot ){
+				jsums[jrot] += twob_->twobody_rotlocalnumbering( iresglobal, jresglobal, irottwobnew, jrots[jrot].first )
+				             - twob_->twobody_rotlocalnumbering( iresglobal, jresglobal, irottwobold, jrots[jrot].first );
+			}
+		}
+	}
+	// goldstein singles: irot can't be in the GMEC if some other t at the same res is better in every context
+	//   E(r) - E(t) + sum_nbrs min_s[ E(r,s) - E(t,s) ] > 0
+	// removes dead rotamers from res_rots_ and rot_list_, returns number removed
+	int dee_prune()
+	{
+		std::vector< int32_t > offset( nres_+1, 0 );
+		for( int ires = 0; ires < nres_; ++ires ){
+			offset[ires+1] = offset[ires] + res_rots_[ires].second.size();
+		}
+		std::vector< char > alive( offset[nres_], 1 );
+		std::vector< int32_t > nalive( nres_ );
+		for( int ires = 0; ires < nres_; ++ires ) nalive[ires] = res_rots_[ires].second.size();
+
+		int npruned = 0;
+		for( int iter = 0; iter < opts_.dee_max_iters; ++iter ){
+			int npruned_iter = 0;
+			for( int ires = 0; ires < nres_; ++ires ){
+				int32_t const iresglobal = res_rots_[ires].first;
+				std::vector< RotInfo > const & irots = res_rots_[ires].second;
+				for( int r = 0; r < irots.size(); ++r ){
+					if( nalive[ires] == 1 ) break;
+					if( !alive[ offset[ires]+r ] ) continue;
+					for( int t = 0; t < irots.size(); ++t ){
+						if( t == r || !alive[ offset[ires]+t ] ) continue;
+						float bound = irots[r].second - irots[t].second;
+						BOOST_FOREACH( int32_t const & jres, res_nbrs_[ires] ){
+							int32_t const jresglobal = res_rots_[jres].first;
+							std::vector< RotInfo > const & jrots = res_rots_[jres].second;
+							float mindiff = 9e9;
+							for( int s = 0; s < jrots.size(); ++s ){
+								if( !alive[ offset[jres]+s ] ) continue;
+								float const diff = twob_->twobody_rotlocalnumbering( iresglobal, jresglobal, irots[r].first, jrots[s].first )
+								                 - twob_->twobody_rotlocalnumbering( iresglobal, jresglobal, irots[t].first, jrots[s].first );
+								mindiff = std::min( mindiff, diff );
+							}
+							bound += mindiff;
+						}
+						if( bound > 0 ){
+							alive[ offset[ires]+r ] = 0;
+							--nalive[ires];
+							++npruned_iter;
+							break;
+						}
+					}
+				}
+			}
+			npruned += npruned_iter;
+			if( npruned_iter == 0 ) break;
+		}
+
+		rot_list_.clear();
+		for( int ires = 0; ires < nres_; ++ires ){
+			std::vector< RotInfo > & irots = res_rots_[ires].second;
+			int nkeep = 0;
+			for( int r = 0; r < irots.size(); ++r ){
+				if( !alive[ offset[ires]+r ] ) continue;
+				irots[nkeep] = irots[r];
+				rot_list_.push_back( std::make_pair( ires, nkeep ) );
+				++nkeep;
+			}
+			irots.resize( nkeep );
+		}
+		dee_nrots_total_ += offset[nres_];
+		dee_nrots_pruned_ += npruned;
+		return npruned;
+	}
+	// table over some local res, first var varies fastest
+	struct ExactFactor {
+		std::vector< int32_t > vars;
+		std::vector< float > table;
+	};
+	// global minimum by variable elimination along a min-fill order, which is dp over the tree
+	// decomposition whose bags are each eliminated res plus its not-yet-eliminated neighbors.
+	// returns false, changing nothing, if the decomposition is wider or more work than allowed
+	bool pack_exact()
+	{
+		int const n = nres_;
+		std::vector< double > dom( n );
+		for( int i = 0; i < n; ++i ) dom[i] = res_rots_[i].second.size();
+
+		// min-fill elimination order, bags
+		std::vector< std::set< int32_t > > adj( n );
+		for( int i = 0; i < n; ++i ) adj[i].insert( res_nbrs_[i].begin(), res_nbrs_[i].end() );
+		std::vector< int32_t > order, elim_pos( n );
+		std::vector< std::vector< int32_t > > bags;
+		std::vector< char > eliminated( n, 0 );
+		double work = 0;
+		for( int k = 0; k < n; ++k ){
+			int32_t best = -1;
+			int64_t bestfill = 0;
+			double bestsize = 0;
+			for( int v = 0; v < n; ++v ){
+				if( eliminated[v] ) continue;
+				int64_t fill = 0;
+				double size = dom[v];
+				BOOST_FOREACH( int32_t const & a, adj[v] ){
+					size *= dom[a];
+					BOOST_FOREACH( int32_t const & b, adj[v] ){
+						if( a < b && adj[a].count(b) == 0 ) ++fill;
+					}
+				}
+				if( best < 0 || fill < bestfill || ( fill == bestfill && size < bestsize ) ){
+					best = v;
+					bestfill = fill;
+					bestsize = size;
+				}
+			}
+			if( adj[best].size() > opts_.exact_max_treewidth ) return false;
+			work += bestsize;
+			if( work > opts_.exact_max_work ) return false;
+			order.push_back( best );
+			elim_pos[best] = k;
+			eliminated[best] = 1;
+			bags.push_back( std::vector< int32_t >( adj[best].begin(), adj[best].end() ) );
+			BOOST_FOREACH( int32_t const & a, adj[best] ){
+				adj[a].erase( best );
+				BOOST_FOREACH( int32_t const & b, adj[best] ) if( a != b ) adj[a].insert( b );
+			}
+		}
+
+		// initial factors go in the bucket of their first eliminated var
+		std::vector< std::vector< ExactFactor > > buckets( n );
+		for( int i = 0; i < n; ++i ){
+			std::vector< RotInfo > const & irots = res_rots_[i].second;
+			ExactFactor onebody;
+			onebody.vars.push_back( i );
+			for( int r = 0; r < irots.size(); ++r ) onebody.table.push_back( irots[r].second );
+			buckets[ elim_pos[i] ].push_back( onebody );
+			BOOST_FOREACH( int32_t const & j, res_nbrs_[i] ){
+				if( j > i ) continue;
+				std::vector< RotInfo > const & jrots = res_rots_[j].second;
+				ExactFactor twobody;
+				twobody.vars.push_back( i );
+				twobody.vars.push_back( j );
+				twobody.table.resize( irots.size() * jrots.size() );
+				for( int s = 0; s < jrots.size(); ++s ){
+				for( int r = 0; r < irots.size(); ++r ){
+					twobody.table[ r + irots.size()*s ] = twob_->twobody_rotlocalnumbering(
+						res_rots_[i].first, res_rots_[j].first, irots[r].first, jrots[s].first );
+				}}
+				buckets[ std::min( elim_pos[i], elim_pos[j] ) ].push_back( twobody );
+			}
+		}
+
+		// eliminate, keeping the best choice of each var for every assignment of the rest of its bag
+		std::vector< std::vector< int32_t > > choice( n );
+		float minscore = 0;
+		for( int k = 0; k < n; ++k ){
+			int32_t const v = order[k];
+			std::vector< int32_t > const & bag = bags[k];
+			// local slot 0 is v, slot 1+b is bag[b]
+			std::vector< std::vector< std::pair<int32_t,int32_t> > > slot_strides;
+			BOOST_FOREACH( ExactFactor const & f, buckets[k] ){
+				slot_strides.push_back( std::vector< std::pair<int32_t,int32_t> >() );
+				int32_t stride = 1;
+				BOOST_FOREACH( int32_t const & var, f.vars ){
+					int32_t slot = 0;
+					if( var != v ) slot = 1 + std::find( bag.begin(), bag.end(), var ) - bag.begin();
+					assert( slot <= bag.size() );
+					slot_strides.back().push_back( std::make_pair( slot, stride ) );
+					stride *= res_rots_[var].second.size();
+				}
+			}
+			ExactFactor message;
+			message.vars = bag;
+			int64_t nassign = 1;
+			BOOST_FOREACH( int32_t const & b, bag ) nassign *= res_rots_[b].second.size();
+			message.table.resize( nassign );
+			choice[k].resize( nassign );
+			std::vector< int32_t > val( 1+bag.size(), 0 );
+			for( int64_t iassign = 0; iassign < nassign; ++iassign ){
+				float best = 9e9;
+				int32_t bestrot = 0;
+				for( val[0] = 0; val[0] < res_rots_[v].second.size(); ++val[0] ){
+					float sum = 0;
+					for( int ifac = 0; ifac < buckets[k].size(); ++ifac ){
+						int64_t idx = 0;
+						for( int q = 0; q < slot_strides[ifac].size(); ++q ){
+							idx += val[ slot_strides[ifac][q].first ] * slot_strides[ifac][q].second;
+						}
+						sum += buckets[k][ifac].table[idx];
+					}
+					if( sum < best ){
+						best = sum;
+						bestrot = val[0];
+					}
+				}
+				message.table[iassign] = best;
+				choice[k][iassign] = bestrot;
+				for( int b = 0; b < bag.size(); ++b ){ // next assignment, first var fastest
+					if( ++val[1+b] < res_rots_[ bag[b] ].second.size() ) break;
+					val[1+b] = 0;
+				}
+			}
+			buckets[k].clear();
+			if( bag.empty() ){
+				minscore += message.table[0];
+			} else {
+				int32_t first = bag[0];
+				BOOST_FOREACH( int32_t const & b, bag ) if( elim_pos[b] < elim_pos[first] ) first = b;
+				buckets[ elim_pos[first] ].push_back( message );
+			}
+		}
+
+		// trace back in reverse elimination order, bags only contain later-eliminated vars
+		current_rots_.resize( n );
+		for( int k = n-1; k >= 0; --k ){
+			std::vector< int32_t > const & bag = bags[k];
+			int64_t idx = 0, stride = 1;
+			BOOST_FOREACH( int32_t const & b, bag ){
+				idx += current_rots_[b] * stride;
+				stride *= res_rots_[b].second.size();
+			}
+			current_rots_[ order[k] ] = choice[k][idx];
+		}
+		global_best_rots_ = current_rots_;
+		score_ = global_best_score_ = compute_energy_full( current_rots_ );
+		assert( std::fabs( score_ - minscore ) < 0.01 * std::max( 1.0f, std::fabs( score_ ) ) );
+		return true;
+	}
 	int32_t randres()
 	{
 		std::uniform_int_distribution<> rand_idx(0,nres_-1);
@@ -300,13 +654,17 @@ struct HackPack
 		ALWAYS_ASSERT( 0 <= irot && irot < res_rots_.at(ires).second.size() );
 	}
 	void randrot_not_current_uniform_rot( int32_t & ires, int32_t & irot )
+	{
+		randrot_not_current_uniform_rot( current_rots_, ires, irot );
+	}
+	void randrot_not_current_uniform_rot( std::vector< int32_t > const & rots, int32_t & ires, int32_t & irot )
 	{
 		std::uniform_int_distribution<> rand_idx(0,rot_list_.size()-1);
 		for( int i = 0; i < 1000; ++i ){
 			int const irand = rand_idx(rng);
 			ires = rot_list_.at(irand).first;
 			irot = rot_list_.at(irand).second;
-			if( res_rots_.at(ires).second.size() > 1 && irot != current_rots_.at(ires) ) return;
+			if( res_rots_.at(ires).second.size() > 1 && irot != rots.at(ires) ) return;
 		}
 		std::cerr << "randrot_not_current_uniform_rot FAIL" << std::endl;
 		std::exit(-1);
@@ -317,7 +675,7 @@ struct HackPack
 		int32_t ires, irot;
 		randrot_not_current_uniform_rot( ires, irot );
 
-		float delta = compute_energy_delta( current_rots_, ires, irot );
+		float delta = compute_energy_delta_cached( ires, irot );
 		// {
 		// 	// std::cout << "SUB: " << ires << " " << irot << " " << res_rots_[ires].first << std::endl;
 		// 	// std::cout << "==================================== old ==========================================" << std::endl;
@@ -338,6 +696,7 @@ struct HackPack
 		// }
 
 		if( pass_metropolis( temperature, delta, runif(rng) ) ){
+			update_twobody_sums( ires, irot );
 			current_rots_.at(ires) = irot;
 			score_ += delta;
 			if( score_ < trial_best_score_ ){
@@ -346,9 +705,84 @@ struct HackPack
 			}
 		}
 	}
+	void replica_substitution_test( int32_t const & k, float temperature ){
+		std::uniform_real_distribution<float> runif(0,1);
+		std::vector< int32_t > & rots = pt_rots_[k];
+		float * sums = &pt_sums_[ k*rot_offset_[nres_] ];
+
+		int32_t ires, irot;
+		randrot_not_current_uniform_rot( rots, ires, irot );
+		float const delta = compute_energy_delta_cached( rots, sums, ires, irot );
+		if( pass_metropolis( temperature, delta, runif(rng) ) ){
+			update_twobody_sums( rots, sums, ires, irot );
+			rots[ires] = irot;
+			pt_scores_[k] += delta;
+			if( pt_scores_[k] < global_best_score_ ){
+				global_best_score_ = pt_scores_[k];
+				global_best_rots_ = rots;
+			}
+		}
+	}
+	// parallel tempering: pt_nreplicas walkers at geometrically spaced temperatures, neighbors in
+	// temperature swap every pt_swap_interval steps with prob min( 1, exp( (1/Ti-1/Tj)(Ei-Ej) ) )
+	// the best state seen is quenched at T=0 and left in current_rots_ / score_
+	void pack_replica_exchange()
+	{
+		std::uniform_real_distribution<float> runif(0,1);
+		int const K = opts_.pt_nreplicas;
+		init_rot_offsets();
+		int const nrots = rot_offset_[nres_];
+		pt_rots_.resize( K );
+		pt_sums_.assign( K*nrots, 0.0f );
+		pt_scores_.resize( K );
+		pt_temps_.resize( K );
+		pt_replica_at_temp_.resize( K );
+		global_best_score_ = 9e9;
+		for( int k = 0; k < K; ++k ){
+			pt_temps_[k] = opts_.pt_temp_max * std::pow( opts_.pt_temp_min / opts_.pt_temp_max, (float)k/(K-1) );
+			pt_replica_at_temp_[k] = k;
+			if( k == 0 || !opts_.init_with_best_1be_rots ) assign_initial_rots();
+			pt_rots_[k] = current_rots_;
+			pt_scores_[k] = compute_energy_full( current_rots_ );
+			init_twobody_sums( pt_rots_[k], &pt_sums_[k*nrots] );
+			if( pt_scores_[k] < global_best_score_ ){
+				global_best_score_ = pt_scores_[k];
+				global_best_rots_ = pt_rots_[k];
+			}
+		}
+
+		int const pack_iters = opts_.pack_iter_mult * rot_list_.size()+10;
+		int const interval = std::max( 1, opts_.pt_swap_interval );
+		int64_t const nsteps = (int64_t)pack_iters * opts_.pt_rounds;
+		for( int64_t step = 0, iswap = 0; step < nsteps; step += interval, ++iswap ){
+			for( int t = 0; t < K; ++t ){
+				for( int i = 0; i < interval; ++i ){
+					replica_substitution_test( pt_replica_at_temp_[t], pt_temps_[t] );
+				}
+			}
+			for( int t = iswap%2; t+1 < K; t += 2 ){
+				int32_t const ka = pt_replica_at_temp_[t], kb = pt_replica_at_temp_[t+1];
+				float const arg = ( 1.0f/pt_temps_[t] - 1.0f/pt_temps_[t+1] ) * ( pt_scores_[ka] - pt_scores_[kb] );
+				if( arg >= 0 || std::exp(arg) > runif(rng) ){
+					std::swap( pt_replica_at_temp_[t], pt_replica_at_temp_[t+1] );
+				}
+			}
+		}
+
+		current_rots_ = global_best_rots_;
+		score_ = trial_best_score_ = compute_energy_full( current_rots_ );
+		trial_best_rots_ = current_rots_;
+		init_twobody_sums( current_rots_ );
+		for( int i = 0; i < pack_iters; ++i ) random_substitution_test( 0.0 ); recover_trial_best();
+		global_best_score_ = score_;
+		global_best_rots_ = current_rots_;
+	}
 	void recover_trial_best(){
 		score_ = trial_best_score_;
-		current_rots_ = trial_best_rots_;
+		if( current_rots_ != trial_best_rots_ ){
+			current_rots_ = trial_best_rots_;
+			init_twobody_sums( current_rots_ );
+		}
 	}
 	void assign_random_rots(){
 		current_rots_.resize( nres_ );
@@ -408,6 +842,8 @@ struct HackPack
 			assert( res_rots_.at(i).second.size() > 0 );
 		}
 
+		if( opts_.dee_prune ) dee_prune();
+
 		assign_initial_rots();
 
 		uint64_t nchoices = 1;
@@ -423,12 +859,26 @@ struct HackPack
 			return score_;
 		}
 
+		++npacks_;
+		if( opts_.exact_max_work > 0 && pack_exact() ){
+			++npacks_exact_;
+			fill_result_rots( result_rots );
+			return score_;
+		}
+
+		if( opts_.pt_nreplicas > 1 ){
+			pack_replica_exchange();
+			fill_result_rots( result_rots );
+			return score_;
+		}
+
 		int const ntrials = opts_.pack_n_iters;
 		int const pack_iters = opts_.pack_iter_mult * rot_list_.size()+10;
 		global_best_score_ = 9e9;
 		for( int k = 0; k < ntrials; ++k ){
 			if( k > 0 ) assign_initial_rots();
 			score_ = compute_energy_full( current_rots_ );
+			init_twobody_sums( current_rots_ );
 			trial_best_score_ = score_;
 			trial_best_rots_ = current_rots_;
 			for( int i = 0; i < pack_iters; ++i ) random_substitution_test( 100.0  ); recover_trial_best();
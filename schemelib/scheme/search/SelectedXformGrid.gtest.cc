@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <scheme/search/SelectedXformGrid.hh>
+
+#include <random>
+
+namespace scheme { namespace search { namespace sxgtest {
+
+typedef Eigen::Transform<float,3,Eigen::AffineCompact> Xform;
+
+struct Selected {
+	Xform xform;
+	uint64_t result_num;
+	float cluster_score;
+};
+
+// same as riflib's, never less than the translation distance
+float xform_magnitude( Xform const & x, float rg ){
+	float err_trans2 = x.translation().squaredNorm();
+	float cos_theta = (x.rotation().trace()-1.0)/2.0;
+	float err_rot = std::sqrt( std::max( 0.0, 1.0 - cos_theta*cos_theta ) ) * rg;
+	if( cos_theta < 0 ) err_rot = rg;
+	return std::sqrt( err_trans2 + err_rot*err_rot );
+}
+
+std::vector<Xform> random_xforms( int n, float rot_sd, float trans_sd, std::mt19937 & rng ){
+	std::normal_distribution<float> rnorm;
+	std::vector<Xform> xs( n );
+	for( Xform & x : xs ){
+		Eigen::Vector3f axis( rnorm(rng), rnorm(rng), rnorm(rng) );
+		x = Xform( Eigen::AngleAxisf( rnorm(rng) * rot_sd, axis.normalized() ) );
+		x.translation() = trans_sd * Eigen::Vector3f( rnorm(rng), rnorm(rng), rnorm(rng) );
+	}
+	return xs;
+}
+
+// the redundancy filter as CompileAndFilterResultsTask ran it before the grid: closest of
+// all selected gets the cluster count, anything farther than mag from all is selected
+void
+linear_scan_filter( std::vector<Xform> const & xs, float mag, float rg, std::vector<Selected> & selected ){
+	for( Xform const & x : xs ){
+		Xform const xinv = x.inverse();
+		float mindiff = 9e9;
+		Selected * closest = nullptr;
+		for( Selected & s : selected ){
+			float const diff = xform_magnitude( xinv * s.xform, rg );
+			if( diff < mindiff ){ mindiff = diff; closest = &s; }
+		}
+		if( mindiff < mag ) closest->cluster_score += 1;
+		if( mindiff > mag ) selected.push_back( Selected{ x, selected.size(), 0.0f } );
+	}
+}
+
+// the same filter through the grid, locked as the threaded task does
+template< class Counter >
+bool
+grid_filter_one( Xform const & x, float mag, float rg, SelectedXformGrid<Selected> & grid, Counter & nselected ){
+	std::vector<int> stripes;
+	grid.lock_near( x.translation(), stripes );
+	Xform const xinv = x.inverse();
+	float mindiff = 9e9;
+	Selected * closest = nullptr;
+	grid.for_each_near( x.translation(), [&]( Selected & s ){
+		float const diff = xform_magnitude( xinv * s.xform, rg );
+		if( diff < mindiff ){ mindiff = diff; closest = &s; }
+	});
+	if( mindiff < mag ) closest->cluster_score += 1;
+	bool const select = mindiff > mag;
+	if( select ) grid.insert( Selected{ x, (uint64_t)nselected++, 0.0f } );
+	grid.unlock( stripes );
+	return select;
+}
+
+TEST( SelectedXformGrid, matches_linear_scan ){
+	std::mt19937 rng(0);
+	float const rg = 3.0;
+	// small mag clamps the cell size to 1, wide spread makes bucket collisions
+	for( float mag : { 0.5f, 1.5f, 4.0f } ){
+	for( float trans_sd : { 4.0f, 200.0f } ){
+		std::vector<Xform> xs = random_xforms( 2000, 0.3, trans_sd, rng );
+
+		std::vector<Selected> ref;
+		linear_scan_filter( xs, mag, rg, ref );
+
+		SelectedXformGrid<Selected> grid( mag );
+		uint64_t nselected = 0;
+		for( Xform const & x : xs ) grid_filter_one( x, mag, rg, grid, nselected );
+
+		ASSERT_EQ( grid.size(), ref.size() );
+		ASSERT_EQ( nselected, ref.size() );
+		std::vector<Selected const *> got( ref.size(), nullptr );
+		grid.for_each( [&]( Selected const & s ){ got.at( s.result_num ) = &s; } );
+		for( size_t i = 0; i < ref.size(); ++i ){
+			ASSERT_TRUE( got[i] );
+			ASSERT_TRUE( got[i]->xform.isApprox( ref[i].xform ) );
+			ASSERT_EQ( got[i]->cluster_score, ref[i].cluster_score );
+		}
+	}}
+}
+
+TEST( SelectedXformGrid, threaded_selection_is_nonredundant_and_complete ){
+	std::mt19937 rng(1);
+	float const rg = 3.0, mag = 1.5;
+	std::vector<Xform> xs = random_xforms( 5000, 0.3, 4.0, rng );
+
+	SelectedXformGrid<Selected> grid( mag );
+	std::atomic<uint64_t> nselected(0);
+	#ifdef USE_OPENMP
+	#pragma omp parallel for schedule(dynamic,8)
+	#endif
+	for( int i = 0; i < (int)xs.size(); ++i ) grid_filter_one( xs[i], mag, rg, grid, nselected );
+
+	std::vector<Xform> sel;
+	float nclustered = 0;
+	grid.for_each( [&]( Selected const & s ){ sel.push_back( s.xform ); nclustered += s.cluster_score; } );
+	ASSERT_EQ( sel.size(), nselected );
+
+	// no two selected within mag, as the search and insert share the locks
+	for( size_t i = 0; i < sel.size(); ++i ){
+		Xform const inv = sel[i].inverse();
+		for( size_t j = 0; j < i; ++j ) ASSERT_GT( xform_magnitude( inv * sel[j], rg ), mag );
+	}
+	// everything not selected is within mag of something selected, each counted once
+	for( Xform const & x : xs ){
+		Xform const inv = x.inverse();
+		float mindiff = 9e9;
+		for( Xform const & s : sel ) mindiff = std::min( mindiff, xform_magnitude( inv * s, rg ) );
+		ASSERT_LE( mindiff, mag );
+	}
+	ASSERT_EQ( nclustered, xs.size() - sel.size() );
+}
+
+}}}
@@ -0,0 +1,117 @@
+#ifndef INCLUDED_search_SelectedXformGrid_HH
+#define INCLUDED_search_SelectedXformGrid_HH
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace scheme { namespace search {
+
+///@brief selected xforms binned by translation, for redundancy filtering of results
+///@detail an xform distance that is never less than the translation distance only needs
+///        the 27 cells around a position when cells are at least the filter radius wide.
+///        buckets are guarded by striped locks, so threads only wait on each other for
+///        nearby positions. Selected needs an EigenXform member xform
+template< class Selected >
+struct SelectedXformGrid {
+	static int const NBUCKET = 1024;
+	static int const NSTRIPE = 64;
+
+	SelectedXformGrid( float filter_radius )
+	  : cell_size_( std::max( filter_radius, 1.0f ) ), size_(0), buckets_(NBUCKET) {
+		#ifdef USE_OPENMP
+		for( int i = 0; i < NSTRIPE; ++i ) omp_init_lock( &stripe_locks_[i] );
+		#endif
+	}
+	~SelectedXformGrid() {
+		#ifdef USE_OPENMP
+		for( int i = 0; i < NSTRIPE; ++i ) omp_destroy_lock( &stripe_locks_[i] );
+		#endif
+	}
+	SelectedXformGrid( SelectedXformGrid const & ) = delete;
+	SelectedXformGrid & operator=( SelectedXformGrid const & ) = delete;
+
+	int64_t size() const { return size_; }
+
+	// lock every bucket near p, in stripe order so threads can't deadlock
+	void lock_near( Eigen::Vector3f const & p, std::vector<int> & stripes ) {
+		stripes.clear();
+		for_each_bucket_near( p, [&]( int b ){ stripes.push_back( b % NSTRIPE ); } );
+		std::sort( stripes.begin(), stripes.end() );
+		stripes.erase( std::unique( stripes.begin(), stripes.end() ), stripes.end() );
+		#ifdef USE_OPENMP
+		for( int i : stripes ) omp_set_lock( &stripe_locks_[i] );
+		#endif
+	}
+	void unlock( std::vector<int> const & stripes ) {
+		#ifdef USE_OPENMP
+		for( int i : stripes ) omp_unset_lock( &stripe_locks_[i] );
+		#endif
+	}
+
+	// calls f on every selected xform that may be within the filter radius of p, must hold lock_near( p )
+	template< class F >
+	void for_each_near( Eigen::Vector3f const & p, F f ) {
+		for_each_bucket_near( p, [&]( int b ){
+			for( Selected & s : buckets_[b] ) f( s );
+		});
+	}
+
+	// must hold lock_near( s.xform.translation() )
+	void insert( Selected const & s ) {
+		buckets_[ bucket( cell( s.xform.translation() ) ) ].push_back( s );
+		++size_;
+	}
+
+	// not thread safe
+	template< class F >
+	void for_each( F f ) const {
+		for( auto const & b : buckets_ ) for( Selected const & s : b ) f( s );
+	}
+
+private:
+	Eigen::Vector3i cell( Eigen::Vector3f const & p ) const {
+		return Eigen::Vector3i(
+			(int)std::floor( p[0] / cell_size_ ),
+			(int)std::floor( p[1] / cell_size_ ),
+			(int)std::floor( p[2] / cell_size_ ) );
+	}
+	// cells that collide only cost an extra exact check
+	static int bucket( Eigen::Vector3i const & c ) {
+		uint64_t h = (uint64_t)c[0] * 73856093 ^ (uint64_t)c[1] * 19349663 ^ (uint64_t)c[2] * 83492791;
+		return (int)( h % NBUCKET );
+	}
+	template< class F >
+	void for_each_bucket_near( Eigen::Vector3f const & p, F f ) const {
+		Eigen::Vector3i const c = cell( p );
+		int seen[27];
+		int nseen = 0;
+		for( int dx = -1; dx <= 1; ++dx )
+		for( int dy = -1; dy <= 1; ++dy )
+		for( int dz = -1; dz <= 1; ++dz ){
+			int const b = bucket( c + Eigen::Vector3i( dx, dy, dz ) );
+			if( std::find( seen, seen+nseen, b ) != seen+nseen ) continue;
+			seen[nseen++] = b;
+			f( b );
+		}
+	}
+
+	float cell_size_;
+	std::atomic<int64_t> size_;
+	std::vector< std::vector<Selected> > buckets_;
+	#ifdef USE_OPENMP
+	omp_lock_t stripe_locks_[NSTRIPE];
+	#endif
+};
+
+}}
+
+#endif
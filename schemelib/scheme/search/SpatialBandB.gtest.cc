@@ -4,6 +4,9 @@
 
 #include <scheme/actor/BackboneActor.hh>
 #include <scheme/kinematics/Scene.hh>
+#include <scheme/nest/NEST.hh>
+#include <scheme/nest/pmap/ScaleMap.hh>
+#include <scheme/numeric/X1dim.hh>
 #include <scheme/objective/ObjectiveFunction.hh>
 
 #include <Eigen/Geometry>
@@ -138,4 +141,75 @@ TEST( SpatialBandB, test_test_utils ){
 
 }
 
+struct TestScene1D : public kinematics::SceneBase<numeric::X1dim,uint64_t> {
+	TestScene1D(){
+		this->positions_.push_back( numeric::X1dim(0) );
+		this->update_symmetry( 1 );
+	}
+	virtual shared_ptr<kinematics::SceneBase<numeric::X1dim,uint64_t> > clone_deep() const {
+		return make_shared<TestScene1D>(*this);
+	}
+};
+
+// bumpy function on [0,1] with slope at most lipschitz, minus the most it can drop within radius
+struct LipschitzObjective1D {
+	double radius_;
+	static double lipschitz() { return 35.0; }
+	static double f( double x ){ return std::sin( 30.0*x ) + 0.5*std::cos( 6.0*x ) - x; }
+	LipschitzObjective1D( double radius ) : radius_(radius) {}
+	float operator()( TestScene1D const & s ) const {
+		return f( s.position(0).val_ ) - lipschitz()*radius_;
+	}
+};
+
+TEST( SpatialBandB, exact_top_k_1D ){
+	typedef nest::NEST<1,numeric::X1dim> Nest;
+	typedef kinematics::NestDirector<Nest,uint64_t> Director;
+	typedef BoundingObjectiveFunction<TestScene1D,LipschitzObjective1D> Bound;
+	int const max_resl = 12;
+
+	shared_ptr<Director> director = make_shared<Director>(0);
+	shared_ptr<Bound> bound = make_shared<Bound>();
+	SpatialBandB<numeric::X1dim> bnb;
+	for( int r = 0; r < max_resl; ++r ){
+		double rad = director->nest().bin_circumradius(r);
+		bound->add_objective( rad, LipschitzObjective1D(rad) );
+		bnb.resl_radii_.push_back( rad );
+	}
+	bound->add_objective( 0, LipschitzObjective1D(0) );
+	bnb.resl_radii_.push_back( 0 );
+	bnb.bounding_func_ = bound;
+	bnb.director_ = director;
+	bnb.scene_ = make_shared<TestScene1D>();
+	bnb.max_resl_ = max_resl;
+	bnb.batch_size_ = 16;
+
+	// brute force over the leaves
+	std::vector<float> ref;
+	TestScene1D scene;
+	for( uint64_t i = 0; i < director->nest().size(max_resl); ++i ){
+		director->set_scene( i, max_resl, scene );
+		ref.push_back( LipschitzObjective1D(0)(scene) );
+	}
+	std::sort( ref.begin(), ref.end() );
+
+	for( size_t k : { 1, 10, 100 } ){
+		bnb.top_k_ = k;
+		shared_ptr< SpatialBandB<numeric::X1dim>::Result > result = bnb.search();
+		ASSERT_EQ( k, result->results.size() );
+		for( size_t i = 0; i < k; ++i ){
+			ASSERT_FLOAT_EQ( ref[i], result->results[i].first );
+			director->set_scene( result->results[i].second, max_resl, scene );
+			ASSERT_FLOAT_EQ( ref[i], LipschitzObjective1D(0)(scene) );
+		}
+		// bounding should have skipped most of the tree
+		ASSERT_LT( result->nbound, director->nest().size(max_resl) );
+	}
+
+	// score_cut_ limits the results
+	bnb.top_k_ = 100;
+	bnb.score_cut_ = ref[5];
+	ASSERT_EQ( 5, bnb.search()->results.size() );
+}
+
 }}}
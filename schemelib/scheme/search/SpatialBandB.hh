@@ -1,44 +1,87 @@
+#ifndef INCLUDED_search_SpatialBandB_HH
+#define INCLUDED_search_SpatialBandB_HH
 
 #include <scheme/kinematics/Director.hh>
+#include <scheme/util/TopK.hh>
+#include <scheme/util/assert.hh>
 
+#include <algorithm>
+#include <limits>
 #include <list>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace scheme { namespace search {
 
-template< class Xform, class Index >
+///@brief lower bound on the objective over all scenes within bounding_radius of scene
+///@note must be admissible: never greater than the score of any scene in the cell, or
+///      SpatialBandB can prune away true top-K results
+template< class Xform, class Index, class Float = float >
 struct BoundingFunction {
-	typedef typename Xform::Scalar Float;
-	virtual void set_resolution() = 0;
-	virtual Float evaluate( kinematics::SceneBase<Xform,Index> const & scene ) const = 0;
+	virtual ~BoundingFunction(){}
+	virtual Float bound( kinematics::SceneBase<Xform,Index> const & scene, Float bounding_radius ) const = 0;
 };
 
-
-template< class Scene, class Objective >
+namespace impl {
+	template< class Float, class R >
+	typename std::enable_if< std::is_arithmetic<R>::value, Float >::type
+	bound_score( R const & r ){ return r; }
+	template< class Float, class R >
+	typename std::enable_if< !std::is_arithmetic<R>::value, Float >::type
+	bound_score( R const & r ){ return r.sum(); }
+}
+
+///@brief BoundingFunction from a list of objectives, each valid up to a bounding radius
+///@detail bound(scene,r) uses the objective with the smallest radius >= r, which is
+///        usually the most precise. an objective added with radius 0 is the exact score
+template< class Scene, class Objective, class Float = float >
 struct BoundingObjectiveFunction
- : public BoundingFunction< typename Scene::Position, typename Scene::Index >
+ : public BoundingFunction< typename Scene::Position, typename Scene::Index, Float >
 {
-	typedef std::list< std::pair< float, Objective > > ObjectiveList;
-	ObjectiveList objectives_;
-	Objective * active_objective_;
-
-	void add_objective( float bounding_radius, Objective const & objective ){
-		typename ObjectiveList::iterator i;
-		for( i = objectives_.begin(); i != objectives_.end(); ++i ){
-			if( bounding_radius > i->first ){
-				if( i != objectives_.begin() ) --i;
-				break;
+	typedef kinematics::SceneBase< typename Scene::Position, typename Scene::Index > SceneBase;
+	typedef std::list< std::pair< Float, Objective > > ObjectiveList;
+	ObjectiveList objectives_; // sorted by bounding radius, smallest first
+
+	void add_objective( Float bounding_radius, Objective const & objective ){
+		typename ObjectiveList::iterator i = objectives_.begin();
+		while( i != objectives_.end() && i->first <= bounding_radius ) ++i;
+		objectives_.insert( i, std::make_pair(bounding_radius,objective) );
+	}
+
+	// no objective covers this radius: bound nothing
+	virtual Float bound( SceneBase const & scene, Float bounding_radius ) const override {
+		for( auto const & ro : objectives_ ){
+			if( ro.first >= bounding_radius ){
+				return impl::bound_score<Float>( ro.second( static_cast<Scene const &>(scene) ) );
 			}
 		}
-		objectives_.insert( i, std::make_pair(bounding_radius,objective) );
+		return -std::numeric_limits<Float>::infinity();
 	}
 };
 
 
 template< class BigIndex, class Float = float >
 struct SpatialBandBResult {
-	std::vector< std::pair< float, BigIndex > > results;
+	std::vector< std::pair< Float, BigIndex > > results; // best (lowest) first
+	uint64_t nbound = 0;     // cells bounded, leaves included
+	uint64_t nexpanded = 0;  // cells whose children were bounded
+	uint64_t npruned = 0;    // cells dropped because bound >= the K'th best leaf or score_cut_
 };
 
+///@brief best-first branch and bound over the nest hierarchy of a Director
+///@detail cells are expanded in order of their bound. a cell at resl r is bounded with
+///        bounding_func_->bound( scene at cell center, resl_radii_[r] ), and leaves at
+///        max_resl_ are scored with resl_radii_[max_resl_], usually 0. once K leaves are
+///        known, cells bounded no better than the K'th are never expanded, so with an
+///        admissible bound the result is the exact top K leaves (by score, ties aside).
+///        children of parent p at resl r are p*B+j, B = size(r+1)/size(r), as in the
+///        NEST indexing. up to batch_size_ cells are popped at a time and their children
+///        are bounded in parallel, each thread on its own clone of scene_
 template<
 	class _Xform,
 	class _BigIndex = uint64_t,
@@ -48,26 +91,130 @@ struct SpatialBandB {
 	typedef _Xform Xform;
 	typedef _BigIndex BigIndex;
 	typedef _Index Index;
+	typedef float Float;
 	typedef kinematics::SceneBase<Xform,Index> Scene;
 	typedef scheme::shared_ptr< Scene > SceneP;
-	typedef scheme::shared_ptr< BoundingFunction<Xform,Index> > BoundP;
-	typedef scheme::shared_ptr< kinematics::Director<Xform,Index,Index> > DirectorP;
-	typedef SpatialBandBResult< BigIndex, float > Result;
+	typedef scheme::shared_ptr< BoundingFunction<Xform,Index,Float> > BoundP;
+	typedef scheme::shared_ptr< kinematics::Director<Xform,BigIndex,Index> > DirectorP;
+	typedef SpatialBandBResult< BigIndex, Float > Result;
 	typedef scheme::shared_ptr< Result > ResultP;
 
 	BoundP bounding_func_;
 	SceneP scene_;
 	DirectorP director_;
+	std::vector<Float> resl_radii_; // bounding radius of a cell at each resl
+	int max_resl_;
+	size_t top_k_;
+	Float score_cut_; // leaves must score below this
+	size_t batch_size_;
 
-
-	SpatialBandB(){}
+	SpatialBandB()
+		: max_resl_(0), top_k_(1), score_cut_( std::numeric_limits<Float>::max() ), batch_size_(1024) {}
 
 	ResultP search(){
+		ALWAYS_ASSERT( bounding_func_ && scene_ && director_ );
+		ALWAYS_ASSERT( max_resl_ >= 0 && (int)resl_radii_.size() > max_resl_ );
 		ResultP result = ResultP( new Result );
 
+		int nthread = 1;
+		#ifdef USE_OPENMP
+			nthread = omp_get_max_threads();
+		#endif
+		std::vector<SceneP> scenes( nthread );
+		for( auto & s : scenes ) s = scene_->clone_deep();
+
+		std::vector<uint64_t> nest_sizes( max_resl_+1 );
+		for( int r = 0; r <= max_resl_; ++r ) nest_sizes[r] = kinematics::get_nest_index( director_->size( r, BigIndex() ) );
+
+		util::BoundedTopK< Leaf, LeafLess > best( top_k_ );
+		std::priority_queue< Cell, std::vector<Cell>, CellLess > queue;
+
+		auto threshold = [&](){
+			return best.full() ? std::min( score_cut_, best.worst().first ) : score_cut_;
+		};
+
+		// bound all children of each parent at resl, on all threads. no parents means resl 0
+		std::vector< std::vector<Cell> > thread_cells( nthread );
+		auto bound_cells = [&]( std::vector<Cell> const & parents, int resl, uint64_t nchild ){
+			Float const radius = resl_radii_[resl];
+			int64_t const ntot = std::max<size_t>( 1, parents.size() ) * nchild;
+			#ifdef USE_OPENMP
+			#pragma omp parallel for schedule(dynamic,64)
+			#endif
+			for( int64_t k = 0; k < ntot; ++k ){
+				int ithread = 0;
+				#ifdef USE_OPENMP
+					ithread = omp_get_thread_num();
+				#endif
+				Cell c;
+				c.resl = resl;
+				c.index = BigIndex();
+				uint64_t const parent = parents.empty() ? 0 : kinematics::get_nest_index( parents[k/nchild].index );
+				kinematics::set_nest_size( parent*nchild + k%nchild, c.index );
+				if( !director_->set_scene( c.index, resl, *scenes[ithread] ) ) continue;
+				c.bound = bounding_func_->bound( *scenes[ithread], radius );
+				thread_cells[ithread].push_back( c );
+			}
+			// queue and top K are only touched here, between parallel loops
+			for( auto & cells : thread_cells ){
+				result->nbound += cells.size();
+				for( Cell const & c : cells ){
+					if( resl == max_resl_ ){
+						if( c.bound < score_cut_ ) best.push( Leaf( c.bound, c.index ) );
+					} else if( c.bound < threshold() ){
+						queue.push( c );
+					} else {
+						++result->npruned;
+					}
+				}
+				cells.clear();
+			}
+		};
+
+		bound_cells( std::vector<Cell>(), 0, nest_sizes[0] );
+
+		std::vector<Cell> batch;
+		while( !queue.empty() ){
+			// queue is ordered by bound, so once the best is pruned all are
+			if( queue.top().bound >= threshold() ){
+				result->npruned += queue.size();
+				break;
+			}
+			// pop a batch at one resl so all parents share a branching factor
+			int const resl = queue.top().resl;
+			batch.clear();
+			while( !queue.empty() && batch.size() < batch_size_ && queue.top().resl == resl
+			       && queue.top().bound < threshold() )
+			{
+				batch.push_back( queue.top() );
+				queue.pop();
+			}
+			result->nexpanded += batch.size();
+			bound_cells( batch, resl+1, nest_sizes[resl+1] / nest_sizes[resl] );
+		}
+
+		std::vector<Leaf> sorted = best.take_sorted();
+		result->results.assign( sorted.begin(), sorted.end() );
 		return result;
 	}
 
+private:
+	struct Cell {
+		Float bound;
+		BigIndex index;
+		int resl;
+	};
+	// priority_queue pops the largest, so this puts the lowest bound on top
+	struct CellLess {
+		bool operator()( Cell const & a, Cell const & b ) const { return a.bound > b.bound; }
+	};
+	typedef std::pair< Float, BigIndex > Leaf;
+	struct LeafLess {
+		bool operator()( Leaf const & a, Leaf const & b ) const { return a.first < b.first; }
+	};
+
 };
 
 }}
+
+#endif
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "scheme/util/StealingChunks.hh"
+
+#include <thread>
+#include <vector>
+
+namespace scheme {
+namespace util {
+
+TEST( StealingChunks, covers_all_once ){
+	for( int nthreads : { 1, 3, 8 } ){
+		uint64_t const n = 10007;
+		StealingChunks chunks( n, 16, nthreads );
+		std::vector< std::atomic<int> > hits( n );
+		for( auto & h : hits ) h = 0;
+		std::vector< std::thread > threads;
+		for( int t = 0; t < nthreads; ++t ){
+			threads.emplace_back( [&,t](){
+				uint64_t lb, ub;
+				while( chunks.next( t, lb, ub ) ){
+					for( uint64_t i = lb; i < ub; ++i ) ++hits[i];
+				}
+			});
+		}
+		for( auto & th : threads ) th.join();
+		for( uint64_t i = 0; i < n; ++i ) ASSERT_EQ( hits[i], 1 );
+	}
+}
+
+}
+}
@@ -0,0 +1,81 @@
+#ifndef INCLUDED_util_StealingChunks_HH
+#define INCLUDED_util_StealingChunks_HH
+
+#include <scheme/util/assert.hh>
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace scheme {
+namespace util {
+
+// splits [0,n) into chunks for a parallel loop. each thread starts on its own contiguous
+// share and takes chunks off the front of it; a thread that runs out takes chunks off the
+// back of another thread's share. unlike schedule(dynamic), a thread mostly walks
+// consecutive chunks, so sorted input stays coherent per thread
+struct StealingChunks {
+
+	StealingChunks( uint64_t n, uint64_t chunk, int nthreads )
+		: n_(n), chunk_( std::max<uint64_t>(1,chunk) ), nthreads_( std::max(1,nthreads) ), shares_( new Share[nthreads_] )
+	{
+		uint64_t const nchunks = ( n_ + chunk_ - 1 ) / chunk_;
+		ALWAYS_ASSERT( nchunks < ( uint64_t(1) << 32 ) );
+		for( int i = 0; i < nthreads_; ++i ){
+			uint64_t const lb = nchunks * i / nthreads_, ub = nchunks * ( i + 1 ) / nthreads_;
+			shares_[i].range.store( pack( lb, ub ) );
+		}
+	}
+
+	// [begin,end) of the next chunk for ithread, false once all chunks are taken
+	bool next( int ithread, uint64_t & begin, uint64_t & end ){
+		uint64_t ichunk;
+		bool got = take_front( ithread % nthreads_, ichunk );
+		for( int k = 1; !got && k < nthreads_; ++k ){
+			got = take_back( ( ithread + k ) % nthreads_, ichunk );
+		}
+		if( !got ) return false;
+		begin = ichunk * chunk_;
+		end = std::min( n_, begin + chunk_ );
+		return true;
+	}
+
+private:
+	// front and back chunk of a share in one word so owner and thieves can't both take the last one
+	struct alignas(64) Share { std::atomic<uint64_t> range; };
+
+	static uint64_t pack( uint64_t front, uint64_t back ) { return front << 32 | back; }
+	static uint64_t front( uint64_t r ) { return r >> 32; }
+	static uint64_t back( uint64_t r ) { return r & 0xffffffffu; }
+
+	bool take_front( int i, uint64_t & ichunk ){
+		uint64_t r = shares_[i].range.load();
+		while( front(r) < back(r) ){
+			if( shares_[i].range.compare_exchange_weak( r, pack( front(r)+1, back(r) ) ) ){
+				ichunk = front(r);
+				return true;
+			}
+		}
+		return false;
+	}
+	bool take_back( int i, uint64_t & ichunk ){
+		uint64_t r = shares_[i].range.load();
+		while( front(r) < back(r) ){
+			if( shares_[i].range.compare_exchange_weak( r, pack( front(r), back(r)-1 ) ) ){
+				ichunk = back(r)-1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint64_t n_, chunk_;
+	int nthreads_;
+	std::unique_ptr<Share[]> shares_;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "scheme/util/TopK.hh"
+
+#include <random>
+
+namespace scheme {
+namespace util {
+
+TEST( TopK, matches_sort ){
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif;
+	for( size_t k : { 0, 1, 7, 100, 5000 } ){
+		std::vector<float> vals( 1000 );
+		for( float & v : vals ) v = runif(rng);
+
+		// split across "threads" then merge
+		std::vector< BoundedTopK<float> > per_thread( 4, BoundedTopK<float>(k) );
+		for( size_t i = 0; i < vals.size(); ++i ) per_thread[i%4].push( vals[i] );
+		std::vector<float> top = merge_top_k( per_thread ).take_sorted();
+
+		std::sort( vals.begin(), vals.end() );
+		vals.resize( std::min( k, vals.size() ) );
+		ASSERT_EQ( top.size(), vals.size() );
+		for( size_t i = 0; i < vals.size(); ++i ) ASSERT_EQ( top[i], vals[i] );
+	}
+}
+
+TEST( TopK, accepts ){
+	BoundedTopK<int> top(2);
+	ASSERT_TRUE( top.push(5) );
+	ASSERT_TRUE( top.push(3) );
+	ASSERT_EQ( top.worst(), 5 );
+	ASSERT_FALSE( top.accepts(5) );
+	ASSERT_FALSE( top.push(6) );
+	ASSERT_TRUE( top.accepts(4) );
+	ASSERT_TRUE( top.push(1) );
+	ASSERT_EQ( top.worst(), 3 );
+}
+
+}
+}
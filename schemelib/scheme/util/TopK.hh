@@ -0,0 +1,91 @@
+#ifndef INCLUDED_util_TopK_HH
+#define INCLUDED_util_TopK_HH
+
+#include <scheme/util/assert.hh>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace scheme {
+namespace util {
+
+// keeps the k smallest values (by Less) pushed into it, as a max-heap so the
+// current worst kept value is always front(). push is O(log k). meant to be used
+// one per thread and merged at the end
+template< class T, class Less=std::less<T> >
+struct BoundedTopK {
+	typedef BoundedTopK<T,Less> THIS;
+
+	BoundedTopK( size_t k=0, Less less=Less() ) : k_(k), less_(less) {}
+
+	size_t capacity() const { return k_; }
+	size_t size() const { return heap_.size(); }
+	bool empty() const { return heap_.empty(); }
+	bool full() const { return heap_.size() >= k_; }
+
+	// worst value kept, only meaningful if !empty()
+	T const & worst() const { return heap_.front(); }
+
+	// true if push(t) would keep t
+	bool accepts( T const & t ) const {
+		return !full() || ( k_ > 0 && less_( t, heap_.front() ) );
+	}
+
+	bool push( T const & t ){
+		if( !full() ){
+			heap_.push_back( t );
+			std::push_heap( heap_.begin(), heap_.end(), less_ );
+			return true;
+		}
+		if( k_ == 0 || !less_( t, heap_.front() ) ) return false;
+		std::pop_heap( heap_.begin(), heap_.end(), less_ );
+		heap_.back() = t;
+		std::push_heap( heap_.begin(), heap_.end(), less_ );
+		return true;
+	}
+
+	void merge( THIS const & other ){
+		for( T const & t : other.heap_ ) push( t );
+	}
+
+	void clear() { heap_.clear(); }
+
+	// kept values in heap order, not sorted
+	std::vector<T> const & values() const { return heap_; }
+
+	// moves the kept values out, best first, leaving this empty
+	std::vector<T> take_sorted(){
+		std::sort_heap( heap_.begin(), heap_.end(), less_ );
+		std::vector<T> out;
+		out.swap( heap_ );
+		return out;
+	}
+
+private:
+	size_t k_;
+	Less less_;
+	std::vector<T> heap_;
+};
+
+// merge per-thread selections into the first one
+template< class T, class Less >
+BoundedTopK<T,Less> &
+merge_top_k( std::vector< BoundedTopK<T,Less> > & per_thread ){
+	ALWAYS_ASSERT( per_thread.size() > 0 );
+	// start from the largest to do the fewest pushes
+	size_t ibig = 0;
+	for( size_t i = 1; i < per_thread.size(); ++i )
+		if( per_thread[i].size() > per_thread[ibig].size() ) ibig = i;
+	std::swap( per_thread[0], per_thread[ibig] );
+	for( size_t i = 1; i < per_thread.size(); ++i ){
+		per_thread[0].merge( per_thread[i] );
+		per_thread[i].clear();
+	}
+	return per_thread[0];
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include "scheme/util/container/SoAVector.hh"
+#include "scheme/kinematics/Scene.hh"
+#include "scheme/objective/ObjectiveFunction.hh"
+#include "scheme/actor/Atom.hh"
+#include "scheme/util/Timer.hh"
+
+#include <Eigen/Geometry>
+
+#include <random>
+
+namespace scheme {
+namespace util {
+namespace container {
+namespace soa_vector_test {
+
+namespace m = boost::mpl;
+
+typedef Eigen::Vector3f Vec;
+typedef actor::SimpleAtom<Vec> Atom;
+
+struct Xform : Eigen::Transform<float,3,Eigen::AffineCompact> {
+	typedef Eigen::Transform<float,3,Eigen::AffineCompact> BASE;
+	Xform(){}
+	template<class T> Xform(T const & t) : BASE(t) {}
+};
+inline Xform inverse( Xform const & x ){ return x.inverse( Eigen::Isometry ); }
+
+struct ScoreAtomPair {
+	typedef double Result;
+	typedef std::pair<Atom,Atom> Interaction;
+	static std::string name(){ return "ScoreAtomPair"; }
+	template<class Config>
+	Result operator()( Atom const & a, Atom const & b, Config const & ) const {
+		return ( a.type() + 1 ) * ( a.position() - b.position() ).squaredNorm();
+	}
+	template<class Config>
+	Result operator()( Interaction const & i, Config const & c ) const { return (*this)( i.first, i.second, c ); }
+};
+
+Xform random_xform( std::mt19937 & rng ){
+	std::normal_distribution<float> rnorm;
+	Xform x( Eigen::AngleAxisf( rnorm(rng), Vec( rnorm(rng), rnorm(rng), rnorm(rng) ).normalized() ) );
+	x.translation() = 3.0*Vec( rnorm(rng), rnorm(rng), rnorm(rng) );
+	return x;
+}
+
+TEST( SoAVector, transform_into ){
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(-10,10);
+	SoAVector<Atom> atoms;
+	for( int i = 0; i < 100; ++i ) atoms.push_back( Atom( Vec( runif(rng), runif(rng), runif(rng) ), i%7, i%5, i%11 ) );
+	ASSERT_EQ( 100, atoms.arrays().x.size() );
+	ASSERT_EQ( 3, atoms.arrays().type[10] );
+
+	Xform const x = random_xform( rng );
+	std::vector<Atom> moved;
+	atoms.transform_into( x, moved );
+	ASSERT_EQ( atoms.size(), moved.size() );
+	for( size_t i = 0; i < atoms.size(); ++i ){
+		ASSERT_EQ( Atom( atoms[i], x ), moved[i] );
+	}
+
+	// a reused buffer holding other actors is fully overwritten, and not reallocated
+	std::vector<Atom> reused( 150, Atom( Vec(0,0,0), 1, 2, 3 ) );
+	Atom const * data = reused.data();
+	atoms.transform_into( x, reused );
+	ASSERT_EQ( data, reused.data() );
+	ASSERT_EQ( moved, reused );
+
+	// moving in place needs a sync before the arrays are used
+	atoms.at(5).set_position( Vec(1,2,3) );
+	atoms.sync();
+	atoms.transform_into( x, moved );
+	ASSERT_EQ( Atom( atoms[5], x ), moved[5] );
+}
+
+TEST( SoAVector, scene_score_matches_vector ){
+	typedef kinematics::Scene< kinematics::impl::Conformation< m::vector< Atom > >, Xform, size_t > SceneVec;
+	typedef kinematics::Scene< kinematics::impl::Conformation< m::vector< SoAVector<Atom> > >, Xform, size_t > SceneSoA;
+	typedef objective::ObjectiveFunction< m::vector<ScoreAtomPair>, int > ObjFun;
+	ObjFun score;
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(-5,5);
+	SceneVec scene_vec(3);
+	SceneSoA scene_soa(3);
+	for( size_t ib = 0; ib < 3; ++ib ){
+		for( int i = 0; i < 20; ++i ){
+			Atom a( Vec( runif(rng), runif(rng), runif(rng) ), i%3 );
+			scene_vec.add_actor( ib, a );
+			scene_soa.add_actor( ib, a );
+		}
+		Xform x = random_xform( rng );
+		scene_vec.set_position( ib, x );
+		scene_soa.set_position( ib, x );
+	}
+	Xform const sym( Eigen::AngleAxisf( 2.0*M_PI/3.0, Vec(0,0,1) ) );
+	scene_vec.add_symframe( sym );
+	scene_vec.add_symframe( sym*sym );
+	scene_soa.add_symframe( sym );
+	scene_soa.add_symframe( sym*sym );
+
+	double const ref = score(scene_vec,0).sum();
+	ASSERT_GT( ref, 0 );
+	ASSERT_NEAR( 1.0, score(scene_soa,0).sum() / ref, 1e-5 );
+
+	std::vector<Atom> positioned;
+	scene_soa.get_actors_positioned( 4, positioned );
+	ASSERT_EQ( 20, positioned.size() );
+	for( size_t ia = 0; ia < positioned.size(); ++ia ){
+		ASSERT_TRUE( positioned[ia].position().isApprox( scene_vec.get_actor<Atom>(4,ia).position(), 1e-5 ) );
+	}
+}
+
+// the bulk path moves each side's actors once per body pair into a reused buffer, the
+// per-actor path builds one moved actor per interaction. both must score the same
+TEST( SoAVector, bulk_scene_score_matches_per_actor ){
+	typedef kinematics::Scene< kinematics::impl::Conformation< m::vector< Atom > >, Xform, size_t > SceneVec;
+	typedef kinematics::Scene< kinematics::impl::Conformation< m::vector< SoAVector<Atom> > >, Xform, size_t > SceneSoA;
+	typedef objective::ObjectiveFunction< m::vector<ScoreAtomPair>, int > ObjFun;
+	ObjFun score;
+
+	int NATOM = 100, NSCORE = 20;
+	#ifdef SCHEME_BENCHMARK
+	NSCORE = 5000;
+	#endif
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(-5,5);
+	SceneVec scene_vec(2);
+	SceneSoA scene_soa(2);
+	for( size_t ib = 0; ib < 2; ++ib ){
+		for( int i = 0; i < NATOM; ++i ){
+			Atom a( Vec( runif(rng), runif(rng), runif(rng) ), i%3 );
+			scene_vec.add_actor( ib, a );
+			scene_soa.add_actor( ib, a );
+		}
+	}
+	std::vector<Xform> positions;
+	for( int i = 0; i < NSCORE; ++i ) positions.push_back( random_xform( rng ) );
+
+	for( Xform const & x : positions ){
+		scene_vec.set_position( 1, x );
+		scene_soa.set_position( 1, x );
+		double const ref = score(scene_vec,0).sum();
+		ASSERT_NEAR( ref, score(scene_soa,0).sum(), 1e-5 * std::max( 1.0, std::abs(ref) ) );
+	}
+
+	#ifdef SCHEME_BENCHMARK
+	double sum = 0;
+	util::Timer<> t;
+	for( Xform const & x : positions ){ scene_vec.set_position( 1, x ); sum += score(scene_vec,0).sum(); }
+	double const tvec = t.elapsed();
+	util::Timer<> t2;
+	for( Xform const & x : positions ){ scene_soa.set_position( 1, x ); sum += score(scene_soa,0).sum(); }
+	double const tsoa = t2.elapsed();
+	std::cout << "scene score " << NATOM << "x" << NATOM << " atoms, per-actor " << tvec/NSCORE*1e6
+	          << "us, bulk " << tsoa/NSCORE*1e6 << "us, nonsense " << sum << std::endl;
+	#endif
+}
+
+}
+}
+}
+}
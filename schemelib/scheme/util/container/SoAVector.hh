@@ -0,0 +1,83 @@
+#ifndef INCLUDED_util_container_SoAVector_HH
+#define INCLUDED_util_container_SoAVector_HH
+
+#include "scheme/util/assert.hh"
+
+#include <boost/mpl/bool.hpp>
+
+#include <vector>
+
+namespace scheme {
+namespace util {
+namespace container {
+
+///@brief how SoAVector splits an Actor into contiguous arrays, specialize next to the Actor
+///@detail needs typedef Arrays, static push_back( Arrays &, Actor const & ), clear( Arrays & ),
+///        and transform( Arrays const &, Xform const & x, std::vector<Actor> & out ), which
+///        sets every field of each out[i] to those of Actor( actor i, x ), reading only Arrays.
+///        out is already sized, its old contents are overwritten
+template< class Actor >
+struct SoATraits;
+
+///@brief vector of actors that also keeps their coordinates (or stubs) in contiguous per-
+///       component arrays, so all actors of a body can be moved in one vectorizable loop.
+///       Scene uses transform_into for BulkTransform containers instead of one Actor(a,x)
+///       per interaction
+///@note use in place of the Actor in a Conformation's actor list. actors must not be edited
+///      in place through at() without calling sync(). the rifdock scenes don't use it
+template< class Actor >
+struct SoAVector {
+	typedef Actor value_type;
+	typedef SoATraits<Actor> Traits;
+	typedef typename std::vector<Actor>::const_iterator const_iterator;
+	typedef const_iterator iterator; // no mutable iteration, it would stale the arrays
+	typedef boost::mpl::true_ BulkTransform;
+
+	size_t size() const { return actors_.size(); }
+	bool empty() const { return actors_.empty(); }
+	const_iterator begin() const { return actors_.begin(); }
+	const_iterator end() const { return actors_.end(); }
+	Actor const & operator[]( size_t i ) const { return actors_[i]; }
+	Actor const & at( size_t i ) const { return actors_.at(i); }
+	Actor       & at( size_t i )       { return actors_.at(i); }
+	typename Traits::Arrays const & arrays() const { return arrays_; }
+
+	const_iterator insert( const_iterator pos, Actor const & a ){
+		ALWAYS_ASSERT_MSG( pos == actors_.end(), "SoAVector only appends" );
+		push_back( a );
+		return actors_.end() - 1;
+	}
+	void push_back( Actor const & a ){
+		actors_.push_back( a );
+		Traits::push_back( arrays_, a );
+	}
+	void reserve( size_t n ){ actors_.reserve( n ); }
+	void clear(){
+		actors_.clear();
+		Traits::clear( arrays_ );
+	}
+	void sync(){
+		Traits::clear( arrays_ );
+		for( Actor const & a : actors_ ) Traits::push_back( arrays_, a );
+	}
+
+	///@brief out[i] = Actor( (*this)[i], x ) for all i, computed from the arrays only. out is
+	///       resized, not reallocated if it has the capacity, so reuse it across calls
+	template< class Xform >
+	void transform_into( Xform const & x, std::vector<Actor> & out ) const {
+		out.resize( actors_.size() );
+		Traits::transform( arrays_, x, out );
+	}
+
+	bool operator==( SoAVector const & o ) const { return actors_ == o.actors_; }
+
+private:
+	std::vector<Actor> actors_;
+	typename Traits::Arrays arrays_;
+};
+
+}
+}
+}
+
+#endif
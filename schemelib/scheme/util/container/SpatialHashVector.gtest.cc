@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "scheme/util/container/SpatialHashVector.hh"
+#include "scheme/kinematics/Scene.hh"
+#include "scheme/objective/ObjectiveFunction.hh"
+#include "scheme/actor/Atom.hh"
+
+#include <random>
+#include <set>
+
+namespace scheme {
+namespace util {
+namespace container {
+namespace spatial_hash_test {
+
+typedef Eigen::Vector3f Vec;
+typedef actor::SimpleAtom<Vec> Atom;
+
+struct Xform : Eigen::Transform<float,3,Eigen::AffineCompact> {
+	typedef Eigen::Transform<float,3,Eigen::AffineCompact> BASE;
+	Xform(){}
+	template<class T> Xform(T const & t) : BASE(t) {}
+};
+inline Xform inverse( Xform const & x ){ return x.inverse( Eigen::Isometry ); }
+
+// counts atom pairs closer than 2.5
+struct ScoreContacts {
+	typedef double Result;
+	typedef std::pair<Atom,Atom> Interaction;
+	static std::string name(){ return "ScoreContacts"; }
+	static float interaction_cutoff(){ return 2.5; }
+	template<class Config>
+	Result operator()( Atom const & a, Atom const & b, Config const & ) const {
+		return ( a.position() - b.position() ).norm() <= interaction_cutoff() ? 1.0 : 0.0;
+	}
+	template<class Config>
+	Result operator()( Interaction const & i, Config const & c ) const { return (*this)( i.first, i.second, c ); }
+};
+
+typedef SpatialHashVector<Atom,ScoreContacts> HashedAtoms;
+
+Xform random_xform( std::mt19937 & rng ){
+	std::normal_distribution<float> rnorm;
+	Xform x( Eigen::AngleAxisf( rnorm(rng), Vec( rnorm(rng), rnorm(rng), rnorm(rng) ).normalized() ) );
+	x.translation() = 3.0*Vec( rnorm(rng), rnorm(rng), rnorm(rng) );
+	return x;
+}
+
+TEST( SpatialHashVector, matches_brute_force ){
+	typedef uint32_t Index;
+	typedef ContainerInteractions< Xform, std::vector<Atom>, HashedAtoms, Index > CI;
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> runif(-10,10);
+
+	std::vector<Atom> a;
+	HashedAtoms b;
+	for( int i = 0; i < 300; ++i ){
+		a.push_back( Atom( Vec( runif(rng), runif(rng), runif(rng) ) ) );
+		b.push_back( Atom( Vec( runif(rng), runif(rng), runif(rng) ) ) );
+	}
+	for( int itest = 0; itest < 10; ++itest ){
+		Xform rel = random_xform( rng ); // b frame to a frame
+		std::set< std::pair<Index,Index> > ref;
+		for( Index i = 0; i < a.size(); ++i )
+		for( Index j = 0; j < b.size(); ++j )
+			if( ( a[i].position() - rel*b[j].position() ).norm() <= 2.5 ) ref.insert( std::make_pair(i,j) );
+		CI::Range r;
+		CI::get_interaction_range( rel, a, b, r );
+		std::set< std::pair<Index,Index> > got( r.begin(), r.end() );
+		ASSERT_EQ( got.size(), r.size() );
+		ASSERT_EQ( ref, got );
+	}
+	b.rebin();
+	CI::Range r;
+	CI::get_interaction_range( Xform( Xform::Identity() ), a, b, r );
+	ASSERT_GT( r.size(), 0 );
+	b.clear();
+	CI::get_interaction_range( Xform( Xform::Identity() ), a, b, r );
+	ASSERT_EQ( r.size(), 0 );
+}
+
+TEST( SpatialHashVector, scene_score_matches_vector ){
+	typedef kinematics::Scene< kinematics::impl::Conformation< boost::mpl::vector< Atom > >, Xform > PlainScene;
+	typedef kinematics::Scene< kinematics::impl::Conformation< boost::mpl::vector< HashedAtoms > >, Xform > HashedScene;
+	typedef objective::ObjectiveFunction< boost::mpl::vector< ScoreContacts >, int > ObjFun;
+	ObjFun score;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> runif(-6,6);
+	PlainScene plain(2);
+	HashedScene hashed(2);
+	for( int ib = 0; ib < 2; ++ib ){
+		for( int i = 0; i < 200; ++i ){
+			Atom atom( Vec( runif(rng), runif(rng), runif(rng) ) );
+			plain.add_actor( ib, atom );
+			hashed.add_actor( ib, atom );
+		}
+	}
+	for( int itest = 0; itest < 10; ++itest ){
+		for( int ib = 0; ib < 2; ++ib ){
+			Xform x = random_xform( rng );
+			plain.set_position( ib, x );
+			hashed.set_position( ib, x );
+		}
+		double const s = score( plain ).sum();
+		ASSERT_GT( s, 0 );
+		ASSERT_EQ( s, score( hashed ).sum() );
+	}
+}
+
+}
+}
+}
+}
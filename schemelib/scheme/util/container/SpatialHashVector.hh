@@ -0,0 +1,135 @@
+#ifndef INCLUDED_util_container_SpatialHashVector_HH
+#define INCLUDED_util_container_SpatialHashVector_HH
+
+#include "scheme/util/container/ContainerInteractions.hh"
+#include "scheme/util/assert.hh"
+
+#include <Eigen/Geometry>
+
+#include <stdint.h>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace scheme {
+namespace util {
+namespace container {
+
+namespace impl {
+	template<class F>
+	Eigen::Matrix<F,3,1> spatial_hash_point( Eigen::Matrix<F,3,1> const & p ){ return p; }
+	template<class F, int Mode, int Options>
+	Eigen::Matrix<F,3,1> spatial_hash_point( Eigen::Transform<F,3,Mode,Options> const & x ){ return x.translation(); }
+}
+
+///@brief vector of positioned actors that also bins them on a uniform grid, so
+///       ContainerInteractions only yields pairs closer than the interaction cutoff
+///@tparam CutoffSource provides static interaction_cutoff(), distance beyond which every
+///        objective on this container scores a pair as 0; usually the objective itself
+///@note use in place of the Actor in a Conformation's actor list. actors must not be
+///      moved in place through at() without calling rebin()
+template< class Actor, class CutoffSource >
+struct SpatialHashVector {
+	typedef Actor value_type;
+	typedef typename std::vector<Actor>::const_iterator const_iterator;
+	typedef const_iterator iterator; // no mutable iteration, it would stale the bins
+	typedef decltype( impl::spatial_hash_point( std::declval<Actor>().position() ) ) Point;
+	typedef typename Point::Scalar Float;
+
+	static Float cutoff() { return CutoffSource::interaction_cutoff(); }
+
+	size_t size() const { return actors_.size(); }
+	bool empty() const { return actors_.empty(); }
+	const_iterator begin() const { return actors_.begin(); }
+	const_iterator end() const { return actors_.end(); }
+	Actor const & operator[]( size_t i ) const { return actors_[i]; }
+	Actor const & at( size_t i ) const { return actors_.at(i); }
+	Actor       & at( size_t i )       { return actors_.at(i); }
+
+	const_iterator insert( const_iterator pos, Actor const & a ){
+		ALWAYS_ASSERT_MSG( pos == actors_.end(), "SpatialHashVector only appends" );
+		push_back( a );
+		return actors_.end() - 1;
+	}
+	void push_back( Actor const & a ){
+		actors_.push_back( a );
+		bins_[ key( cell( impl::spatial_hash_point( a.position() ) ) ) ].push_back( (uint32_t)( actors_.size()-1 ) );
+	}
+	void clear(){
+		actors_.clear();
+		bins_.clear();
+	}
+	void rebin(){
+		std::vector<Actor> tmp;
+		tmp.swap( actors_ );
+		clear();
+		for( Actor const & a : tmp ) push_back( a );
+	}
+
+	bool operator==( SpatialHashVector const & o ) const { return actors_ == o.actors_; }
+
+	///@brief calls f(i) for each actor within cutoff() of p
+	template< class F >
+	void for_each_near( Point const & p, F const & f ) const {
+		Float const cut2 = cutoff()*cutoff();
+		Eigen::Vector3i const c = cell( p );
+		for( int dx = -1; dx <= 1; ++dx )
+		for( int dy = -1; dy <= 1; ++dy )
+		for( int dz = -1; dz <= 1; ++dz ){
+			auto const bin = bins_.find( key( c + Eigen::Vector3i(dx,dy,dz) ) );
+			if( bin == bins_.end() ) continue;
+			for( uint32_t i : bin->second ){
+				if( ( impl::spatial_hash_point( actors_[i].position() ) - p ).squaredNorm() <= cut2 ) f( i );
+			}
+		}
+	}
+
+private:
+	static Eigen::Vector3i cell( Point const & p ){
+		return Eigen::Vector3i(
+			(int)std::floor( p[0] / cutoff() ),
+			(int)std::floor( p[1] / cutoff() ),
+			(int)std::floor( p[2] / cutoff() ) );
+	}
+	// 21 bits per dimension, cells more than 2^20 from the origin alias, which only costs time
+	static uint64_t key( Eigen::Vector3i const & c ){
+		uint64_t const mask = ( uint64_t(1) << 21 ) - 1;
+		return ( (uint64_t)c[0] & mask ) << 42 | ( (uint64_t)c[1] & mask ) << 21 | ( (uint64_t)c[2] & mask );
+	}
+
+	std::vector<Actor> actors_;
+	std::unordered_map< uint64_t, std::vector<uint32_t> > bins_;
+};
+
+///@brief ContainerInteractions for anything vs. a SpatialHashVector, only pairs within the
+///       cutoff. Xform maps container2's frame into container1's, as in Scene::visit
+template< class Xform, class Container1, class Actor2, class CutoffSource, class Index >
+struct ContainerInteractions< Xform, Container1, SpatialHashVector<Actor2,CutoffSource>, Index > {
+	typedef SpatialHashVector<Actor2,CutoffSource> Container2;
+	typedef std::vector< std::pair<Index,Index> > Range;
+	static
+	void
+	get_interaction_range(
+		Xform const & rel_pos,
+		Container1 const & c1,
+		Container2 const & c2,
+		Range & r
+	){
+		r.clear();
+		if( c1.size() == 0 || c2.size() == 0 ) return;
+		typedef typename Container2::Float Float;
+		typedef typename Xform::Scalar XFloat;
+		Xform const to2 = inverse( rel_pos );
+		for( Index i1 = 0; i1 < (Index)c1.size(); ++i1 ){
+			typename Container2::Point const p =
+				( to2 * impl::spatial_hash_point( c1[i1].position() ).template cast<XFloat>() ).template cast<Float>();
+			c2.for_each_near( p, [&r,i1]( uint32_t i2 ){ r.push_back( std::make_pair( i1, (Index)i2 ) ); } );
+		}
+	}
+};
+
+}
+}
+}
+
+#endif
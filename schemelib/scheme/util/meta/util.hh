@@ -141,6 +141,15 @@ struct has_const_member_fun_ ## MEMBER  {                                  \
     static const bool value = sizeof(Test<T>(0)) == sizeof(char);          \
     typedef boost::mpl::bool_<value> type;                                 \
 };
+#define SCHEME_HAS_CONST_MEMBER_FUNCTION_6(MEMBER)                         \
+template<typename T, class R, class A, class B, class C, class D, class E, class F> \
+struct has_const_member_fun_ ## MEMBER  {                                  \
+    template<typename U, R (U::*)(A,B,C,D,E,F) const> struct SFINAE {};    \
+    template<typename U> static char Test(SFINAE<U, &U::MEMBER>*);         \
+    template<typename U> static int Test(...);                             \
+    static const bool value = sizeof(Test<T>(0)) == sizeof(char);          \
+    typedef boost::mpl::bool_<value> type;                                 \
+};
 
 
 
@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include "scheme/util/radix_sort.hh"
+
+#include <random>
+
+namespace scheme {
+namespace util {
+
+TEST( radix_sort, matches_stable_sort ){
+	std::mt19937_64 rng(0);
+	for( int key_bits : { 0, 5, 8, 13, 40, 64 } ){
+		std::vector< std::pair<uint64_t,int> > v( 10000 );
+		uint64_t const mask = key_bits==64 ? ~uint64_t(0) : ( uint64_t(1) << key_bits ) - 1;
+		for( size_t i = 0; i < v.size(); ++i ) v[i] = std::make_pair( rng() & mask & 0xfffff00f, (int)i );
+		std::vector< std::pair<uint64_t,int> > ref = v;
+		std::stable_sort( ref.begin(), ref.end(),
+			[]( std::pair<uint64_t,int> const & a, std::pair<uint64_t,int> const & b ){ return a.first < b.first; } );
+		radix_sort_by_key( v, []( std::pair<uint64_t,int> const & p ){ return p.first; }, key_bits );
+		ASSERT_EQ( v, ref );
+	}
+}
+
+}
+}
@@ -0,0 +1,82 @@
+#ifndef INCLUDED_util_radix_sort_HH
+#define INCLUDED_util_radix_sort_HH
+
+#include <scheme/util/assert.hh>
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace scheme {
+namespace util {
+
+// stable LSD radix sort of v by key(v[i]), looking only at the low key_bits bits of the
+// uint64_t keys, 8 bits per pass. histograms and scatters run on all threads, each thread
+// owning one contiguous block so the result is the same for any thread count. needs a
+// scratch copy of v
+template< class T, class KeyFn >
+void radix_sort_by_key( std::vector<T> & v, KeyFn const & key, int key_bits ){
+	ALWAYS_ASSERT( 0 <= key_bits && key_bits <= 64 );
+	size_t const n = v.size();
+	if( n < 2 || key_bits == 0 ) return;
+	int const npass = ( key_bits + 7 ) / 8;
+
+	std::vector<uint64_t> keys( n ), keys_tmp( n );
+	std::vector<T> tmp( n );
+	#ifdef USE_OPENMP
+	#pragma omp parallel for schedule(static)
+	#endif
+	for( size_t i = 0; i < n; ++i ) keys[i] = key( v[i] );
+
+	std::vector< std::vector<size_t> > offsets;
+
+	for( int pass = 0; pass < npass; ++pass ){
+		int const shift = pass * 8;
+		#ifdef USE_OPENMP
+		#pragma omp parallel
+		#endif
+		{
+			int ithread = 0, nthread = 1;
+			#ifdef USE_OPENMP
+				ithread = omp_get_thread_num();
+				nthread = omp_get_num_threads();
+			#pragma omp single
+			#endif
+			offsets.assign( nthread, std::vector<size_t>( 256 ) );
+			size_t const lb = n * ithread / nthread, ub = n * ( ithread + 1 ) / nthread;
+			std::vector<size_t> & count = offsets[ithread];
+			for( size_t i = lb; i < ub; ++i ) ++count[ ( keys[i] >> shift ) & 255 ];
+			#ifdef USE_OPENMP
+			#pragma omp barrier
+			#pragma omp single
+			#endif
+			{
+				// bucket-major, thread-minor exclusive prefix sum keeps the sort stable
+				size_t sum = 0;
+				for( int b = 0; b < 256; ++b ){
+					for( size_t t = 0; t < offsets.size(); ++t ){
+						size_t c = offsets[t][b];
+						offsets[t][b] = sum;
+						sum += c;
+					}
+				}
+			}
+			for( size_t i = lb; i < ub; ++i ){
+				size_t const dst = count[ ( keys[i] >> shift ) & 255 ]++;
+				tmp[dst] = v[i];
+				keys_tmp[dst] = keys[i];
+			}
+		}
+		v.swap( tmp );
+		keys.swap( keys_tmp );
+	}
+}
+
+}
+}
+
+#endif